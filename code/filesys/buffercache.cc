@@ -0,0 +1,305 @@
+// buffercache.cc
+//	Routines to keep a cache of disk sectors, and to record and
+//	read back the sectors worth having in it at mount.  See
+//	buffercache.h.
+//
+//	The warm file holds WarmMagic, the number of sectors, then the
+//	sectors, most used first.  It only names sectors: their contents
+//	always come from the disk, so a stale warm file (after "-f", or
+//	after fsck repaired the volume) costs a few reads, and is never
+//	wrong.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "buffercache.h"
+#include "debug.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// BufferCache::BufferCache
+// 	Initialize an empty cache.
+//
+//	"size" -- how many sectors the cache holds
+//----------------------------------------------------------------------
+
+BufferCache::BufferCache(int size)
+{
+    ASSERT(size > 0);
+    this->size = size;
+    sectors = new int[size];
+    data = new char[size * SectorSize];
+    stamps = new int[size];
+    uses = new int[size];
+    warm = new bool[size];
+    next = new int[size];
+    for (int i = 0; i < size; i++)
+        {
+            sectors[i] = -1;
+            stamps[i] = -1;
+            uses[i] = 0;
+            warm[i] = FALSE;
+            next[i] = -1;
+        }
+    numBuckets = 2 * size;
+    buckets = new int[numBuckets];
+    for (int i = 0; i < numBuckets; i++)
+        buckets[i] = -1;
+    now = 0;
+    numWrites = numHits = numMisses = numPrefetched = numWarmHits = 0;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::~BufferCache
+//----------------------------------------------------------------------
+
+BufferCache::~BufferCache()
+{
+    delete [] sectors;
+    delete [] data;
+    delete [] stamps;
+    delete [] uses;
+    delete [] warm;
+    delete [] next;
+    delete [] buckets;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Find
+// 	Return the entry holding "sector", or -1 if it is not cached.
+//----------------------------------------------------------------------
+
+int
+BufferCache::Find(int sector)
+{
+    int i;
+
+    for (i = buckets[sector % numBuckets]; i >= 0; i = next[i])
+        {
+            if (sectors[i] == sector)
+                break;
+        }
+    return i;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Insert
+// 	Return an entry for "sector": the one holding it already, or
+//	else the least recently used one, taken from the sector it held.
+//----------------------------------------------------------------------
+
+int
+BufferCache::Insert(int sector)
+{
+    int victim = Find(sector);
+    int *link;
+
+    if (victim >= 0)
+        {
+            return victim;
+        }
+    victim = 0;
+    for (int i = 1; i < size; i++)
+        {
+            if (stamps[i] < stamps[victim])
+                victim = i;
+        }
+    if (sectors[victim] >= 0)  	// unhook it from its old chain
+        {
+            link = &buckets[sectors[victim] % numBuckets];
+            while (*link != victim)
+                link = &next[*link];
+            *link = next[victim];
+        }
+    sectors[victim] = sector;
+    uses[victim] = 0;
+    warm[victim] = FALSE;
+    next[victim] = buckets[sector % numBuckets];
+    buckets[sector % numBuckets] = victim;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Read
+// 	Copy "sector" out of the cache, if it is there.  Return TRUE if
+//	it was.
+//
+//	"sector" -- the sector wanted
+//	"data" -- where to put its contents
+//----------------------------------------------------------------------
+
+bool
+BufferCache::Read(int sector, char *data)
+{
+    int i = Find(sector);
+
+    if (i < 0)
+        {
+            numMisses++;
+            return FALSE;
+        }
+    bcopy(&this->data[i * SectorSize], data, SectorSize);
+    stamps[i] = now++;
+    uses[i]++;
+    if (warm[i])
+        {
+            numWarmHits++;
+            warm[i] = FALSE;
+        }
+    numHits++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Fill
+// 	Cache a sector that was just read from the disk.  A sector read
+//	at mount has not been asked for yet, so it has no uses; one read
+//	on a miss has one.
+//
+//	"sector" -- the sector read
+//	"data" -- its contents
+//	"prefetch" -- was it read in at mount?
+//----------------------------------------------------------------------
+
+void
+BufferCache::Fill(int sector, char *data, bool prefetch)
+{
+    int i = Insert(sector);
+
+    bcopy(data, &this->data[i * SectorSize], SectorSize);
+    stamps[i] = now++;
+    if (prefetch)
+        {
+            warm[i] = TRUE;
+            numPrefetched++;
+        }
+    else
+        {
+            uses[i]++;
+        }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Update
+// 	Keep the cached copy of a sector being written up to date.
+//	Writing does not count as a use, but keeps the sector in the
+//	cache, since it is likely to be read again.
+//
+//	"sector" -- the sector written
+//	"data" -- its new contents
+//----------------------------------------------------------------------
+
+void
+BufferCache::Update(int sector, char *data)
+{
+    int i = Insert(sector);
+
+    bcopy(data, &this->data[i * SectorSize], SectorSize);
+    stamps[i] = now++;
+    numWrites++;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::LoadWarm
+// 	Read the sectors recorded in a warm file, and return them in
+//	increasing order, without duplicates, so that they can be read
+//	in one sweep.  Return 0 if there is no warm file, or it is not
+//	one.
+//
+//	"name" -- the warm file
+//	"sectors" -- room for WarmSectors sectors
+//	"numSectors" -- sectors in the volume; others are dropped
+//----------------------------------------------------------------------
+
+int
+BufferCache::LoadWarm(char *name, int *sectors, int numSectors)
+{
+    int fd = OpenForReadWrite(name, FALSE);
+    int header[2], count = 0, sector, j;
+
+    if (fd < 0)
+        {
+            return 0;
+        }
+    if ((ReadPartial(fd, (char *) header, sizeof(header)) == sizeof(header))
+            && (header[0] == WarmMagic)
+            && (header[1] >= 0) && (header[1] <= WarmSectors))
+        {
+            for (int i = 0; i < header[1]; i++)
+                {
+                    if (ReadPartial(fd, (char *) &sector, sizeof(int)) != sizeof(int))
+                        break;
+                    if ((sector < 0) || (sector >= numSectors))
+                        continue;
+                    for (j = count; (j > 0) && (sectors[j - 1] > sector); j--)
+                        sectors[j] = sectors[j - 1];
+                    if ((j > 0) && (sectors[j - 1] == sector))
+                        {
+                            for (; j < count; j++)	// already there
+                                sectors[j] = sectors[j + 1];
+                            continue;
+                        }
+                    sectors[j] = sector;
+                    count++;
+                }
+        }
+    Close(fd);
+    return count;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::SaveWarm
+// 	Write the WarmSectors sectors that served the most reads to the
+//	warm file, most used first.  Sectors that were read in at mount
+//	and never used are left out, so the set follows the workload.
+//
+//	"name" -- the warm file
+//----------------------------------------------------------------------
+
+void
+BufferCache::SaveWarm(char *name)
+{
+    int header[2], *chosen = new int[WarmSectors];
+    bool *taken = new bool[size];
+    int fd, best;
+
+    for (int i = 0; i < size; i++)
+        taken[i] = FALSE;
+    for (header[1] = 0; header[1] < WarmSectors; header[1]++)
+        {
+            best = -1;
+            for (int i = 0; i < size; i++)
+                {
+                    if ((sectors[i] >= 0) && !taken[i] && (uses[i] > 0)
+                            && ((best < 0) || (uses[i] > uses[best])))
+                        best = i;
+                }
+            if (best < 0)
+                break;
+            taken[best] = TRUE;
+            chosen[header[1]] = sectors[best];
+        }
+
+    header[0] = WarmMagic;
+    fd = OpenForWrite(name);
+    WriteFile(fd, (char *) header, sizeof(header));
+    WriteFile(fd, (char *) chosen, header[1] * sizeof(int));
+    Close(fd);
+    delete [] chosen;
+    delete [] taken;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::PrintStats
+//----------------------------------------------------------------------
+
+void
+BufferCache::PrintStats()
+{
+    cout << "Buffer cache: hits " << numHits << ", misses " << numMisses;
+    cout << ", writes " << numWrites;
+    cout << ", prefetched " << numPrefetched;
+    cout << " (" << numWarmHits << " used)\n";
+}
@@ -0,0 +1,84 @@
+// buffercache.h
+//	Data structures for a cache of disk sectors in memory.
+//
+//	The cache sits in SynchDisk, above the log (if any), so it holds
+//	the sectors the file system sees.  Reads are served from it when
+//	they can be; writes go straight through to the disk, and update
+//	the cached copy on the way.  The least recently used sector is
+//	replaced.  There is no cache unless "-bc" or "-warm" is given.
+//
+//	Each run of Nachos otherwise starts with an empty cache, and
+//	has to read the free map, the root directory and the headers
+//	along the paths it uses one at a time, each read depending on
+//	the last.  So when Nachos halts, the sectors that were read most
+//	are recorded in a small file next to the disk ("warm file"); the
+//	next run reads them all in at mount, in sector order and queued
+//	together, before the file system asks for any of them.  This
+//	only happens with "-warm".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef BUFFERCACHE_H
+#define BUFFERCACHE_H
+
+#include "disk.h"
+
+const int DefaultCacheSectors = 256;	// size of the cache for -warm,
+// unless -bc
+const int WarmSectors = 64;		// most sectors in the warm file
+const int WarmMagic = 0x5741524d;	// first word of the warm file
+
+class BufferCache
+{
+public:
+    BufferCache(int size);		// An empty cache of "size" sectors
+    ~BufferCache();
+
+    bool Read(int sector, char *data);	// Copy "sector" into "data" if it
+    // is cached, and count a use
+    void Fill(int sector, char *data, bool prefetch);
+    // Cache a sector just read from disk
+    void Update(int sector, char *data);// Cache a sector being written
+
+    int Writes()
+    {
+        return numWrites;
+    }
+    // writes so far, to tell if a read
+    // raced with one
+
+    int LoadWarm(char *name, int *sectors, int numSectors);
+    // Read the warm file into "sectors",
+    // in increasing order; return how many
+    void SaveWarm(char *name);		// Record the most used sectors
+
+    void PrintStats();
+
+private:
+    int size;				// entries in the cache
+    int *sectors;			// sector cached in each entry, or -1
+    char *data;				// and its contents
+    int *stamps;			// when it was last used
+    int *uses;				// reads it served
+    bool *warm;				// read in at mount, not used yet
+    int *buckets;			// first entry holding each hash value
+    int *next;				// next entry with the same hash value
+    int numBuckets;
+    int now;				// counts the accesses, for stamps
+
+    int numWrites;			// writes through the cache
+    int numHits;			// reads served by the cache
+    int numMisses;			// ... and by the disk
+    int numPrefetched;			// sectors read in at mount
+    int numWarmHits;			// ... that served a read later
+
+    int Find(int sector);		// entry holding "sector", or -1
+    int Insert(int sector);		// entry to hold "sector", replacing
+    // the least recently used
+};
+
+#endif // BUFFERCACHE_H
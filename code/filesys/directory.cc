@@ -23,6 +23,8 @@
 #include "utility.h"
 #include "filehdr.h"
 #include "directory.h"
+#include "main.h"
+#include "disktrace.h"
 
 //----------------------------------------------------------------------
 // Directory::Directory
@@ -66,6 +68,8 @@ Directory::~Directory()
 void
 Directory::FetchFrom(OpenFile *file)
 {
+    IOContextScope context(IODirectory);
+
     (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
 }
 
@@ -79,6 +83,8 @@ Directory::FetchFrom(OpenFile *file)
 void
 Directory::WriteBack(OpenFile *file)
 {
+    IOContextScope context(IODirectory);
+
     (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
 }
 
@@ -79,6 +79,7 @@ public:
     //  names and their contents.
     int GetSize(){ return tableSize; }
     DirectoryEntry GetEntry(int i) { return table[i]; }   
+    void SetEntrySector(int i, int sector) { table[i].sector = sector; }
 
 private:
 
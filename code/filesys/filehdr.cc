@@ -28,6 +28,8 @@
 #include "debug.h"
 #include "synchdisk.h"
 #include "main.h"
+#include "disktrace.h"
+#include "refcount.h"
 
 //----------------------------------------------------------------------
 // MP4 mod tag
@@ -66,12 +68,17 @@ FileHeader::~FileHeader()
 //	Return FALSE if there are not enough free blocks to accomodate
 //	the new file.
 //
+//	With a "goal", the sectors are taken in order from the first
+//	free one at or after it, so that the data ends up close to the
+//	header and in sequence; otherwise from the start of the disk.
+//
 //	"freeMap" is the bit map of free disk sectors
 //	"fileSize" is the bit map of free disk sectors
+//	"goal" is the sector to allocate from, or -1
 //----------------------------------------------------------------------
 
 bool
-FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
+FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize, int goal)
 {
     numBytes = (fileSize < MaxFileSize) ? fileSize : MaxFileSize; // Clamp numBytes to MaxFileSize
     fileSize -= numBytes;
@@ -82,15 +89,19 @@ FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
 
     for (int i = 0; i < numSectors; i++)
         {
-            dataSectors[i] = freeMap->FindAndSet();
+            dataSectors[i] = (goal < 0) ? freeMap->FindAndSet()
+                             : freeMap->FindAndSet(goal);
             // since we checked that there was enough free space,
             // we expect this to succeed
             ASSERT(dataSectors[i] >= 0);
+            if (goal >= 0)
+                goal = (dataSectors[i] + 1) % kernel->synchDisk->NumSectors();
         }
         
     if(fileSize > 0)
     {
-        nextFileHeaderSector = freeMap->FindAndSet();	// find a sector to hold the file header
+        nextFileHeaderSector = (goal < 0) ? freeMap->FindAndSet()
+                               : freeMap->FindAndSet(goal);	// find a sector to hold the file header
         //printf("Extend inode: sector #%d (Remain size: %d)\n",nextFileHeaderSector, fileSize);
         if (nextFileHeaderSector == -1)
         {
@@ -99,8 +110,10 @@ FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
         }
         else
         {
+            if (goal >= 0)
+                goal = (nextFileHeaderSector + 1) % kernel->synchDisk->NumSectors();
             nextFileHeader = new FileHeader;
-            return nextFileHeader->Allocate(freeMap, fileSize);
+            return nextFileHeader->Allocate(freeMap, fileSize, goal);
         }
     }
     
@@ -110,26 +123,87 @@ FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
 // 	De-allocate all the space allocated for data blocks for this file.
+//	A block that a clone still shares is only released by this file.
 //
 //	"freeMap" is the bit map of free disk sectors
+//	"refCounts" counts the sharers of each sector, or is NULL
 //----------------------------------------------------------------------
 
 void
-FileHeader::Deallocate(PersistentBitmap *freeMap)
+FileHeader::Deallocate(PersistentBitmap *freeMap, RefCountTable *refCounts)
 {
     for (int i = 0; i < numSectors; i++)
     {
         ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-        freeMap->Clear((int) dataSectors[i]);
+        if (refCounts == NULL || !refCounts->Release(dataSectors[i]))
+            freeMap->Clear((int) dataSectors[i]);
     }
 
     if(nextFileHeaderSector != -1)
     {
         ASSERT(nextFileHeader != NULL);
-        nextFileHeader->Deallocate(freeMap);
+        nextFileHeader->Deallocate(freeMap, refCounts);
     }
 }
 
+//----------------------------------------------------------------------
+// FileHeader::CloneFrom
+// 	Initialize a fresh file header for a clone of the file "source":
+//	the same length, and the same data sectors.  Only the sectors for
+//	the rest of the header chain are allocated.  The caller counts the
+//	new sharers of the data sectors (see Share).
+//	Return FALSE if there is no room for the headers.
+//
+//	"source" is the header of the file to clone
+//	"freeMap" is the bit map of free disk sectors
+//	"goal" is the sector to allocate from, or -1
+//----------------------------------------------------------------------
+
+bool
+FileHeader::CloneFrom(FileHeader *source, PersistentBitmap *freeMap, int goal)
+{
+    numBytes = source->numBytes;
+    numSectors = source->numSectors;
+    bcopy(source->dataSectors, dataSectors, sizeof(dataSectors));
+    if (source->nextFileHeaderSector == -1)
+        return TRUE;
+
+    nextFileHeaderSector = (goal < 0) ? freeMap->FindAndSet()
+                           : freeMap->FindAndSet(goal);
+    if (nextFileHeaderSector == -1)
+        return FALSE;		// no free block for file header
+    if (goal >= 0)
+        goal = (nextFileHeaderSector + 1) % kernel->synchDisk->NumSectors();
+    nextFileHeader = new FileHeader;
+    return nextFileHeader->CloneFrom(source->nextFileHeader, freeMap, goal);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::CanShare, Share
+// 	Check that every data sector of the file can count one more
+//	sharer, and count it.
+//
+//	"refCounts" counts the sharers of each sector
+//----------------------------------------------------------------------
+
+bool
+FileHeader::CanShare(RefCountTable *refCounts)
+{
+    for (int i = 0; i < numSectors; i++)
+        if (refCounts->Sharers(dataSectors[i]) == MaxSharers)
+            return FALSE;
+    return (nextFileHeader == NULL) || nextFileHeader->CanShare(refCounts);
+}
+
+void
+FileHeader::Share(RefCountTable *refCounts)
+{
+    for (int i = 0; i < numSectors; i++)
+        refCounts->Share(dataSectors[i]);
+    if (nextFileHeader != NULL)
+        nextFileHeader->Share(refCounts);
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FetchFrom
 // 	Fetch contents of file header from disk.
@@ -140,6 +214,8 @@ FileHeader::Deallocate(PersistentBitmap *freeMap)
 void
 FileHeader::FetchFrom(int sector)
 {
+    IOContextScope context(IOHeader);	// the next headers too
+
     //printf("Fetch inode: sector #%d\n",sector);
     kernel->synchDisk->ReadSector(sector, ((char *)this) + sizeof(FileHeader*));
     
@@ -166,7 +242,7 @@ void
 FileHeader::WriteBack(int sector)
 {
     //printf("Writeback inode: sector #%d\n",sector);
-    kernel->synchDisk->WriteSector(sector, ((char *)this) + sizeof(FileHeader*));
+    WriteOne(sector);
     
     if(nextFileHeaderSector != -1)
     {
@@ -208,6 +284,49 @@ FileHeader::ByteToSector(int offset)
     }
 }
 
+//----------------------------------------------------------------------
+// FileHeader::WriteOne
+// 	Write this header, without the rest of the chain, back to disk.
+//
+//	"sector" is the disk sector to contain the file header
+//----------------------------------------------------------------------
+
+void
+FileHeader::WriteOne(int sector)
+{
+    IOContextScope context(IOHeader);
+
+    kernel->synchDisk->WriteSector(sector, ((char *)this) + sizeof(FileHeader*));
+}
+
+//----------------------------------------------------------------------
+// FileHeader::SetSector
+// 	Point the file at a new sector for the data at "offset" (used
+//	when a shared sector is copied before a write), and write back
+//	the one header of the chain that changed.
+//
+//	"offset" is the location within the file of the data
+//	"sector" is the data's new sector
+//	"headerSector" is the disk sector containing this header
+//----------------------------------------------------------------------
+
+void
+FileHeader::SetSector(int offset, int sector, int headerSector)
+{
+    int index = offset / SectorSize;
+    if(index < (int) NumDirect)
+    {
+        dataSectors[index] = sector;
+        WriteOne(headerSector);
+    }
+    else
+    {
+        ASSERT(nextFileHeader != NULL);
+        nextFileHeader->SetSector(offset - MaxFileSize, sector,
+                                  nextFileHeaderSector);
+    }
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FileLength
 // 	Return the number of bytes in the file.
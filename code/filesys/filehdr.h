@@ -17,6 +17,8 @@
 #include "disk.h"
 #include "pbitmap.h"
 
+class RefCountTable;
+
 // Modified ((SectorSize - 2 * sizeof(int)) / sizeof(int))
 // to ((SectorSize - 3 * sizeof(int)) / sizeof(int))
 // 3: plus "int nextHeader"
@@ -45,11 +47,21 @@ public:
     FileHeader(); // dummy constructor to keep valgrind happy
     ~FileHeader();
 
-    bool Allocate(PersistentBitmap *bitMap, int fileSize);// Initialize a file header,
+    bool Allocate(PersistentBitmap *bitMap, int fileSize, int goal = -1);
+    // Initialize a file header,
     //  including allocating space
-    //  on disk for the file data
-    void Deallocate(PersistentBitmap *bitMap);  // De-allocate this file's
-                                                //  data blocks
+    //  on disk for the file data,
+    //  starting at sector "goal"
+    //  if given
+    void Deallocate(PersistentBitmap *bitMap,
+                    RefCountTable *refCounts = NULL);
+    // De-allocate this file's data blocks,
+    //  except those still shared
+    bool CloneFrom(FileHeader *source, PersistentBitmap *freeMap, int goal);
+    // Initialize a file header that shares
+    //  the data blocks of "source"
+    bool CanShare(RefCountTable *refCounts);	// Can the data blocks take
+    void Share(RefCountTable *refCounts);	//  another sharer?  Add one
 
     void FetchFrom(int sectorNumber); 	// Initialize file header from disk
     void WriteBack(int sectorNumber); 	// Write modifications to file header
@@ -58,6 +70,10 @@ public:
     int ByteToSector(int offset);	// Convert a byte offset into the file
     // to the disk sector containing
     // the byte
+    void SetSector(int offset, int sector, int headerSector);
+    // Move the data at "offset" to "sector",
+    // and write back the header that
+    // changed (this one is at "headerSector")
 
     int FileLength();			// Return the length of the file
     // in bytes
@@ -70,6 +86,8 @@ public:
 private:
 
     FileHeader *nextFileHeader;
+
+    void WriteOne(int sector);		// Write back this header only
     
     /*
     	MP4 hint:
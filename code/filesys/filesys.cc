@@ -12,10 +12,11 @@
 // 	The file system consists of several data structures:
 //	   A bitmap of free disk sectors (cf. bitmap.h)
 //	   A directory of file names and file headers
+//	   A table of the sectors shared by cloned files (cf. refcount.h)
 //
-//      Both the bitmap and the directory are represented as normal
+//      The bitmap, the directory and the table are represented as normal
 //	files.  Their file headers are located in specific sectors
-//	(sector 0 and sector 1), so that the file system can find them
+//	(sectors 0, 1 and 2), so that the file system can find them
 //	on bootup.
 //
 //	The file system assumes that the bitmap and directory files are
@@ -51,19 +52,35 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "refcount.h"
+#include "tmpfs.h"
+#include "pipe.h"
+#include "synchdisk.h"
+#include "main.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
 // sectors, so that they can be located on boot-up.
 #define FreeMapSector 		0
 #define DirectorySector 	1
+#define RefCountSector 		2
 
 // Initial file sizes for the bitmap and directory; until the file system
 // supports extensible files, the directory size sets the maximum number
 // of files that can be loaded onto the disk.
-#define FreeMapFileSize 	(NumSectors / BitsInByte)
+#define FreeMapFileSize 	(kernel->synchDisk->NumSectors() / BitsInByte)
 #define NumDirEntries 		64 //10
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
+#define RefCountFileSize	(divRoundUp(kernel->synchDisk->NumSectors(), SectorSize) \
+				 * SectorSize)
+
+// With "-ag", the volume is divided into allocation groups of GroupTracks
+// tracks (of each disk, when the volume is striped).  New directories are
+// spread over the groups; files go in the group of their directory
+// and their data right after their header, to keep seeks short.
+#define GroupTracks		4
+#define NumGroups		(NumTracks / GroupTracks)
+#define GroupSectors		(kernel->synchDisk->NumSectors() / NumGroups)
 
 const char *RootDirectoryName = "/";
 
@@ -82,13 +99,16 @@ const char *RootDirectoryName = "/";
 
 FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
 {
-    DEBUG(dbgFile, "Initializing the file system. NumSectors = " << NumSectors);
+    numMounts = 0;
+    copyEpoch = 0;
+    DEBUG(dbgFile, "Initializing the file system. NumSectors = " << kernel->synchDisk->NumSectors());
     if (format)
         {
-            PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
+            PersistentBitmap *freeMap = new PersistentBitmap(kernel->synchDisk->NumSectors());
             Directory *directory = new Directory(NumDirEntries);
             FileHeader *mapHdr = new FileHeader;
             FileHeader *dirHdr = new FileHeader;
+            FileHeader *refHdr = new FileHeader;
 
             DEBUG(dbgFile, "Formatting the file system.");
 
@@ -96,12 +116,14 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
             // (make sure no one else grabs these!)
             freeMap->Mark(FreeMapSector);
             freeMap->Mark(DirectorySector);
+            freeMap->Mark(RefCountSector);
 
             // Second, allocate space for the data blocks containing the contents
             // of the directory and bitmap files.  There better be enough space!
 
             ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize));
             ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize));
+            ASSERT(refHdr->Allocate(freeMap, RefCountFileSize));
 
             // Flush the bitmap and directory FileHeaders back to disk
             // We need to do this before we can "Open" the file, since open
@@ -111,6 +133,7 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
             DEBUG(dbgFile, "Writing headers back to disk.");
             mapHdr->WriteBack(FreeMapSector);
             dirHdr->WriteBack(DirectorySector);
+            refHdr->WriteBack(RefCountSector);
 
             // OK to open the bitmap and directory files now
             // The file system operations assume these two files are left open
@@ -118,6 +141,7 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
 
             freeMapFile = new OpenFile(FreeMapSector);
             directoryFile = new OpenFile(DirectorySector);
+            refCountFile = new OpenFile(RefCountSector);
 
             // Once we have the files "open", we can write the initial version
             // of each file back to disk.  The directory at this point is completely
@@ -128,6 +152,8 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
             DEBUG(dbgFile, "Writing bitmap and directory back to disk.");
             freeMap->WriteBack(freeMapFile);	 // flush changes to disk
             directory->WriteBack(directoryFile);
+            refCounts = new RefCountTable(refCountFile,
+                                          kernel->synchDisk->NumSectors(), TRUE);
 
             if (debug->IsEnabled('f'))
                 {
@@ -138,6 +164,7 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
             delete directory;
             delete mapHdr;
             delete dirHdr;
+            delete refHdr;
         }
     else
         {
@@ -145,6 +172,9 @@ FileSystem::FileSystem(bool format) : fileDescritporIndex(0)
             // the bitmap and directory; these are left open while Nachos is running
             freeMapFile = new OpenFile(FreeMapSector);
             directoryFile = new OpenFile(DirectorySector);
+            refCountFile = new OpenFile(RefCountSector);
+            refCounts = new RefCountTable(refCountFile,
+                                          kernel->synchDisk->NumSectors(), FALSE);
         }
 }
 
@@ -156,6 +186,48 @@ FileSystem::~FileSystem()
 {
     delete freeMapFile;
     delete directoryFile;
+    delete refCounts;
+    delete refCountFile;
+    for (int i = 0; i < numMounts; i++)
+        delete mounts[i];
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Mount
+// 	Mount an empty tmpfs at "path": from now on, the files at and
+//	below it are kept in memory, and never reach the disk.  "path"
+//	need not exist on the disk; files the disk has there are hidden
+//	until Nachos halts.  Mounting at "/" keeps every file in memory.
+//
+//	"path" -- where to mount it, e.g. "/tmp"
+//----------------------------------------------------------------------
+
+void
+FileSystem::Mount(char *path)
+{
+    ASSERT(numMounts < MaxMounts);
+    mounts[numMounts++] = new MemFileSystem(path);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FindMount
+// 	Return the tmpfs that "name" is in, or NULL if it is on the
+//	disk.  The most recent mount wins, so a tmpfs may be mounted
+//	inside another.
+//
+//	"name" -- a full path name
+//	"rest" -- set to the path below the mount point
+//----------------------------------------------------------------------
+
+MemFileSystem *
+FileSystem::FindMount(char *name, char **rest)
+{
+    for (int i = numMounts - 1; i >= 0; i--)
+        {
+            if (mounts[i]->Covers(name, rest))
+                return mounts[i];
+        }
+    return NULL;
 }
 
 //----------------------------------------------------------------------
@@ -193,10 +265,17 @@ FileSystem::Create(char *name, int initialSize, bool directoryFlag)
     Directory *rootDirectory;
     PersistentBitmap *freeMap;
     FileHeader *hdr;
+    MemFileSystem *tmpfs;
     int sector, baseSector;
     bool success;
+    char *rest;
 
+    if ((tmpfs = FindMount(name, &rest)) != NULL)
+        {
+            return tmpfs->Create(rest, initialSize, directoryFlag);
+        }
     DEBUG(dbgFile, "Creating file type: " << directoryFlag << " " << name << " size " << initialSize);
+    kernel->synchDisk->BeginBatch();	// write it all out together
     
     // Force directory size to same
     if(directoryFlag)
@@ -224,8 +303,8 @@ FileSystem::Create(char *name, int initialSize, bool directoryFlag)
             success = FALSE;			// file is already in directory
         else
         {
-                freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-                sector = freeMap->FindAndSet();	// find a sector to hold the file header
+                freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
+                sector = AllocateHeader(freeMap, baseSector, directoryFlag);	// find a sector to hold the file header
                 
                 if (sector == -1)
                     success = FALSE;		// no free block for file header
@@ -235,7 +314,8 @@ FileSystem::Create(char *name, int initialSize, bool directoryFlag)
                 {
                         //printf("Create inode sector #%d: %s\n",sector,name);
                         hdr = new FileHeader;
-                        if (!hdr->Allocate(freeMap, initialSize))
+                        if (!hdr->Allocate(freeMap, initialSize, kernel->groupPlacement ?
+                                           (sector + 1) % kernel->synchDisk->NumSectors() : -1))
                             success = FALSE;	// no space on disk for data
                         else
                         {
@@ -266,10 +346,57 @@ FileSystem::Create(char *name, int initialSize, bool directoryFlag)
     }
 
     delete rootDirectory;
+    kernel->synchDisk->EndBatch();
     
     return success;
 }
 
+//----------------------------------------------------------------------
+// FileSystem::AllocateHeader
+// 	Find a free sector for the header of a new file or directory.
+//	A directory goes at the start of the allocation group with the
+//	most free sectors, the one nearest its parent's on a tie; a file
+//	goes as close after its parent directory as there is room.
+//	Without "-ag", just take the first free sector.
+//
+//	Return -1 if the disk is full.
+//
+//	"freeMap" -- the free sector map
+//	"parentSector" -- header sector of the parent directory
+//	"directoryFlag" -- is the new file a directory?
+//----------------------------------------------------------------------
+
+int
+FileSystem::AllocateHeader(PersistentBitmap *freeMap, int parentSector,
+                           bool directoryFlag)
+{
+    int parentGroup = parentSector / GroupSectors;
+    int best = parentGroup, bestFree = -1, numFree;
+
+    if (!kernel->groupPlacement)
+        {
+            return freeMap->FindAndSet();
+        }
+    if (!directoryFlag)
+        {
+            return freeMap->FindAndSet(parentSector);
+        }
+    for (int i = 0; i < NumGroups; i++)
+        {
+            int group = (parentGroup + i) % NumGroups;
+
+            numFree = freeMap->NumClear(group * GroupSectors,
+                                        (group + 1) * GroupSectors);
+            if (numFree > bestFree)
+                {
+                    best = group;
+                    bestFree = numFree;
+                }
+        }
+    DEBUG(dbgFile, "New directory in allocation group " << best);
+    return freeMap->FindAndSet(best * GroupSectors);
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Open
 // 	Open a file for reading and writing.
@@ -283,12 +410,19 @@ FileSystem::Create(char *name, int initialSize, bool directoryFlag)
 OpenFile *
 FileSystem::Open(char *name)
 {
-    Directory *rootDirectory = new Directory(NumDirEntries);
+    Directory *rootDirectory;
     OpenFile *openFile = NULL;
+    MemFileSystem *tmpfs;
     int sector, baseSector;
+    char *rest;
 
+    if ((tmpfs = FindMount(name, &rest)) != NULL)
+        {
+            return tmpfs->Open(rest);
+        }
     DEBUG(dbgFile, "Opening file" << name);
     
+    rootDirectory = new Directory(NumDirEntries);
     rootDirectory->FetchFrom(directoryFile);
 
     char basename[256];
@@ -308,7 +442,10 @@ FileSystem::Open(char *name)
 
         sector = baseDirectory->Find(filename);
         if (sector >= 0)
+        {
             openFile = new OpenFile(sector);	// name was found in directory
+            openFile->EnableCopyOnWrite();
+        }
 
         delete baseDirectoryFile;
         delete baseDirectory;
@@ -346,6 +483,15 @@ FileSystem::Close(OpenFileId id)
     return 1;
 }
 
+int 
+FileSystem::Seek(int position, OpenFileId id)
+{
+    if(id <= 0 || id > MAXOPENFILES) return -1;
+    if(fileDescriptorTable[id] == NULL || position < 0) return -1;
+    fileDescriptorTable[id]->Seek(position);
+    return 1;
+}
+
 OpenFileId 
 FileSystem::PutFileDescriptor(OpenFile *fileDesc)
 {
@@ -360,6 +506,33 @@ FileSystem::PutFileDescriptor(OpenFile *fileDesc)
     return index;
 }
 
+//----------------------------------------------------------------------
+// FileSystem::OpenPipe
+// 	Make a pipe, and put descriptors for its read end in "readId"
+//	and its write end in "writeId".  Return 1, or -1 if the table of
+//	open files is full.
+//----------------------------------------------------------------------
+
+int
+FileSystem::OpenPipe(OpenFileId *readId, OpenFileId *writeId)
+{
+    PipeBuffer *pipe = new PipeBuffer();
+    PipeEnd *reader = new PipeEnd(pipe, FALSE);
+    PipeEnd *writer = new PipeEnd(pipe, TRUE);
+
+    *readId = PutFileDescriptor(reader);
+    *writeId = (*readId == 0) ? 0 : PutFileDescriptor(writer);
+    if (*writeId == 0)
+        {
+            if (*readId != 0)
+                fileDescriptorTable[*readId] = NULL;
+            delete reader;
+            delete writer;			// the last end deletes the pipe
+            return -1;
+        }
+    return 1;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Remove
 // 	Delete a file from the file system.  This requires:
@@ -379,8 +552,14 @@ FileSystem::Remove(char *name, bool recursiveFlag)
     Directory *rootDirectory;
     PersistentBitmap *freeMap;
     FileHeader *fileHdr;
+    MemFileSystem *tmpfs;
     int sector, baseSector;
+    char *rest;
 
+    if ((tmpfs = FindMount(name, &rest)) != NULL)
+        {
+            return tmpfs->Remove(rest, recursiveFlag);
+        }
     rootDirectory = new Directory(NumDirEntries);
     rootDirectory->FetchFrom(directoryFile);
 
@@ -412,6 +591,7 @@ FileSystem::Remove(char *name, bool recursiveFlag)
         delete baseDirectory;
         return FALSE;			 // file not found
     }
+    kernel->synchDisk->BeginBatch();	// write it all out together
     
     // Recursive remove directory
     if(recursiveFlag && dirFlag)
@@ -440,9 +620,9 @@ FileSystem::Remove(char *name, bool recursiveFlag)
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
-    freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+    freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
 
-    fileHdr->Deallocate(freeMap);  		// remove data blocks
+    fileHdr->Deallocate(freeMap, refCounts);	// remove data blocks
     
     // Iterately clear fileheader sector
     FileHeader *hdr = fileHdr;
@@ -457,16 +637,200 @@ FileSystem::Remove(char *name, bool recursiveFlag)
     ASSERT(baseDirectory->Remove(filename) == TRUE);                    // remove directory entry
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
+    refCounts->WriteBack();
     baseDirectory->WriteBack(baseDirectoryFile);        // flush to disk
 
     delete fileHdr;
     delete baseDirectory;
     delete freeMap;
     delete rootDirectory;
+    kernel->synchDisk->EndBatch();
     
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// FileSystem::Clone
+// 	Make "to" a copy of the file "from", without copying its data:
+//	the new file header points at the same data sectors, and each
+//	of them counts one more sharer.  Only the headers, the
+//	directory, the free map and the changed part of the sharer
+//	table are written.  The first write to a shared sector, by
+//	either file, gives the writer a copy of its own (see CopyOnWrite).
+//
+//	Return FALSE if "from" is not a file, "to" exists already,
+//	there is no room for it, or either is in a tmpfs.
+//
+//	"from" -- the text name of the file to clone
+//	"to" -- the text name of the new file
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Clone(char *from, char *to)
+{
+    Directory *rootDirectory;
+    PersistentBitmap *freeMap;
+    FileHeader *sourceHdr, *hdr;
+    int sourceSector, sector, baseSector;
+    bool dirFlag = FALSE, success = FALSE;
+    char basename[256], filename[256], *rest;
+
+    if ((FindMount(from, &rest) != NULL) || (FindMount(to, &rest) != NULL))
+        {
+            return FALSE;			// tmpfs files share no sectors
+        }
+    DEBUG(dbgFile, "Cloning file " << from << " to " << to);
+    rootDirectory = new Directory(NumDirEntries);
+    rootDirectory->FetchFrom(directoryFile);
+
+    // find the source
+    bzero(basename, sizeof(char) * 256);
+    GetBaseName(basename, from);
+    baseSector = rootDirectory->Find_r(basename, NumDirEntries, DirectorySector);
+    sourceSector = -1;
+    if (baseSector >= 0)
+    {
+        OpenFile *baseDirectoryFile = new OpenFile(baseSector);
+        Directory *baseDirectory = new Directory(NumDirEntries);
+        baseDirectory->FetchFrom(baseDirectoryFile);
+
+        bzero(filename, sizeof(char) * 256);
+        GetFileName(filename, from);
+        sourceSector = baseDirectory->Find(filename, &dirFlag);
+        if (dirFlag)
+            sourceSector = -1;		// only files can be cloned
+
+        delete baseDirectoryFile;
+        delete baseDirectory;
+    }
+
+    // and the directory of the clone
+    bzero(basename, sizeof(char) * 256);
+    GetBaseName(basename, to);
+    baseSector = rootDirectory->Find_r(basename, NumDirEntries, DirectorySector);
+    delete rootDirectory;
+    if (sourceSector < 0 || baseSector < 0)
+        return FALSE;
+
+    kernel->synchDisk->BeginBatch();	// write it all out together
+    OpenFile *baseDirectoryFile = new OpenFile(baseSector);
+    Directory *baseDirectory = new Directory(NumDirEntries);
+    baseDirectory->FetchFrom(baseDirectoryFile);
+
+    bzero(filename, sizeof(char) * 256);
+    GetFileName(filename, to);
+
+    sourceHdr = new FileHeader;
+    sourceHdr->FetchFrom(sourceSector);
+    if (baseDirectory->Find(filename) == -1 && sourceHdr->CanShare(refCounts))
+    {
+        freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
+        sector = AllocateHeader(freeMap, baseSector, FALSE);
+        if (sector != -1 && baseDirectory->Add(filename, sector, FALSE))
+        {
+            hdr = new FileHeader;
+            if (hdr->CloneFrom(sourceHdr, freeMap, kernel->groupPlacement ?
+                               (sector + 1) % kernel->synchDisk->NumSectors() : -1))
+            {
+                success = TRUE;
+                hdr->Share(refCounts);
+                // everthing worked, flush all changes back to disk
+                hdr->WriteBack(sector);
+                baseDirectory->WriteBack(baseDirectoryFile);
+                freeMap->WriteBack(freeMapFile);
+                refCounts->WriteBack();
+            }
+            delete hdr;
+        }
+        delete freeMap;
+    }
+    delete sourceHdr;
+    delete baseDirectoryFile;
+    delete baseDirectory;
+    kernel->synchDisk->EndBatch();
+
+    return success;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CopyOnWrite
+// 	Write whole sectors of an open file; the ones it shares with a
+//	clone go to fresh sectors of its own, near the old ones, and the
+//	old ones are released.  The file header is updated, in memory
+//	and on disk.  Return FALSE, writing nothing, if the disk is too
+//	full for the copies.
+//
+//	So that a crash never leaves the header pointing at a sector
+//	that was not filled, the data goes to disk first, then the
+//	header, and only then the free map and the sharing counts.
+//
+//	Another OpenFile on the same file still has the old header in
+//	memory; the new copy epoch tells it to read the header again
+//	before it uses it (see OpenFile::CheckHeader).
+//
+//	"hdr" -- header of the file being written
+//	"hdrSector" -- where it lives on disk
+//	"firstSector" -- index in the file of the first sector to write
+//	"numSectors" -- how many sectors are written
+//	"sectors" -- their disk sectors, changed to the copies
+//	"data" -- what to write in them
+//----------------------------------------------------------------------
+
+bool
+FileSystem::CopyOnWrite(FileHeader *hdr, int hdrSector, int firstSector,
+                        int numSectors, int *sectors, char *data)
+{
+    PersistentBitmap *freeMap;
+    int *shared;
+    int numShared = 0;
+
+    for (int i = 0; i < numSectors; i++)
+        if (refCounts->Sharers(sectors[i]) > 0)
+            numShared++;
+    if (numShared == 0)
+    {
+        kernel->synchDisk->WriteSectors(numSectors, sectors, data);
+        return TRUE;
+    }
+
+    kernel->synchDisk->BeginBatch();
+    freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
+    if (freeMap->NumClear() < numShared)
+    {
+        delete freeMap;
+        kernel->synchDisk->EndBatch();
+        return FALSE;
+    }
+    shared = new int[numSectors];
+    for (int i = 0; i < numSectors; i++)
+    {
+        shared[i] = -1;
+        if (refCounts->Sharers(sectors[i]) == 0)
+            continue;
+        shared[i] = sectors[i];
+        sectors[i] = freeMap->FindAndSet(shared[i]);
+        ASSERT(sectors[i] >= 0);
+        DEBUG(dbgFile, "Copy on write: sector " << shared[i] << " to " << sectors[i]);
+    }
+    kernel->synchDisk->WriteSectors(numSectors, sectors, data);
+    for (int i = 0; i < numSectors; i++)
+        if (shared[i] != -1)
+            hdr->SetSector((firstSector + i) * SectorSize, sectors[i], hdrSector);
+    for (int i = 0; i < numSectors; i++)
+        if (shared[i] != -1)
+        {
+            bool stillShared = refCounts->Release(shared[i]);
+            ASSERT(stillShared);
+        }
+    freeMap->WriteBack(freeMapFile);
+    refCounts->WriteBack();
+    copyEpoch++;
+    delete [] shared;
+    delete freeMap;
+    kernel->synchDisk->EndBatch();
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
 // 	List all the files in the file system directory.
@@ -475,6 +839,15 @@ FileSystem::Remove(char *name, bool recursiveFlag)
 void
 FileSystem::List(char *dirName, bool recurrsiveFlag)
 {
+    MemFileSystem *tmpfs;
+    char *rest;
+
+    if ((tmpfs = FindMount(dirName, &rest)) != NULL)
+        {
+            tmpfs->List(rest, recurrsiveFlag);
+            return;
+        }
+
     Directory *rootDirectory = new Directory(NumDirEntries);
     rootDirectory->FetchFrom(directoryFile);
     
@@ -501,6 +874,316 @@ FileSystem::List(char *dirName, bool recurrsiveFlag)
     delete rootDirectory;
 }
 
+//----------------------------------------------------------------------
+// FileSystem::Defragment
+// 	Rewrite every file and directory (except the free map, the
+//	sharer table and the root directory, whose headers must stay
+//	put) as one run of sectors, laid out as FileHeader::Allocate
+//	lays out a new file: the header, its data, the next header of
+//	the chain, its data, and so on.  Each goes to the first free run
+//	that fits, looking from where Create would put it (see
+//	AllocateHeader), so that the files also close up the free space
+//	before them.  Files sharing sectors with a clone are left alone.
+//
+//	This is an offline pass, run before anything else: it assumes
+//	that no file is open.
+//----------------------------------------------------------------------
+
+void
+FileSystem::Defragment()
+{
+    PersistentBitmap *freeMap;
+    int numMoved;
+
+    printf("Before defragmenting:\n");
+    ReportFragmentation();
+
+    freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
+    numMoved = DefragmentDirectory(DirectorySector, freeMap);
+    freeMap->WriteBack(freeMapFile);
+    delete freeMap;
+
+    printf("After defragmenting (%d sectors moved):\n", numMoved);
+    ReportFragmentation();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::DefragmentDirectory
+// 	Relocate the files in a directory, and in the directories below
+//	it, and update its entries to their new header sectors.
+//	Return the number of sectors moved.
+//
+//	"dirSector" -- header sector of the directory
+//	"freeMap" -- the free sector map, written back by the caller
+//----------------------------------------------------------------------
+
+int
+FileSystem::DefragmentDirectory(int dirSector, PersistentBitmap *freeMap)
+{
+    OpenFile *dirFile = new OpenFile(dirSector);
+    Directory *dir = new Directory(NumDirEntries);
+    int numMoved = 0, goal;
+
+    dir->FetchFrom(dirFile);
+    for (int i = 0; i < dir->GetSize(); i++)
+    {
+        DirectoryEntry entry = dir->GetEntry(i);
+        if (!entry.inUse)
+            continue;
+        if (entry.directoryFlag)
+        {
+            // its own entries first; then the directory itself, within
+            // its allocation group
+            numMoved += DefragmentDirectory(entry.sector, freeMap);
+            goal = entry.sector / GroupSectors * GroupSectors;
+        }
+        else
+            goal = dirSector;			// next to the directory
+        if (!kernel->groupPlacement)
+            goal = 0;
+        dir->SetEntrySector(i, RelocateFile(entry.sector, goal, freeMap,
+                                            &numMoved));
+    }
+    dir->WriteBack(dirFile);
+
+    delete dir;
+    delete dirFile;
+    return numMoved;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::RelocateFile
+// 	Move a file into the first free run of sectors large enough for
+//	all of it, from "goal" on; its own sectors count as free.  Leave
+//	it where it is if it is there already, if there is no such run,
+//	or if it shares sectors with a clone.  Return the sector of its
+//	header, new or old.
+//
+//	"sector" -- header sector of the file
+//	"goal" -- where to start looking
+//	"freeMap" -- the free sector map
+//	"numMoved" -- incremented by the number of sectors moved
+//----------------------------------------------------------------------
+
+int
+FileSystem::RelocateFile(int sector, int goal, PersistentBitmap *freeMap,
+                         int *numMoved)
+{
+    FileHeader *hdr = new FileHeader, *link;
+    int length = 0, numHeaders = 0, numData, numLayout, start, i, j;
+    int *headers, *data, *layout;
+    bool inPlace;
+
+    hdr->FetchFrom(sector);
+    for (link = hdr; link != NULL; link = link->GetNextFileHeader())
+    {
+        length += link->FileLength();
+        numHeaders++;
+    }
+    numData = divRoundUp(length, SectorSize);
+    numLayout = numHeaders + numData;
+    headers = new int[numHeaders];
+    data = new int[numData];
+    layout = new int[numLayout];
+
+    // the sectors, and the order a fresh file would have them in
+    headers[0] = sector;
+    for (link = hdr, i = 1; i < numHeaders; link = link->GetNextFileHeader(), i++)
+        headers[i] = link->GetNextFileHeaderSector();
+    for (i = 0; i < numData; i++)
+        data[i] = hdr->ByteToSector(i * SectorSize);
+    for (i = j = 0; i < numHeaders; i++)
+    {
+        layout[j++] = headers[i];
+        for (int k = i * NumDirect; k < numData && k < (i + 1) * (int) NumDirect; k++)
+            layout[j++] = data[k];
+    }
+
+    for (i = 0; i < numData; i++)
+        if (refCounts->Sharers(data[i]) > 0)
+            break;
+    if (i < numData)
+        start = -1;				// shared with a clone
+    else
+    {
+        for (i = 0; i < numLayout; i++)
+            freeMap->Clear(layout[i]);
+        start = FindFreeRun(freeMap, goal, numLayout);
+    }
+    inPlace = (start == sector);
+    for (i = 0; inPlace && i < numLayout; i++)
+        inPlace = (layout[i] == sector + i);
+
+    if (start == -1 || inPlace)
+    {
+        if (start != -1)
+            for (i = 0; i < numLayout; i++)
+                freeMap->Mark(layout[i]);
+    }
+    else
+    {
+        char *buf = new char[numData * SectorSize];
+
+        DEBUG(dbgFile, "Relocating file at sector " << sector << " to " << start);
+        if (numData > 0)
+            kernel->synchDisk->ReadSectors(numData, data, buf);
+        delete hdr;
+        kernel->synchDisk->BeginBatch();	// write it all out together
+        freeMap->Mark(start);
+        hdr = new FileHeader;
+        bool allocated = hdr->Allocate(freeMap, length, start + 1);
+        ASSERT(allocated);
+        for (i = 0; i < numData; i++)
+            data[i] = hdr->ByteToSector(i * SectorSize);
+        if (numData > 0)
+            kernel->synchDisk->WriteSectors(numData, data, buf);
+        hdr->WriteBack(start);
+        kernel->synchDisk->EndBatch();
+        *numMoved += numLayout;
+        sector = start;
+        delete [] buf;
+    }
+
+    delete hdr;
+    delete [] headers;
+    delete [] data;
+    delete [] layout;
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FindFreeRun
+// 	Return the first sector of the first run of "length" free
+//	sectors at or after "from", wrapping around to the start of the
+//	disk, or -1 if there is none.  A run does not wrap around.
+//----------------------------------------------------------------------
+
+int
+FileSystem::FindFreeRun(PersistentBitmap *freeMap, int from, int length)
+{
+    int numSectors = kernel->synchDisk->NumSectors();
+    int run = 0;
+
+    for (int n = 0; n < numSectors; n++)
+    {
+        int i = (from + n) % numSectors;
+        if (i == 0 || freeMap->Test(i))
+            run = 0;
+        if (!freeMap->Test(i) && ++run == length)
+            return i - length + 1;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::ReportFragmentation
+// 	Print the files whose data is in more than one piece, how many
+//	pieces the files have on average, and how the free space is
+//	broken up.
+//----------------------------------------------------------------------
+
+void
+FileSystem::ReportFragmentation()
+{
+    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
+    int numFiles = 0, numFragmented = 0, numFragments = 0;
+    int numFree = 0, numRuns = 0, largest = 0, run = 0;
+
+    ReportDirectory(DirectorySector, "", &numFiles, &numFragmented, &numFragments);
+    for (int i = 0; i < kernel->synchDisk->NumSectors(); i++)
+    {
+        if (freeMap->Test(i))
+        {
+            run = 0;
+            continue;
+        }
+        if (run++ == 0)
+            numRuns++;
+        numFree++;
+        if (run > largest)
+            largest = run;
+    }
+    printf("%d files, %d fragmented, %.2f fragments per file\n", numFiles,
+           numFragmented, numFiles ? (double) numFragments / numFiles : 0.0);
+    printf("%d free sectors in %d runs, the largest %d sectors\n", numFree,
+           numRuns, largest);
+    delete freeMap;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::ReportDirectory
+// 	Count the files, and their fragments, in a directory and the
+//	directories below it, printing the fragmented ones.
+//
+//	"dirSector" -- header sector of the directory
+//	"path" -- its name, empty for the root
+//	"numFiles", "numFragmented", "numFragments" -- counts to add to
+//----------------------------------------------------------------------
+
+void
+FileSystem::ReportDirectory(int dirSector, char *path, int *numFiles,
+                            int *numFragmented, int *numFragments)
+{
+    OpenFile *dirFile = new OpenFile(dirSector);
+    Directory *dir = new Directory(NumDirEntries);
+    int fragments, numData;
+    char name[256];
+
+    dir->FetchFrom(dirFile);
+    for (int i = 0; i < dir->GetSize(); i++)
+    {
+        DirectoryEntry entry = dir->GetEntry(i);
+        if (!entry.inUse)
+            continue;
+        sprintf(name, "%s%s", path, entry.name);
+        if (entry.directoryFlag)
+            ReportDirectory(entry.sector, name, numFiles, numFragmented,
+                            numFragments);
+        fragments = CountFragments(entry.sector, &numData);
+        (*numFiles)++;
+        *numFragments += fragments;
+        if (fragments > 1)
+        {
+            (*numFragmented)++;
+            printf("  %s: %d fragments in %d sectors\n", name, fragments,
+                   numData);
+        }
+    }
+
+    delete dir;
+    delete dirFile;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CountFragments
+// 	Return the number of runs of consecutive sectors the data of a
+//	file is stored in.
+//
+//	"sector" -- header sector of the file
+//	"numDataSectors" -- set to the number of data sectors
+//----------------------------------------------------------------------
+
+int
+FileSystem::CountFragments(int sector, int *numDataSectors)
+{
+    FileHeader *hdr = new FileHeader, *link;
+    int length = 0, fragments = 0, previous = 0, next;
+
+    hdr->FetchFrom(sector);
+    for (link = hdr; link != NULL; link = link->GetNextFileHeader())
+        length += link->FileLength();
+    *numDataSectors = divRoundUp(length, SectorSize);
+    for (int i = 0; i < *numDataSectors; i++)
+    {
+        next = hdr->ByteToSector(i * SectorSize);
+        if (i == 0 || next != previous + 1)
+            fragments++;
+        previous = next;
+    }
+    delete hdr;
+    return fragments;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Print
 // 	Print everything about the file system:
@@ -516,7 +1199,7 @@ FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,kernel->synchDisk->NumSectors());
     Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
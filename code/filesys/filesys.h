@@ -79,6 +79,12 @@ public:
 
 #else // FILESYS
 class Directory;
+class PersistentBitmap;
+class FileHeader;
+class RefCountTable;
+class MemFileSystem;
+
+const int MaxMounts = 4;		// most tmpfs mounts
 class FileSystem
 {
 public:
@@ -99,13 +105,38 @@ public:
     int Read(char *buf, int size, OpenFileId id);
     int Write(char *buf, int size, OpenFileId id);
     int Close(OpenFileId id);
+    int Seek(int position, OpenFileId id);
     
     OpenFileId PutFileDescriptor(OpenFile *fileDesc);
+    int OpenPipe(OpenFileId *readId, OpenFileId *writeId);
+    // Make a pipe (pipe.h), and give its
+    // ends descriptors
     
     bool Remove(char *name, bool recursiveFlag);  		// Delete a file (UNIX unlink)
+
+    bool Clone(char *from, char *to);	// Make a copy of a file that
+    // shares its data sectors
+    bool CopyOnWrite(FileHeader *hdr, int hdrSector, int firstSector,
+                     int numSectors, int *sectors, char *data);
+    // Write sectors of a file, giving it
+    // its own copies of shared ones
+    int CopyEpoch()
+    {
+        return copyEpoch;
+    }
+    // Changes each time CopyOnWrite moves
+    // some file to new sectors
     
     void List(char *dirName, bool recurrsiveFlag);			// List all the files in the file system
 
+    void Mount(char *path);		// Keep the files at and below "path"
+    // in memory (tmpfs.h)
+
+    void Defragment();			// Make every file contiguous,
+    // and pack the files together
+    void ReportFragmentation();		// Print how fragmented the files
+    // and the free space are
+
     void Print();			// List all the files and their contents
     int GetDirectoryFileSize();
 private:
@@ -113,11 +144,30 @@ private:
     // represented as a file
     OpenFile* directoryFile;		// "Root" directory -- list of
     // file names, represented as a file
+    OpenFile* refCountFile;		// Sharers of each sector,
+    RefCountTable *refCounts;		// and their in-memory copy
+    int copyEpoch;			// sector moves by CopyOnWrite so far
     int fileDescritporIndex;
     OpenFile *fileDescriptorTable[MAXOPENFILES];
+    MemFileSystem *mounts[MaxMounts];	// the mount table
+    int numMounts;
     
+    MemFileSystem *FindMount(char *name, char **rest);
+    // the tmpfs holding "name", if any
     void GetBaseName(char *dest, char *name);
     void GetFileName(char *dest, char *name);
+
+    int AllocateHeader(PersistentBitmap *freeMap, int parentSector,
+                       bool directoryFlag);
+    // pick the sector for a new header
+
+    int DefragmentDirectory(int dirSector, PersistentBitmap *freeMap);
+    int RelocateFile(int sector, int goal, PersistentBitmap *freeMap,
+                     int *numMoved);
+    int FindFreeRun(PersistentBitmap *freeMap, int from, int length);
+    void ReportDirectory(int dirSector, char *path, int *numFiles,
+                         int *numFragmented, int *numFragments);
+    int CountFragments(int sector, int *numDataSectors);
     
 };
 
@@ -0,0 +1,739 @@
+// fsck.cc
+//	A standalone tool (not part of the Nachos kernel) to check, and
+//	optionally repair, the file system on a Nachos disk image, for
+//	instance after Nachos stopped in the middle of a Create or Remove.
+//
+//	Usage: fsck [-m hostId] [-disks n] [-mirror] [-j threads] [-r]
+//
+//	The volume is found as nachos finds it: DISK_<hostId>, or with
+//	-disks (and -mirror) the striped disks DISK_<hostId>_<i>.  -j sets
+//	the number of host threads to check with (default: one per host
+//	CPU), and -r writes the repairs back to the disks.
+//
+//	The whole volume is read into memory, then checked in passes:
+//
+//	   1. the directory tree is walked from the root, collecting the
+//	      file headers it refers to; entries that do not lead to a
+//	      valid header, or lead to one already seen, are dropped
+//	   2. the header chain of every file is checked, and the sectors
+//	      it refers to counted -- in parallel, files being handed out
+//	      to the worker threads as they ask for them
+//	   3. the counts are compared with the free map and the table of
+//	      shared sectors (see refcount.h) -- in parallel, each thread
+//	      taking a range of sectors.  Sectors marked in use that no
+//	      file refers to are orphans; if one holds what looks like a
+//	      file header, we report an orphaned file.
+//
+//	A repair drops the bad directory entries, and rebuilds the free
+//	map and the sharer table from the sectors still referred to, so
+//	that orphans are freed and sectors referred to by two files
+//	become shared copy on write.  A sector that is both a header and
+//	something else cannot be repaired this way, and is only reported.
+//
+//	Exit status: 0 if the file system was clean, 1 if it was repaired,
+//	4 if problems are left.  Log-structured volumes (-lfs) are not
+//	checked.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "filehdr.h"
+#include "directory.h"
+#include "refcount.h"
+#include "synchdisk.h"
+#include "lfs.h"
+#include "debug.h"
+#include "sysdep.h"
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+__thread Debug *debug;			// the library routines use it
+
+// These must match filesys.cc.
+const int FreeMapSector = 0;
+const int DirectorySector = 1;
+const int RefCountSector = 2;
+const int NumDirEntries = 64;
+const int DirectoryFileSize = sizeof(DirectoryEntry) * NumDirEntries;
+const int MagicSize = sizeof(int);	// and this disk.cc
+
+const int MaxReported = 10;		// sectors listed per kind of problem
+
+// The part of a FileHeader that is on disk (see filehdr.h).
+
+class DiskHeader
+{
+public:
+    int numBytes;
+    int numSectors;
+    int nextFileHeaderSector;
+    int dataSectors[NumDirect];
+};
+
+// The sectors of a file: its header chain, and its data in order.
+
+class FileMap
+{
+public:
+    int length;
+    int numHeaders, numData;
+    int *headers, *data;
+};
+
+// A file (or directory) found in the directory tree.
+
+class Inode
+{
+public:
+    char path[256];
+    int sector;				// of its header
+    int parent;				// directory listing it, or -1
+    int entry;				// index of its entry there
+    bool isDirectory;
+    FileMap map;
+    const char *problem;		// what is wrong with it, or NULL
+};
+
+// The volume, and what we found out about it
+static int numDisks = 1, hostId = 0, numThreads = 0;
+static bool mirror = FALSE, repair = FALSE;
+static int numSectors;			// logical sectors in the volume
+static char *image;			// their contents
+static bool *dirty;			// sectors changed by repairs
+static Inode *inodes;
+static int numInodes, maxInodes;
+static int *headerRefs, *dataRefs;	// references to each sector
+static int nextInode;			// next file for a worker to check
+static int numProblems, numRepaired;
+
+// Counts from the sector pass, one set per thread
+class SectorCounts
+{
+public:
+    int first, last;			// sectors this thread looks at
+    int numFree;
+    int markedFree, numOrphans, orphanFiles, crossLinked, badSharers;
+    int examples[4][MaxReported];
+};
+
+//----------------------------------------------------------------------
+// Sector
+// 	Return the contents of a sector of the volume.
+//----------------------------------------------------------------------
+
+static char *
+Sector(int sector)
+{
+    return &image[sector * SectorSize];
+}
+
+//----------------------------------------------------------------------
+// DiskOffset
+// 	Find where a sector of the volume is kept, as SynchDisk::Queue
+//	stripes it: which disk (the first of a mirrored pair), and the
+//	offset in its UNIX file.
+//----------------------------------------------------------------------
+
+static int
+DiskOffset(int sector, int *disk)
+{
+    int groups = mirror ? numDisks / 2 : numDisks;
+    int stripe = sector / StripeSectors;
+
+    *disk = (stripe % groups) * (mirror ? 2 : 1);
+    return MagicSize + ((stripe / groups) * StripeSectors
+                        + sector % StripeSectors) * SectorSize;
+}
+
+//----------------------------------------------------------------------
+// DiskName
+// 	The UNIX file holding disk "i" of the volume.
+//----------------------------------------------------------------------
+
+static void
+DiskName(int i, char *name)
+{
+    if (numDisks == 1)
+        sprintf(name, "DISK_%d", hostId);
+    else
+        sprintf(name, "DISK_%d_%d", hostId, i);
+}
+
+//----------------------------------------------------------------------
+// LoadVolume
+// 	Read every disk of the volume into memory, undoing the striping.
+//----------------------------------------------------------------------
+
+static void
+LoadVolume()
+{
+    int diskBytes = MagicSize + NumSectors * SectorSize;
+    int groups = mirror ? numDisks / 2 : numDisks;
+    char name[32];
+    char *contents = new char[diskBytes];
+
+    numSectors = groups * NumSectors;
+    image = new char[numSectors * SectorSize];
+    dirty = new bool[numSectors];
+    for (int i = 0; i < numDisks; i += (mirror ? 2 : 1))
+        {
+            int fd;
+
+            DiskName(i, name);
+            fd = OpenForReadWrite(name, TRUE);
+            Read(fd, contents, diskBytes);
+            Close(fd);
+            ASSERT(*(int *) contents == 0x456789ab);	// disk.cc's magic
+            for (int sector = 0; sector < numSectors; sector += StripeSectors)
+                {
+                    int disk, offset = DiskOffset(sector, &disk);
+                    if (disk == i)
+                        bcopy(&contents[offset], Sector(sector),
+                              StripeSectors * SectorSize);
+                }
+        }
+    for (int i = 0; i < numSectors; i++)
+        dirty[i] = FALSE;
+    delete [] contents;
+}
+
+//----------------------------------------------------------------------
+// SaveVolume
+// 	Write the sectors changed by repairs back to the disks, to both
+//	copies on a mirrored volume.
+//----------------------------------------------------------------------
+
+static void
+SaveVolume()
+{
+    char name[32];
+
+    for (int i = 0; i < numDisks; i++)
+        {
+            int fd;
+
+            DiskName(i, name);
+            fd = OpenForReadWrite(name, TRUE);
+            for (int sector = 0; sector < numSectors; sector++)
+                {
+                    int disk, offset = DiskOffset(sector, &disk);
+                    if (dirty[sector] && (disk == i || (mirror && disk + 1 == i)))
+                        {
+                            Lseek(fd, offset, 0);
+                            WriteFile(fd, Sector(sector), SectorSize);
+                        }
+                }
+            Close(fd);
+        }
+}
+
+//----------------------------------------------------------------------
+// ReadFileMap
+// 	Follow the header chain of a file, checking it as we go, and
+//	list its sectors.  Return what is wrong with it, or NULL.
+//
+//	"sector" -- its header
+//	"map" -- filled in with its sectors
+//----------------------------------------------------------------------
+
+static const char *
+ReadFileMap(int sector, FileMap *map)
+{
+    DiskHeader *hdr;
+    int next = sector, maxHeaders = numSectors / NumDirect + 1;
+
+    map->length = map->numHeaders = map->numData = 0;
+    map->headers = map->data = NULL;
+    // check the chain first, then list it
+    while (next != -1)
+        {
+            if (next < 0 || next >= numSectors)
+                return "header sector out of range";
+            if (++map->numHeaders > maxHeaders)
+                return "header chain loops";
+            hdr = (DiskHeader *) Sector(next);
+            if (hdr->numBytes < 0 || hdr->numBytes > (int) MaxFileSize
+                    || hdr->numSectors != divRoundUp(hdr->numBytes, SectorSize))
+                return "bad length in header";
+            if (hdr->nextFileHeaderSector != -1 && hdr->numBytes != (int) MaxFileSize)
+                return "header chain continues after a partial header";
+            for (int i = 0; i < hdr->numSectors; i++)
+                if (hdr->dataSectors[i] < 0 || hdr->dataSectors[i] >= numSectors)
+                    return "data sector out of range";
+            map->length += hdr->numBytes;
+            map->numData += hdr->numSectors;
+            next = hdr->nextFileHeaderSector;
+        }
+
+    map->headers = new int[map->numHeaders];
+    map->data = new int[map->numData];
+    map->numHeaders = map->numData = 0;
+    for (next = sector; next != -1; next = hdr->nextFileHeaderSector)
+        {
+            hdr = (DiskHeader *) Sector(next);
+            map->headers[map->numHeaders++] = next;
+            for (int i = 0; i < hdr->numSectors; i++)
+                map->data[map->numData++] = hdr->dataSectors[i];
+        }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ReadData, WriteData
+// 	Copy the data of a file out of the volume, or back into it.
+//----------------------------------------------------------------------
+
+static void
+ReadData(FileMap *map, char *data, int length)
+{
+    for (int i = 0; i < map->numData && i * SectorSize < length; i++)
+        bcopy(Sector(map->data[i]), &data[i * SectorSize],
+              min(SectorSize, length - i * SectorSize));
+}
+
+static void
+WriteData(FileMap *map, char *data, int length)
+{
+    for (int i = 0; i < map->numData && i * SectorSize < length; i++)
+        {
+            bcopy(&data[i * SectorSize], Sector(map->data[i]),
+                  min(SectorSize, length - i * SectorSize));
+            dirty[map->data[i]] = TRUE;
+        }
+}
+
+//----------------------------------------------------------------------
+// AddInode
+// 	Record a file found in the tree.
+//----------------------------------------------------------------------
+
+static Inode *
+AddInode(char *path, int sector, int parent, int entry, bool isDirectory)
+{
+    Inode *inode;
+
+    if (numInodes == maxInodes)
+        {
+            Inode *old = inodes;
+
+            maxInodes = maxInodes ? 2 * maxInodes : 64;
+            inodes = new Inode[maxInodes];
+            if (old != NULL)
+                bcopy(old, inodes, numInodes * sizeof(Inode));
+            delete [] old;
+        }
+    inode = &inodes[numInodes++];
+    strcpy(inode->path, path);
+    inode->sector = sector;
+    inode->parent = parent;
+    inode->entry = entry;
+    inode->isDirectory = isDirectory;
+    inode->problem = NULL;
+    inode->map.headers = inode->map.data = NULL;
+    return inode;
+}
+
+//----------------------------------------------------------------------
+// Problem
+// 	Report something wrong, and whether it is repaired.
+//----------------------------------------------------------------------
+
+static void
+Problem(const char *what, const char *where, bool fixed)
+{
+    printf("%s: %s%s\n", where, what, (fixed && repair) ? " (repaired)" : "");
+    numProblems++;
+    if (fixed && repair)
+        numRepaired++;
+}
+
+//----------------------------------------------------------------------
+// WalkTree
+// 	Pass 1: collect the files of the tree, breadth first.  The
+//	headers of directories are checked here, since we must read
+//	them; those of files are left to the workers.
+//----------------------------------------------------------------------
+
+static void
+WalkTree()
+{
+    bool *seen = new bool[numSectors];
+    char *table = new char[DirectoryFileSize];
+
+    for (int i = 0; i < numSectors; i++)
+        seen[i] = FALSE;
+    seen[FreeMapSector] = seen[DirectorySector] = seen[RefCountSector] = TRUE;
+    AddInode("(free map)", FreeMapSector, -1, -1, FALSE);
+    AddInode("(sharer table)", RefCountSector, -1, -1, FALSE);
+    AddInode("/", DirectorySector, -1, -1, TRUE);
+
+    for (int d = 0; d < numInodes; d++)
+        {
+            Inode *dir = &inodes[d];
+            DirectoryEntry *entries = (DirectoryEntry *) table;
+            bool changed = FALSE;
+
+            if (!dir->isDirectory)
+                continue;
+            dir->problem = ReadFileMap(dir->sector, &dir->map);
+            if (dir->problem == NULL && dir->map.length < DirectoryFileSize)
+                dir->problem = "directory too short";
+            if (dir->problem != NULL)
+                continue;		// reported with the files
+            ReadData(&dir->map, table, DirectoryFileSize);
+            for (int i = 0; i < NumDirEntries; i++)
+                {
+                    DirectoryEntry *entry = &entries[i];
+                    char path[256];
+                    const char *bad = NULL;
+
+                    if (!entry->inUse)
+                        continue;
+                    entry->name[FileNameMaxLen] = '\0';
+                    if (snprintf(path, sizeof(path), "%s/%s",
+                                 (d == 2) ? "" : dir->path, entry->name)
+                            >= (int) sizeof(path))
+                        Problem("path too long, shortened", path, FALSE);
+                    if (entry->sector < 0 || entry->sector >= numSectors)
+                        bad = "entry points outside the volume";
+                    else if (seen[entry->sector])
+                        bad = "entry points to a file listed already";
+                    if (bad != NULL)
+                        {
+                            Problem(bad, path, TRUE);
+                            entry->inUse = FALSE;
+                            changed = TRUE;
+                            continue;
+                        }
+                    seen[entry->sector] = TRUE;
+                    // inodes may move as the array grows; don't keep dir
+                    AddInode(path, entry->sector, d, i, entry->directoryFlag);
+                    dir = &inodes[d];
+                }
+            if (changed && repair)
+                WriteData(&dir->map, table, DirectoryFileSize);
+        }
+    delete [] seen;
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// CheckFiles
+// 	Pass 2, run by each worker thread: check the header chains of
+//	files, and count the references to every sector of the good ones.
+//----------------------------------------------------------------------
+
+static void *
+CheckFiles(void *unused)
+{
+    int i;
+
+    while ((i = __sync_fetch_and_add(&nextInode, 1)) < numInodes)
+        {
+            Inode *inode = &inodes[i];
+
+            if (!inode->isDirectory && i > 2)	// not read by pass 1
+                inode->problem = ReadFileMap(inode->sector, &inode->map);
+            if (inode->problem != NULL)
+                continue;
+            for (int j = 0; j < inode->map.numHeaders; j++)
+                __sync_fetch_and_add(&headerRefs[inode->map.headers[j]], 1);
+            for (int j = 0; j < inode->map.numData; j++)
+                __sync_fetch_and_add(&dataRefs[inode->map.data[j]], 1);
+        }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// LooksLikeHeader
+// 	Could an unreferenced sector be the header of a lost file?
+//----------------------------------------------------------------------
+
+static bool
+LooksLikeHeader(int sector)
+{
+    DiskHeader *hdr = (DiskHeader *) Sector(sector);
+
+    if (hdr->numBytes <= 0 || hdr->numBytes > (int) MaxFileSize
+            || hdr->numSectors != divRoundUp(hdr->numBytes, SectorSize))
+        return FALSE;
+    if (hdr->nextFileHeaderSector < -1 || hdr->nextFileHeaderSector >= numSectors)
+        return FALSE;
+    for (int i = 0; i < hdr->numSectors; i++)
+        if (hdr->dataSectors[i] < 0 || hdr->dataSectors[i] >= numSectors
+                || headerRefs[hdr->dataSectors[i]] + dataRefs[hdr->dataSectors[i]] > 0)
+            return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CheckSectors
+// 	Pass 3, run by each worker thread on its range of sectors:
+//	compare the references counted with the free map and the
+//	sharer table, and, when repairing, rebuild both.
+//
+//	"arg" -- the thread's SectorCounts
+//----------------------------------------------------------------------
+
+static void *
+CheckSectors(void *arg)
+{
+    SectorCounts *counts = (SectorCounts *) arg;
+    FileMap *mapFile = &inodes[0].map, *refFile = &inodes[1].map;
+
+    for (int sector = counts->first; sector < counts->last; sector++)
+        {
+            int refs = headerRefs[sector] + dataRefs[sector];
+            int expected = min(max(dataRefs[sector] - 1, 0), MaxSharers);
+            int byte = sector / BitsInByte;
+            int bit = 1 << (sector % BitsInByte);
+            unsigned char *freeMap, *sharers;
+            bool used;
+
+            // the free map is stored as words, from the least significant
+            // bit up (see bitmap.cc), so on a little-endian host, byte by
+            // byte; the sharer table has a byte per sector
+            freeMap = (unsigned char *)
+                      Sector(mapFile->data[byte / SectorSize]) + byte % SectorSize;
+            used = (*freeMap & bit) != 0;
+            sharers = (unsigned char *)
+                      Sector(refFile->data[sector / SectorSize]) + sector % SectorSize;
+
+            if (refs == 0 && !used)
+                counts->numFree++;
+            if (refs > 0 && !used)
+                {
+                    if (counts->markedFree < MaxReported)
+                        counts->examples[0][counts->markedFree] = sector;
+                    counts->markedFree++;
+                }
+            if (refs == 0 && used)
+                {
+                    if (LooksLikeHeader(sector))
+                        {
+                            if (counts->orphanFiles < MaxReported)
+                                counts->examples[1][counts->orphanFiles] = sector;
+                            counts->orphanFiles++;
+                        }
+                    counts->numOrphans++;
+                }
+            if (headerRefs[sector] > 1 || (headerRefs[sector] > 0 && dataRefs[sector] > 0))
+                {
+                    if (counts->crossLinked < MaxReported)
+                        counts->examples[2][counts->crossLinked] = sector;
+                    counts->crossLinked++;
+                }
+            if (*sharers != expected)
+                {
+                    if (counts->badSharers < MaxReported)
+                        counts->examples[3][counts->badSharers] = sector;
+                    counts->badSharers++;
+                }
+
+            if (repair)
+                {
+                    // no other thread touches this byte of the free map:
+                    // the ranges are whole sectors of it
+                    if (refs > 0)
+                        *freeMap |= bit;
+                    else
+                        *freeMap &= ~bit;
+                    *sharers = expected;
+                }
+        }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ReportSectors
+// 	Print what pass 3 found, of one kind.
+//----------------------------------------------------------------------
+
+static void
+ReportSectors(SectorCounts *counts, int kind, const char *what, bool fixed)
+{
+    int total = 0, shown = 0;
+    char where[64];
+
+    for (int t = 0; t < numThreads; t++)
+        {
+            int count = (kind == 0) ? counts[t].markedFree
+                        : (kind == 1) ? counts[t].orphanFiles
+                        : (kind == 2) ? counts[t].crossLinked
+                        : counts[t].badSharers;
+
+            for (int i = 0; i < count && i < MaxReported && shown < MaxReported; i++)
+                {
+                    sprintf(where, "sector %d", counts[t].examples[kind][i]);
+                    Problem(what, where, fixed);
+                    shown++;
+                }
+            total += count;
+        }
+    if (total > shown)
+        {
+            printf("... and %d more\n", total - shown);
+            numProblems += total - shown;
+            if (fixed && repair)
+                numRepaired += total - shown;
+        }
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Check the volume.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    pthread_t *threads;
+    SectorCounts *counts;
+    struct timeval start, end;
+    int numOrphans = 0, numFree = 0, range;
+
+    debug = new Debug("");
+    for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+                {
+                    hostId = atoi(argv[++i]);
+                }
+            else if (strcmp(argv[i], "-disks") == 0 && i + 1 < argc)
+                {
+                    numDisks = atoi(argv[++i]);
+                    ASSERT(numDisks >= 1);
+                }
+            else if (strcmp(argv[i], "-mirror") == 0)
+                {
+                    mirror = TRUE;
+                }
+            else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+                {
+                    numThreads = atoi(argv[++i]);
+                    ASSERT(numThreads >= 1);
+                }
+            else if (strcmp(argv[i], "-r") == 0)
+                {
+                    repair = TRUE;
+                }
+            else
+                {
+                    cerr << "Usage: fsck [-m hostId] [-disks n] [-mirror] [-j threads] [-r]\n";
+                    Exit(8);
+                }
+        }
+    ASSERT(!mirror || (numDisks % 2 == 0));
+    if (numThreads == 0)
+        numThreads = max(1, (int) sysconf(_SC_NPROCESSORS_ONLN));
+
+    gettimeofday(&start, NULL);
+    LoadVolume();
+    if (*(int *) Sector(0) == LogMagic)
+        {
+            printf("Log-structured volume; not checked\n");
+            Exit(8);
+        }
+
+    // pass 1
+    WalkTree();
+    for (int i = 0; i < 2; i++)
+        {
+            inodes[i].problem = ReadFileMap(inodes[i].sector, &inodes[i].map);
+            if (inodes[i].problem != NULL)
+                {
+                    Problem(inodes[i].problem, inodes[i].path, FALSE);
+                    printf("Cannot check further\n");
+                    Exit(4);
+                }
+        }
+    if (inodes[0].map.length * BitsInByte < numSectors
+            || inodes[1].map.length < numSectors)
+        {
+            Problem("too short for the volume", "(free map or sharer table)", FALSE);
+            Exit(4);
+        }
+
+    // pass 2
+    headerRefs = new int[numSectors];
+    dataRefs = new int[numSectors];
+    for (int i = 0; i < numSectors; i++)
+        headerRefs[i] = dataRefs[i] = 0;
+    threads = new pthread_t[numThreads];
+    nextInode = 0;
+    for (int t = 0; t < numThreads; t++)
+        pthread_create(&threads[t], NULL, CheckFiles, NULL);
+    for (int t = 0; t < numThreads; t++)
+        pthread_join(threads[t], NULL);
+
+    // drop the entries of bad files; their sectors are freed below
+    for (int i = 0; i < numInodes; i++)
+        {
+            Inode *inode = &inodes[i];
+            if (inode->problem == NULL)
+                continue;
+            Problem(inode->problem, inode->path, inode->parent >= 0);
+            if (inode->parent >= 0 && repair)
+                {
+                    Inode *dir = &inodes[inode->parent];
+                    char *table = new char[DirectoryFileSize];
+
+                    ReadData(&dir->map, table, DirectoryFileSize);
+                    ((DirectoryEntry *) table)[inode->entry].inUse = FALSE;
+                    WriteData(&dir->map, table, DirectoryFileSize);
+                    delete [] table;
+                }
+        }
+
+    // pass 3, in ranges of whole free map sectors
+    counts = new SectorCounts[numThreads];
+    range = divRoundUp(divRoundUp(numSectors, numThreads), SectorSize * BitsInByte)
+            * SectorSize * BitsInByte;
+    for (int t = 0; t < numThreads; t++)
+        {
+            bzero(&counts[t], sizeof(SectorCounts));
+            counts[t].first = min(numSectors, t * range);
+            counts[t].last = min(numSectors, (t + 1) * range);
+            pthread_create(&threads[t], NULL, CheckSectors, &counts[t]);
+        }
+    for (int t = 0; t < numThreads; t++)
+        {
+            pthread_join(threads[t], NULL);
+            numOrphans += counts[t].numOrphans;
+            numFree += counts[t].numFree;
+        }
+    ReportSectors(counts, 0, "in use but marked free", TRUE);
+    ReportSectors(counts, 1, "header of an orphaned file", TRUE);
+    ReportSectors(counts, 2, "header shared with another file", FALSE);
+    ReportSectors(counts, 3, "wrong sharer count", TRUE);
+    if (numOrphans > 0)
+        {
+            char what[64];
+            sprintf(what, "%d sectors marked in use, but not referred to",
+                    numOrphans);
+            Problem(what, "free map", TRUE);
+        }
+    if (repair)
+        {
+            for (int i = 0; i < inodes[0].map.numData; i++)
+                dirty[inodes[0].map.data[i]] = TRUE;
+            for (int i = 0; i < inodes[1].map.numData; i++)
+                dirty[inodes[1].map.data[i]] = TRUE;
+            SaveVolume();
+        }
+    gettimeofday(&end, NULL);
+
+    printf("%d files, %d of %d sectors free, %d problems", numInodes, numFree,
+           numSectors, numProblems);
+    if (repair)
+        printf(", %d repaired", numRepaired);
+    printf("; checked by %d thread(s) in %.3f seconds\n", numThreads,
+           (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6);
+
+    if (numProblems == 0)
+        return 0;
+    return (numProblems == numRepaired) ? 1 : 4;
+}
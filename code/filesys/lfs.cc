@@ -0,0 +1,699 @@
+// lfs.cc
+//	Routines to keep the disk volume as a log of segments, with a
+//	sector map, checkpoints, roll forward and a segment cleaner.
+//	See lfs.h for the layout.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "lfs.h"
+#include "synchdisk.h"
+#include "bitmap.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// CleanerThread
+// 	Entry point of the cleaner thread.
+//----------------------------------------------------------------------
+
+static void
+CleanerThread(SegmentLog *log)
+{
+    log->Clean();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::SegmentLog
+// 	Lay out the log over the physical volume, then either start a
+//	fresh, empty log, or recover the one already on the volume.
+//	Start the cleaner thread.
+//
+//	"disk" -- the volume
+//	"format" -- start a fresh log?
+//----------------------------------------------------------------------
+
+SegmentLog::SegmentLog(SynchDisk *disk, bool format)
+{
+    int physical = disk->NumPhysicalSectors();
+    int mapEntries, checkpointSegments;
+
+    this->disk = disk;
+
+    // The map needs an entry for every logical sector, and the
+    // checkpoint region whole segments; size it for the whole volume
+    // first, then see how many segments are left.
+    numSegments = physical / SegmentSectors;
+    mapSectors = divRoundUp(numSegments * SegmentSlots / 100 * LogUtilization
+                            * sizeof(int), SectorSize);
+    checkpointSegments = divRoundUp(1 + mapSectors, SegmentSectors);
+    numSegments -= checkpointSegments;
+    firstSegment = checkpointSegments * SegmentSectors;
+    numSectors = numSegments * SegmentSlots / 100 * LogUtilization;
+    numSectors -= numSectors % (SectorSize * BitsInByte);  // whole free map sectors
+    ASSERT(numSectors > 0 && numSectors * (int) sizeof(int) <= mapSectors * SectorSize);
+
+    mapEntries = mapSectors * SectorSize / sizeof(int);
+    map = new int[mapEntries];
+    for (int i = 0; i < mapEntries; i++)
+        map[i] = -1;
+    owner = new int[physical];
+    for (int i = 0; i < physical; i++)
+        owner[i] = -1;
+    mapDirty = new bool[mapSectors];
+    live = new int[numSegments];
+    segmentSeq = new int[numSegments];
+    segmentTime = new int[numSegments];
+    for (int i = 0; i < numSegments; i++)
+        live[i] = segmentSeq[i] = segmentTime[i] = 0;
+    buffer = new char[SegmentSectors * SectorSize];
+    summary = (SegmentSummary *) buffer;
+    ASSERT(sizeof(SegmentSummary) == SummarySectors * SectorSize);
+
+    lock = new Lock("segment log");
+    segmentFreed = new Condition("segment freed");
+    cleanerWakeup = new Semaphore("cleaner wakeup", 0);
+    cleanerAwake = FALSE;
+    batchDepth = 0;
+    numWrites = numSectorsWritten = numCleaned = numCopied = numCheckpoints = 0;
+
+    if (format)
+        {
+            CheckpointHeader *old = (CheckpointHeader *) buffer;
+            int zero = 0;
+
+            // a new generation, so that summaries of an old log on
+            // the volume are not mistaken for ours
+            disk->ReadPhysical(1, &zero, buffer);
+            generation = (old->magic == LogMagic) ? old->generation + 1 : 1;
+            head = 0;
+            next = 1;
+            headSeq = 1;
+            bzero(buffer, SegmentSectors * SectorSize);
+            summary->seq = headSeq;
+            summary->next = next;
+            summary->generation = generation;
+            synced = 0;
+            segmentSeq[head] = headSeq;
+            for (int i = 0; i < mapSectors; i++)
+                mapDirty[i] = TRUE;
+            Checkpoint();
+        }
+    else
+        {
+            Recover();
+        }
+    DEBUG(dbgFile, "Segment log: " << numSectors << " sectors in " << numSegments
+          << " segments, head " << head << " seq " << headSeq);
+
+    Thread *cleaner = new Thread("lfs cleaner", -1);
+    cleaner->Fork((VoidFunctionPtr) CleanerThread, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::~SegmentLog
+// 	Nachos is halting; the log is already consistent on disk.
+//----------------------------------------------------------------------
+
+SegmentLog::~SegmentLog()
+{
+    delete [] map;
+    delete [] owner;
+    delete [] mapDirty;
+    delete [] live;
+    delete [] segmentSeq;
+    delete [] segmentTime;
+    delete [] buffer;
+    delete lock;
+    delete segmentFreed;
+    delete cleanerWakeup;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::IsPresent
+// 	Return TRUE if the volume starts with a checkpoint header.
+//----------------------------------------------------------------------
+
+bool
+SegmentLog::IsPresent(SynchDisk *disk)
+{
+    char sector[SectorSize];
+    int zero = 0;
+
+    disk->ReadPhysical(1, &zero, sector);
+    return ((CheckpointHeader *) sector)->magic == LogMagic;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Read
+// 	Read logical sectors: from the head segment buffer if that is
+//	where they live, as zeroes if they were never written, and
+//	otherwise from the disk, all in one request.
+//
+//	"numSectors" -- how many sectors to read
+//	"sectorNumbers" -- which ones
+//	"data" -- buffer for numSectors * SectorSize bytes
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Read(int numSectors, int *sectorNumbers, char *data)
+{
+    int *physical = new int[numSectors];
+    int *which = new int[numSectors];
+    char *fromDisk = new char[numSectors * SectorSize];
+    int count = 0;
+
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++)
+        {
+            int sector = sectorNumbers[i];
+            int p;
+
+            ASSERT((sector >= 0) && (sector < this->numSectors));
+            p = map[sector];
+            if (p < 0)
+                {
+                    bzero(&data[i * SectorSize], SectorSize);
+                }
+            else if (p >= SegmentStart(head) && p < SegmentStart(head + 1))
+                {
+                    bcopy(&buffer[(p - SegmentStart(head)) * SectorSize],
+                          &data[i * SectorSize], SectorSize);
+                }
+            else
+                {
+                    physical[count] = p;
+                    which[count] = i;
+                    count++;
+                }
+        }
+    if (count > 0)
+        {
+            disk->ReadPhysical(count, physical, fromDisk);
+            for (int i = 0; i < count; i++)
+                bcopy(&fromDisk[i * SectorSize], &data[which[i] * SectorSize],
+                      SectorSize);
+        }
+    lock->Release();
+
+    delete [] physical;
+    delete [] which;
+    delete [] fromDisk;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Write
+// 	Append logical sectors to the log.  Unless a batch is in
+//	progress, they are on disk when we return.
+//
+//	"numSectors" -- how many sectors to write
+//	"sectorNumbers" -- which ones
+//	"data" -- numSectors * SectorSize bytes to write
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Write(int numSectors, int *sectorNumbers, char *data)
+{
+    lock->Acquire();
+    WaitForSpace(numSectors);
+    for (int i = 0; i < numSectors; i++)
+        {
+            ASSERT((sectorNumbers[i] >= 0) && (sectorNumbers[i] < this->numSectors));
+            Append(sectorNumbers[i], &data[i * SectorSize]);
+        }
+    if (batchDepth == 0)
+        {
+            Sync();
+        }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::BeginBatch, EndBatch
+// 	Between these, writes stay in the head segment buffer, so that
+//	the sectors written by one file system operation go to disk
+//	together.  Batches nest.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::BeginBatch()
+{
+    lock->Acquire();
+    batchDepth++;
+    lock->Release();
+}
+
+void
+SegmentLog::EndBatch()
+{
+    lock->Acquire();
+    ASSERT(batchDepth > 0);
+    if (--batchDepth == 0)
+        {
+            Sync();
+        }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Append
+// 	Put a copy of a logical sector in the next slot of the head
+//	segment, opening a new segment if it is full.  The lock must
+//	be held.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Append(int sector, char *data)
+{
+    int slot;
+
+    if (summary->numUsed == SegmentSlots)
+        {
+            AdvanceHead();
+        }
+    slot = summary->numUsed++;
+    bcopy(data, &buffer[(SummarySectors + slot) * SectorSize], SectorSize);
+    summary->slots[slot] = sector;
+    segmentTime[head] = kernel->stats->totalTicks;
+    Remap(sector, SegmentStart(head) + SummarySectors + slot);
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Remap
+// 	Record that the latest copy of logical "sector" is now at
+//	"physical"; the old copy, if any, is dead.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Remap(int sector, int physical)
+{
+    int old = map[sector];
+
+    if (old >= 0)
+        {
+            owner[old] = -1;
+            live[(old - firstSegment) / SegmentSectors]--;
+        }
+    map[sector] = physical;
+    owner[physical] = sector;
+    live[(physical - firstSegment) / SegmentSectors]++;
+    mapDirty[sector * sizeof(int) / SectorSize] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Sync
+// 	Write the slots of the head segment not yet on disk, in one
+//	sequential request, then its summary, which makes them part of
+//	the log.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Sync()
+{
+    int count = summary->numUsed - synced;
+    int sectors[SegmentSectors];
+
+    if (count == 0)
+        {
+            return;
+        }
+    for (int i = 0; i < count; i++)
+        sectors[i] = SegmentStart(head) + SummarySectors + synced + i;
+    disk->WritePhysical(count, sectors,
+                        &buffer[(SummarySectors + synced) * SectorSize]);
+    for (int i = 0; i < SummarySectors; i++)
+        sectors[i] = SegmentStart(head) + i;
+    disk->WritePhysical(SummarySectors, sectors, buffer);
+
+    synced = summary->numUsed;
+    numWrites++;
+    numSectorsWritten += count + SummarySectors;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::AdvanceHead
+// 	The head segment is full: write it out, and continue the log in
+//	the segment reserved for that, reserving a free one to follow.
+//	Take a checkpoint now and then, and wake the cleaner if free
+//	segments are running out.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::AdvanceHead()
+{
+    int follower;
+
+    Sync();
+    follower = FindFreeSegment();
+    ASSERT(follower >= 0);		// WaitForSpace made sure
+
+    head = next;
+    next = follower;
+    headSeq++;
+    bzero(buffer, SummarySectors * SectorSize);
+    summary->seq = headSeq;
+    summary->next = next;
+    summary->generation = generation;
+    synced = 0;
+    segmentSeq[head] = headSeq;
+    DEBUG(dbgFile, "Segment log: head now segment " << head << " seq " << headSeq);
+
+    if (headSeq - checkpointSeq >= CheckpointInterval)
+        {
+            Checkpoint();
+        }
+    if (!cleanerAwake && NumFreeSegments(FALSE) < CleanLowWater)
+        {
+            cleanerAwake = TRUE;
+            cleanerWakeup->V();
+        }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::IsFree
+// 	Return TRUE if a segment holds no live sectors and is not in
+//	use by the log.  Unless "evenIfCleanedSinceCheckpoint", it must
+//	also have been written before the last checkpoint, so that roll
+//	forward from there never needs it.
+//----------------------------------------------------------------------
+
+bool
+SegmentLog::IsFree(int segment, bool evenIfCleanedSinceCheckpoint)
+{
+    if (live[segment] > 0 || segment == head || segment == next)
+        {
+            return FALSE;
+        }
+    return evenIfCleanedSinceCheckpoint || segmentSeq[segment] < checkpointSeq;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::FindFreeSegment
+// 	Return the first reusable segment after the head, or -1.
+//----------------------------------------------------------------------
+
+int
+SegmentLog::FindFreeSegment()
+{
+    for (int i = 1; i <= numSegments; i++)
+        {
+            int segment = (head + i) % numSegments;
+
+            if (IsFree(segment, FALSE))
+                return segment;
+        }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::NumFreeSegments
+//----------------------------------------------------------------------
+
+int
+SegmentLog::NumFreeSegments(bool evenIfCleanedSinceCheckpoint)
+{
+    int count = 0;
+
+    for (int i = 0; i < numSegments; i++)
+        {
+            if (IsFree(i, evenIfCleanedSinceCheckpoint))
+                count++;
+        }
+    return count;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::WaitForSpace
+// 	Before a write of "numSectors" sectors, make sure it can be done
+//	and still leave the cleaner CleanReserve segments to work with;
+//	if not, wake the cleaner and wait for it.  The lock must be held.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::WaitForSpace(int numSectors)
+{
+    int needed = divRoundUp(numSectors, SegmentSlots) + CleanReserve;
+
+    while (NumFreeSegments(FALSE) < needed)
+        {
+            if (!cleanerAwake)
+                {
+                    cleanerAwake = TRUE;
+                    cleanerWakeup->V();
+                }
+            segmentFreed->Wait(lock);
+        }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::PickVictim
+// 	Return the segment whose cleaning pays off most, by the LFS
+//	cost-benefit rule: (1 - u) * age / (1 + u), where u is the
+//	fraction of it still live and age the time since it was last
+//	written.  Return -1 if no segment has any dead space.
+//----------------------------------------------------------------------
+
+int
+SegmentLog::PickVictim()
+{
+    int best = -1;
+    double bestScore = 0;
+
+    for (int i = 0; i < numSegments; i++)
+        {
+            if (i == head || i == next || live[i] == 0 || live[i] == SegmentSlots)
+                continue;
+
+            double u = (double) live[i] / SegmentSlots;
+            double age = kernel->stats->totalTicks - segmentTime[i] + 1;
+            double score = (1 - u) * age / (1 + u);
+
+            if (best < 0 || score > bestScore)
+                {
+                    best = i;
+                    bestScore = score;
+                }
+        }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::CleanSegment
+// 	Read the live sectors of a segment, and append them to the head
+//	of the log, leaving the segment dead.  The lock must be held.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::CleanSegment(int segment)
+{
+    int physical[SegmentSlots], logical[SegmentSlots];
+    char *data = new char[SegmentSlots * SectorSize];
+    int count = 0;
+
+    for (int slot = 0; slot < SegmentSlots; slot++)
+        {
+            int p = SegmentStart(segment) + SummarySectors + slot;
+
+            if (owner[p] >= 0)
+                {
+                    physical[count] = p;
+                    logical[count] = owner[p];
+                    count++;
+                }
+        }
+    DEBUG(dbgFile, "Cleaning segment " << segment << ", " << count << " live sectors");
+
+    disk->ReadPhysical(count, physical, data);
+    for (int i = 0; i < count; i++)
+        Append(logical[i], &data[i * SectorSize]);
+    Sync();
+    ASSERT(live[segment] == 0);
+
+    numCleaned++;
+    numCopied += count;
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Clean
+// 	The cleaner thread.  Whenever it is woken up, clean segments
+//	until CleanHighWater of them are free or nothing more can be
+//	gained, take a checkpoint so that the cleaned segments can be
+//	reused, and let the waiting writers go.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Clean()
+{
+    int victim;
+
+    for (;;)
+        {
+            cleanerWakeup->P();
+            lock->Acquire();
+            while (NumFreeSegments(TRUE) < CleanHighWater)
+                {
+                    if (NumFreeSegments(FALSE) < 2)  	// room to copy into
+                        {
+                            Checkpoint();
+                            if (NumFreeSegments(FALSE) < 2)
+                                break;
+                        }
+                    victim = PickVictim();
+                    if (victim < 0)
+                        break;
+                    CleanSegment(victim);
+                }
+            Checkpoint();
+            cleanerAwake = FALSE;
+            segmentFreed->Broadcast(lock);
+            lock->Release();
+        }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Checkpoint
+// 	Write out the head segment, then the parts of the sector map
+//	changed since the last checkpoint, then the header that says
+//	where the log goes on from here.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Checkpoint()
+{
+    char *data = new char[mapSectors * SectorSize];
+    int *sectors = new int[mapSectors];
+    CheckpointHeader *header = (CheckpointHeader *) data;
+    int count = 0;
+
+    Sync();
+    for (int i = 0; i < mapSectors; i++)
+        {
+            if (mapDirty[i])
+                {
+                    bcopy(&((char *) map)[i * SectorSize], &data[count * SectorSize],
+                          SectorSize);
+                    sectors[count++] = 1 + i;
+                    mapDirty[i] = FALSE;
+                }
+        }
+    if (count > 0)
+        {
+            disk->WritePhysical(count, sectors, data);
+        }
+
+    bzero(data, SectorSize);
+    header->magic = LogMagic;
+    header->generation = generation;
+    header->numSectors = numSectors;
+    header->head = head;
+    header->headSeq = headSeq;
+    header->headUsed = synced;
+    header->next = next;
+    sectors[0] = 0;
+    disk->WritePhysical(1, sectors, data);
+
+    checkpointSeq = headSeq;
+    numCheckpoints++;
+    delete [] data;
+    delete [] sectors;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Recover
+// 	Read the sector map from the checkpoint, then roll forward: apply
+//	the slots written to the checkpointed head after the checkpoint,
+//	and, while the segment is full, follow the log into the next one
+//	as long as its summary belongs to it.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Recover()
+{
+    char *data = new char[mapSectors * SectorSize];
+    int *sectors = new int[mapSectors];
+    CheckpointHeader header;
+    int from, numApplied = 0;
+
+    sectors[0] = 0;
+    disk->ReadPhysical(1, sectors, data);
+    bcopy(data, (char *) &header, sizeof(header));
+    ASSERT(header.magic == LogMagic && header.numSectors == numSectors);
+    generation = header.generation;
+
+    for (int i = 0; i < mapSectors; i++)
+        sectors[i] = 1 + i;
+    disk->ReadPhysical(mapSectors, sectors, (char *) map);
+    for (int i = 0; i < mapSectors; i++)
+        mapDirty[i] = FALSE;
+    for (int i = 0; i < numSectors; i++)
+        {
+            if (map[i] >= 0)
+                {
+                    owner[map[i]] = i;
+                    live[(map[i] - firstSegment) / SegmentSectors]++;
+                }
+        }
+
+    head = header.head;
+    headSeq = header.headSeq;
+    next = header.next;
+    checkpointSeq = headSeq;
+    from = header.headUsed;
+    for (;;)
+        {
+            for (int i = 0; i < SegmentSectors; i++)
+                sectors[i] = SegmentStart(head) + i;
+            disk->ReadPhysical(SegmentSectors, sectors, buffer);
+            if (summary->generation != generation || summary->seq != headSeq)
+                {
+                    // nothing written here since the checkpoint (or
+                    // since the head moved here)
+                    bzero(buffer, SummarySectors * SectorSize);
+                    summary->seq = headSeq;
+                    summary->next = next;
+                    summary->generation = generation;
+                    summary->numUsed = from;
+                    break;
+                }
+            segmentSeq[head] = headSeq;
+            for (int slot = from; slot < summary->numUsed; slot++)
+                {
+                    Remap(summary->slots[slot], SegmentStart(head) + SummarySectors + slot);
+                    numApplied++;
+                }
+            if (summary->numUsed < SegmentSlots)
+                break;
+
+            SegmentSummary *following = (SegmentSummary *) data;
+
+            for (int i = 0; i < SummarySectors; i++)
+                sectors[i] = SegmentStart(summary->next) + i;
+            disk->ReadPhysical(SummarySectors, sectors, data);
+            if (following->generation != generation || following->seq != headSeq + 1)
+                break;			// the log ends with a full segment
+            head = summary->next;
+            next = following->next;
+            headSeq++;
+            from = 0;
+        }
+    synced = summary->numUsed;
+    segmentSeq[head] = headSeq;
+    DEBUG(dbgFile, "Segment log: rolled forward " << numApplied << " sectors");
+
+    delete [] data;
+    delete [] sectors;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::PrintStats
+//----------------------------------------------------------------------
+
+void
+SegmentLog::PrintStats()
+{
+    cout << "Segment log: " << numWrites << " writes, " << numSectorsWritten;
+    cout << " sectors written, " << numCleaned << " segments cleaned, ";
+    cout << numCopied << " sectors copied, " << numCheckpoints << " checkpoints\n";
+}
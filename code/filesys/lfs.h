@@ -0,0 +1,177 @@
+// lfs.h
+//	Data structures for a log-structured layout of the disk volume.
+//
+//	With "-lfs", the file system does not write sectors in place.
+//	The sectors the file system sees ("logical" sectors) are
+//	remapped: every write, of file data, headers, directories or
+//	the free map alike, is appended to the current segment of a
+//	log, and a sector map (the generalisation of the LFS inode map
+//	to every sector) records where the latest copy of each logical
+//	sector lives.  Scattered small writes thus become sequential
+//	writes to the log.
+//
+//	Physical layout of the volume:
+//
+//	   checkpoint region -- a header sector, then the sector map
+//	   segments	     -- SegmentSectors each: a summary of
+//				SummarySectors (its sequence number, how
+//				many slots are used, the segment the log
+//				continues in, and the logical sector in
+//				each slot), then the data slots
+//
+//	Writes are buffered in the current ("head") segment and written
+//	to disk when a batch of file system operations ends (see
+//	SynchDisk::BeginBatch), or right away outside of a batch; each
+//	such partial segment write is the new slots plus the summary.
+//	Every CheckpointInterval segments, and after cleaning, the
+//	changed parts of the sector map are written to the checkpoint
+//	region.  At boot, the map is read back from the checkpoint and
+//	brought up to date by following the log from the checkpointed
+//	head ("roll forward").
+//
+//	A cleaner thread keeps enough segments free.  It picks the
+//	segments with the best cost-benefit ratio, (1 - u) * age / (1 + u)
+//	for a segment with live fraction u, and copies their live
+//	sectors to the head of the log.  A segment freed this way is only
+//	reused after the next checkpoint, so that roll forward never
+//	meets a segment that was overwritten.
+//
+//	Only part of the volume is offered to the file system
+//	(LogUtilization), so that the cleaner always finds dead space.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef LFS_H
+#define LFS_H
+
+#include "disk.h"
+#include "synch.h"
+
+class SynchDisk;
+
+const int SegmentSectors = 128;		// sectors per segment
+const int SummarySectors = 4;		// ... of which hold its summary
+const int SegmentSlots = SegmentSectors - SummarySectors;
+const int LogUtilization = 75;		// % of the log offered as sectors
+const int CheckpointInterval = 16;	// segments between checkpoints
+const int CleanReserve = 4;		// free segments kept for the cleaner
+const int CleanLowWater = 16;		// wake the cleaner below this many
+const int CleanHighWater = 64;		// free segments; clean up to this
+
+const int LogMagic = 0x4c4f4721;	// marks a checkpoint header
+
+// The checkpoint header, in the first sector of the volume.
+class CheckpointHeader
+{
+public:
+    int magic;				// LogMagic
+    int generation;			// bumped by every format
+    int numSectors;			// logical sectors in the volume
+    int head;				// segment being filled
+    int headSeq;			// its sequence number
+    int headUsed;			// slots of it already written
+    int next;				// segment the log continues in
+};
+
+// The summary at the start of every segment.  It fills SummarySectors
+// sectors exactly.
+class SegmentSummary
+{
+public:
+    int seq;				// sequence number of the segment
+    int numUsed;			// slots written
+    int next;				// segment the log continues in
+    int generation;			// that of the log it belongs to,
+    // so stale summaries are ignored
+    int slots[SegmentSlots];		// logical sector in each slot
+};
+
+// The following class defines the log.  Its Read and Write take
+// logical sectors, and do their I/O through SynchDisk::ReadPhysical
+// and WritePhysical.  One lock protects it all, held across the I/O,
+// so log operations are done one at a time.
+
+class SegmentLog
+{
+public:
+    SegmentLog(SynchDisk *disk, bool format);
+    // Lay out a fresh log over the volume,
+    // or recover the one on it
+    ~SegmentLog();
+
+    static bool IsPresent(SynchDisk *disk);
+    // Does the volume hold a log?
+
+    void Read(int numSectors, int *sectorNumbers, char *data);
+    void Write(int numSectors, int *sectorNumbers, char *data);
+    // Read/write logical sectors
+
+    void BeginBatch();			// Buffer writes until the
+    void EndBatch();			// outermost batch ends
+
+    int NumSectors()
+    {
+        return numSectors;
+    }
+    // logical size of the volume
+
+    void Clean();			// Body of the cleaner thread
+    void PrintStats();
+
+private:
+    SynchDisk *disk;
+    int numSectors;			// logical sectors
+    int numSegments;
+    int firstSegment;			// physical sector of segment 0
+    int mapSectors;			// sectors of the map on disk
+
+    int *map;				// logical -> physical sector, or -1
+    int *owner;				// physical -> logical sector, or -1
+    bool *mapDirty;			// map sectors changed since the
+    // last checkpoint
+    int *live;				// live slots in each segment
+    int *segmentSeq;			// sequence number of each segment
+    int *segmentTime;			// when it was last appended to
+
+    int head, headSeq, next;		// segment being filled, its sequence
+    // number, and the one after it
+    char *buffer;			// contents of the head segment
+    SegmentSummary *summary;		// (its summary is at the start)
+    int synced;				// slots of the head already on disk
+    int checkpointSeq;			// head sequence at the last checkpoint
+    int generation;			// of this log (see CheckpointHeader)
+    int batchDepth;			// nested batches in progress
+
+    Lock *lock;
+    Condition *segmentFreed;		// signalled after cleaning
+    Semaphore *cleanerWakeup;
+    bool cleanerAwake;
+
+    int numWrites, numSectorsWritten;	// partial segment writes
+    int numCleaned, numCopied;		// segments cleaned, sectors copied
+    int numCheckpoints;
+
+    int SegmentStart(int segment)
+    {
+        return firstSegment + segment * SegmentSectors;
+    }
+    void Append(int sector, char *data);// Add a sector to the head
+    void Remap(int sector, int physical);// Point the map at a new copy
+    void Sync();			// Write out the unwritten slots
+    void AdvanceHead();			// Move on to the next segment
+    int FindFreeSegment();		// A reusable segment, or -1
+    bool IsFree(int segment, bool evenIfCleanedSinceCheckpoint);
+    int NumFreeSegments(bool evenIfCleanedSinceCheckpoint);
+    void WaitForSpace(int numSectors);	// Block writers until the cleaner
+    // has made room
+    int PickVictim();			// Best segment to clean, or -1
+    void CleanSegment(int segment);	// Copy its live sectors to the head
+    void Checkpoint();			// Save the map
+    void Recover();			// Read the map, roll forward
+};
+
+#endif // LFS_H
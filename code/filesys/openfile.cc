@@ -17,6 +17,7 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "filesys.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -30,7 +31,25 @@ OpenFile::OpenFile(int sector)
 {
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
+    hdrSector = sector;
     seekPosition = 0;
+    copyOnWrite = FALSE;
+    copyEpoch = 0;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::OpenFile
+// 	Start an open file that has no header on the disk; its class
+//	provides ReadAt, WriteAt and Length.
+//----------------------------------------------------------------------
+
+OpenFile::OpenFile()
+{
+    hdr = NULL;
+    hdrSector = -1;
+    seekPosition = 0;
+    copyOnWrite = FALSE;
+    copyEpoch = 0;
 }
 
 //----------------------------------------------------------------------
@@ -43,6 +62,38 @@ OpenFile::~OpenFile()
     delete hdr;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::EnableCopyOnWrite
+// 	The file may share data sectors with clones: from now on, copy
+//	the shared ones before writing them.
+//----------------------------------------------------------------------
+
+void
+OpenFile::EnableCopyOnWrite()
+{
+    copyOnWrite = TRUE;
+    copyEpoch = kernel->fileSystem->CopyEpoch();
+}
+
+//----------------------------------------------------------------------
+// OpenFile::CheckHeader
+// 	If some file has been moved to new sectors by a copy on write
+//	since we read our header, it may have been this one, through
+//	another OpenFile; read the header again, so that we never touch
+//	a sector that now belongs to the clone alone.
+//----------------------------------------------------------------------
+
+void
+OpenFile::CheckHeader()
+{
+    if (!copyOnWrite || copyEpoch == kernel->fileSystem->CopyEpoch())
+        return;
+    delete hdr;
+    hdr = new FileHeader;
+    hdr->FetchFrom(hdrSector);
+    copyEpoch = kernel->fileSystem->CopyEpoch();
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Seek
 // 	Change the current location within the open file -- the point at
@@ -98,12 +149,19 @@ OpenFile::Write(char *into, int numBytes)
 //
 //	For ReadAt:
 //	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   request, but we only copy the part we are interested in.  A
+//	   request of whole sectors is read straight into "into".
 //	For WriteAt:
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   or partial sectors that are part of the request.  If a clone
+//	   shares any of them, they go to fresh copies instead (see
+//	   FileSystem::CopyOnWrite); the sectors we write are whole, so
+//	   nothing needs to be copied over first.
+//
+//	Both read the header again first if a copy on write through
+//	another OpenFile may have changed it.
 //
 //	"into" -- the buffer to contain the data to be read from disk
 //	"from" -- the buffer containing the data to be written to disk
@@ -115,10 +173,13 @@ OpenFile::Write(char *into, int numBytes)
 int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
-    int fileLength = Length();
+    int fileLength;
     int i, firstSector, lastSector, numSectors;
+    int *sectors;
     char *buf;
 
+    CheckHeader();
+    fileLength = Length();
     if ((numBytes <= 0) || (position >= fileLength))
         return 0; 				// check request
     if ((position + numBytes) > fileLength)
@@ -129,26 +190,38 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
+    // read in all the full and partial sectors that we need,
+    // all at once so that a striped volume reads them in parallel
+    if ((position % SectorSize == 0) && (numBytes % SectorSize == 0))
+        buf = into;			// no need to copy
+    else
+        buf = new char[numSectors * SectorSize];
+    sectors = new int[numSectors];
     for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
-                                      &buf[(i - firstSector) * SectorSize]);
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+    kernel->synchDisk->ReadSectors(numSectors, sectors, buf);
+    delete [] sectors;
 
     // copy the part we want
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    if (buf != into)
+        {
+            bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
+            delete [] buf;
+        }
     return numBytes;
 }
 
 int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
-    int fileLength = Length();
+    int fileLength;
     int i, firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
+    int *sectors;
     char *buf;
 
+    CheckHeader();
+    fileLength = Length();
     if ((numBytes <= 0) || (position >= fileLength))
         return 0;				// check request
     if ((position + numBytes) > fileLength)
@@ -178,9 +251,21 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
 // write modified sectors back
+    sectors = new int[numSectors];
     for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
-                                       &buf[(i - firstSector) * SectorSize]);
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+    if (!copyOnWrite)
+        kernel->synchDisk->WriteSectors(numSectors, sectors, buf);
+    else if (!kernel->fileSystem->CopyOnWrite(hdr, hdrSector,
+             firstSector, numSectors, sectors, buf))
+        {
+            delete [] sectors;
+            delete [] buf;
+            return 0;				// no room for the copies
+        }
+    else
+        copyEpoch = kernel->fileSystem->CopyEpoch();	// hdr is current
+    delete [] sectors;
     delete [] buf;
     return numBytes;
 }
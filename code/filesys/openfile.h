@@ -83,7 +83,7 @@ class OpenFile
 public:
     OpenFile(int sector);		// Open a file whose header is located
     // at "sector" on the disk
-    ~OpenFile();			// Close the file
+    virtual ~OpenFile();		// Close the file
 
     void Seek(int position); 		// Set the position from which to
     // start reading/writing -- UNIX lseek
@@ -94,19 +94,34 @@ public:
     // and increment position in file.
     int Write(char *from, int numBytes);
 
-    int ReadAt(char *into, int numBytes, int position);
+    virtual int ReadAt(char *into, int numBytes, int position);
     // Read/write bytes from the file,
     // bypassing the implicit position.
-    int WriteAt(char *from, int numBytes, int position);
+    virtual int WriteAt(char *from, int numBytes, int position);
 
-    int Length(); 			// Return the number of bytes in the
+    virtual int Length(); 		// Return the number of bytes in the
     // file (this interface is simpler
     // than the UNIX idiom -- lseek to
     // end of file, tell, lseek back
+    // Files kept elsewhere than on the
+    // disk (tmpfs.h) redefine these three
+
+    void EnableCopyOnWrite();		// The data may be shared with clones;
+    // copy shared sectors before writing
+
+protected:
+    OpenFile();				// For a file not on the disk
 
 private:
     FileHeader *hdr;			// Header for this file
+    int hdrSector;			// ... and where it lives
     int seekPosition;			// Current position within the file
+    bool copyOnWrite;			// check for shared sectors?
+    int copyEpoch;			// file system's copy epoch when the
+    // header was read
+
+    void CheckHeader();			// Read the header again if a copy
+    // on write may have changed it
 };
 
 #endif // FILESYS
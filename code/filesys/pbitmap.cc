@@ -8,6 +8,8 @@
 
 #include "copyright.h"
 #include "pbitmap.h"
+#include "main.h"
+#include "disktrace.h"
 
 //----------------------------------------------------------------------
 // PersistentBitmap::PersistentBitmap(int)
@@ -40,6 +42,8 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems):Bitmap(numItems
     // map has already been initialized by the BitMap constructor,
     // but we will just overwrite that with the contents of the
     // map found in the file
+    IOContextScope context(IOFreeMap);
+
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
 }
 
@@ -62,6 +66,8 @@ PersistentBitmap::~PersistentBitmap()
 void
 PersistentBitmap::FetchFrom(OpenFile *file)
 {
+    IOContextScope context(IOFreeMap);
+
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
 }
 
@@ -75,5 +81,7 @@ PersistentBitmap::FetchFrom(OpenFile *file)
 void
 PersistentBitmap::WriteBack(OpenFile *file)
 {
+    IOContextScope context(IOFreeMap);
+
     file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
 }
@@ -0,0 +1,233 @@
+// pipe.cc
+//	Routines for pipes between user programs.  See pipe.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pipe.h"
+#include "synch.h"
+#include "debug.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe, with both of its ends open.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer()
+{
+    lock = new Lock("pipe");
+    notEmpty = new Condition("pipe not empty");
+    notFull = new Condition("pipe not full");
+    buffer = new char[PipeSize];
+    head = count = 0;
+    readerOpen = writerOpen = TRUE;
+    readerBuffer = NULL;
+    readerWanted = readerGot = 0;
+}
+
+PipeBuffer::~PipeBuffer()
+{
+    delete lock;
+    delete notEmpty;
+    delete notFull;
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Read up to "numBytes" from the pipe into "into".  Wait until
+//	there is something to read, or until the write end is closed,
+//	in which case return 0.  While the ring is empty, the reader
+//	offers "into" to the writer, to copy its data into directly.
+//
+//	"into" -- the buffer to read into
+//	"numBytes" -- the most to read
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(char *into, int numBytes)
+{
+    int done = 0, chunk;
+    bool offered = FALSE;
+
+    if (numBytes <= 0)
+        {
+            return 0;
+        }
+    lock->Acquire();
+    if ((count == 0) && writerOpen && (readerBuffer == NULL))
+        {
+            readerBuffer = into;		// for the writer to fill
+            readerWanted = numBytes;
+            readerGot = 0;
+            offered = TRUE;
+        }
+    while ((count == 0) && writerOpen && !(offered && (readerGot > 0)))
+        {
+            notEmpty->Wait(lock);
+        }
+    if (offered)
+        {
+            done = readerGot;
+            readerBuffer = NULL;
+        }
+
+    // then take what the ring holds, in at most two pieces
+    while ((done < numBytes) && (count > 0))
+        {
+            chunk = min(numBytes - done, min(count, PipeSize - head));
+            bcopy(buffer + head, into + done, chunk);
+            head = (head + chunk) % PipeSize;
+            count -= chunk;
+            done += chunk;
+        }
+    if (PipeSize - count >= PipeSize / 2)
+        {
+            notFull->Broadcast(lock);
+        }
+    lock->Release();
+    DEBUG(dbgFile, "Pipe read " << done << " of " << numBytes << " bytes");
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Write "numBytes" from "from" into the pipe, waiting for room as
+//	need be.  Return how many were written, which falls short only
+//	if the read end is closed; -1 if it was closed before any were.
+//
+//	"from" -- the buffer holding the data
+//	"numBytes" -- how much of it to write
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(char *from, int numBytes)
+{
+    int done = 0, chunk, tail;
+
+    lock->Acquire();
+    while ((done < numBytes) && readerOpen)
+        {
+            if ((readerBuffer != NULL) && (readerGot == 0) && (count == 0))
+                {
+                    // a reader is waiting: skip the ring
+                    chunk = min(numBytes - done, readerWanted);
+                    bcopy(from + done, readerBuffer, chunk);
+                    readerGot = chunk;
+                    done += chunk;
+                    notEmpty->Broadcast(lock);
+                }
+            else if (count < PipeSize)
+                {
+                    tail = (head + count) % PipeSize;
+                    chunk = min(numBytes - done, min(PipeSize - count, PipeSize - tail));
+                    bcopy(from + done, buffer + tail, chunk);
+                    count += chunk;
+                    done += chunk;
+                }
+            else
+                {
+                    // full: let the reader at it, and wait until half
+                    // of it is free again
+                    notEmpty->Broadcast(lock);
+                    while ((PipeSize - count < PipeSize / 2) && readerOpen)
+                        {
+                            notFull->Wait(lock);
+                        }
+                }
+        }
+    if (count > 0)
+        {
+            notEmpty->Broadcast(lock);
+        }
+    lock->Release();
+    DEBUG(dbgFile, "Pipe wrote " << done << " of " << numBytes << " bytes");
+    if ((done == 0) && (numBytes > 0))
+        {
+            return -1;			// no reader
+        }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Close
+// 	Close one end of the pipe, and wake whoever waits on the other,
+//	to see it closed.  Return TRUE if both ends are closed now, and
+//	the pipe can be deleted.
+//
+//	"writeEnd" -- close the write end, or else the read end
+//----------------------------------------------------------------------
+
+bool
+PipeBuffer::Close(bool writeEnd)
+{
+    bool unused;
+
+    lock->Acquire();
+    if (writeEnd)
+        {
+            writerOpen = FALSE;
+            notEmpty->Broadcast(lock);
+        }
+    else
+        {
+            readerOpen = FALSE;
+            notFull->Broadcast(lock);
+        }
+    unused = !readerOpen && !writerOpen;
+    lock->Release();
+    return unused;
+}
+
+//----------------------------------------------------------------------
+// PipeEnd::PipeEnd
+// 	Make an OpenFile for one end of "pipe".
+//----------------------------------------------------------------------
+
+PipeEnd::PipeEnd(PipeBuffer *pipe, bool writeEnd)
+{
+    this->pipe = pipe;
+    this->writeEnd = writeEnd;
+}
+
+//----------------------------------------------------------------------
+// PipeEnd::~PipeEnd
+// 	Close this end of the pipe, and delete the pipe with the last
+//	end.
+//----------------------------------------------------------------------
+
+PipeEnd::~PipeEnd()
+{
+    if (pipe->Close(writeEnd))
+        {
+            delete pipe;
+        }
+}
+
+int
+PipeEnd::ReadAt(char *into, int numBytes, int position)
+{
+    if (writeEnd)
+        {
+            return -1;
+        }
+    return pipe->Read(into, numBytes);
+}
+
+int
+PipeEnd::WriteAt(char *from, int numBytes, int position)
+{
+    if (!writeEnd)
+        {
+            return -1;
+        }
+    return pipe->Write(from, numBytes);
+}
+
+int
+PipeEnd::Length()
+{
+    return 0;
+}
@@ -0,0 +1,78 @@
+// pipe.h
+//	Data structures for pipes: byte streams between user programs.
+//
+//	A pipe is a ring buffer in the kernel with an end for reading and
+//	an end for writing, each an OpenFile, so that Read, Write and
+//	Close work on pipe descriptors as on files.  Reading an empty
+//	pipe waits for a writer, and writing a full one waits for a
+//	reader; reading returns whatever is there, as in UNIX, and 0
+//	once the write end is closed and the pipe is empty.
+//
+//	Wakeups are batched.  A writer wakes the reader once per Write,
+//	or when the pipe fills, not once per byte; a reader wakes a
+//	waiting writer only when half the pipe is free.  And when a
+//	reader is already waiting on an empty pipe, a writer copies
+//	straight into the reader's buffer, skipping the ring.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "openfile.h"
+
+class Lock;
+class Condition;
+
+const int PipeSize = 4096;		// bytes a pipe holds
+
+class PipeBuffer
+{
+public:
+    PipeBuffer();			// An empty pipe, with both ends open
+    ~PipeBuffer();
+
+    int Read(char *into, int numBytes);	// Wait for data, and read up to
+    // "numBytes" of it; 0 at end of file
+    int Write(char *from, int numBytes);// Write all "numBytes", waiting for
+    // room; -1 if no one will read them
+    bool Close(bool writeEnd);		// Close one end; TRUE once both are
+
+private:
+    Lock *lock;				// protects all of the below
+    Condition *notEmpty;		// readers wait here
+    Condition *notFull;			// writers wait here
+
+    char *buffer;			// the ring
+    int head;				// where the oldest byte is
+    int count;				// bytes in the ring
+    bool readerOpen, writerOpen;	// are the ends still open?
+
+    char *readerBuffer;			// buffer of a reader waiting on an
+    int readerWanted;			// empty pipe, how much it asked for,
+    int readerGot;			// and how much a writer handed it
+};
+
+// One end of a pipe.
+class PipeEnd : public OpenFile
+{
+public:
+    PipeEnd(PipeBuffer *pipe, bool writeEnd);
+    ~PipeEnd();				// Close this end
+
+    int ReadAt(char *into, int numBytes, int position);
+    int WriteAt(char *from, int numBytes, int position);
+    // Read or write the pipe; a pipe has
+    // no position, so it is ignored
+    int Length();			// 0: a pipe has no length
+
+private:
+    PipeBuffer *pipe;
+    bool writeEnd;			// or the read end
+};
+
+#endif // PIPE_H
@@ -0,0 +1,151 @@
+// refcount.cc
+//	Routines to keep the table of sectors shared between cloned
+//	files.  See refcount.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "refcount.h"
+#include "main.h"
+#include "disktrace.h"
+
+//----------------------------------------------------------------------
+// RefCountTable::RefCountTable
+// 	Set up the in-memory copy of the table.  Nothing is read yet;
+//	blocks of the table are read in as they are first looked up.
+//	A fresh table is all zeroes, and written out whole.
+//
+//	"file" -- the file holding the table
+//	"numSectors" -- sectors in the volume
+//	"format" -- start a fresh table?
+//----------------------------------------------------------------------
+
+RefCountTable::RefCountTable(OpenFile *file, int numSectors, bool format)
+{
+    this->file = file;
+    this->numSectors = numSectors;
+    numBlocks = divRoundUp(numSectors, SectorSize);
+    counts = new unsigned char[numBlocks * SectorSize];
+    loaded = new bool[numBlocks];
+    dirty = new bool[numBlocks];
+    bzero(counts, numBlocks * SectorSize);
+    for (int i = 0; i < numBlocks; i++)
+        {
+            loaded[i] = format;
+            dirty[i] = format;
+        }
+    if (format)
+        {
+            WriteBack();
+        }
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::~RefCountTable
+//----------------------------------------------------------------------
+
+RefCountTable::~RefCountTable()
+{
+    delete [] counts;
+    delete [] loaded;
+    delete [] dirty;
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::Lookup
+// 	Make sure the block of the table holding "sector" is in memory,
+//	and return the entry's index in counts.
+//----------------------------------------------------------------------
+
+int
+RefCountTable::Lookup(int sector)
+{
+    int block = sector / SectorSize;
+
+    ASSERT((sector >= 0) && (sector < numSectors));
+    if (!loaded[block])
+        {
+            IOContextScope context(IOFreeMap);
+
+            file->ReadAt((char *) &counts[block * SectorSize], SectorSize,
+                         block * SectorSize);
+            loaded[block] = TRUE;
+        }
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::Sharers
+// 	Return how many files reference "sector" besides the first.
+//----------------------------------------------------------------------
+
+int
+RefCountTable::Sharers(int sector)
+{
+    return counts[Lookup(sector)];
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::Share
+// 	Count one more file referencing "sector".  The caller checks
+//	that it has fewer than MaxSharers sharers already.
+//----------------------------------------------------------------------
+
+void
+RefCountTable::Share(int sector)
+{
+    int i = Lookup(sector);
+
+    ASSERT(counts[i] < MaxSharers);
+    counts[i]++;
+    dirty[sector / SectorSize] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::Release
+// 	A file no longer references "sector".  Return TRUE if other
+//	files still do, and FALSE if it was the last one, so that the
+//	sector can be freed.
+//----------------------------------------------------------------------
+
+bool
+RefCountTable::Release(int sector)
+{
+    int i = Lookup(sector);
+
+    if (counts[i] == 0)
+        {
+            return FALSE;
+        }
+    counts[i]--;
+    dirty[sector / SectorSize] = TRUE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RefCountTable::WriteBack
+// 	Write the changed blocks of the table back to its file, each run
+//	of consecutive changed blocks in one write.
+//----------------------------------------------------------------------
+
+void
+RefCountTable::WriteBack()
+{
+    IOContextScope context(IOFreeMap);
+    int first, i = 0;
+
+    while (i < numBlocks)
+        {
+            if (!dirty[i])
+                {
+                    i++;
+                    continue;
+                }
+            for (first = i; (i < numBlocks) && dirty[i]; i++)
+                dirty[i] = FALSE;
+            file->WriteAt((char *) &counts[first * SectorSize],
+                          (i - first) * SectorSize, first * SectorSize);
+        }
+}
@@ -0,0 +1,56 @@
+// refcount.h
+//	Data structures to count the files sharing each disk sector.
+//
+//	A cloned file (see FileSystem::Clone) shares the data sectors of
+//	its source until one of them writes to a sector; the writer then
+//	gets a copy of its own ("copy on write").  The table keeps, for
+//	every sector, how many files reference it *beyond the first*, so
+//	that a volume without clones is all zeroes, and only sectors
+//	that are actually shared ever need an update.
+//
+//	The table is stored in a file, one byte per sector, whose header
+//	is in a well-known sector like the free map's.  It is kept in
+//	memory while Nachos runs, but read in a sector at a time, as
+//	entries are looked up, and only changed sectors are written back.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REFCOUNT_H
+#define REFCOUNT_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "openfile.h"
+
+const int MaxSharers = 255;		// extra references one byte can count
+
+class RefCountTable
+{
+public:
+    RefCountTable(OpenFile *file, int numSectors, bool format);
+    // Use the table in "file"; if "format",
+    // it starts out with nothing shared
+    ~RefCountTable();
+
+    int Sharers(int sector);		// Files referencing "sector",
+    // beyond the first
+    void Share(int sector);		// One more file references it
+    bool Release(int sector);		// One file less; TRUE if
+    // others still reference it
+
+    void WriteBack();			// Write changed entries to disk
+
+private:
+    OpenFile *file;			// where the table is kept
+    int numSectors;			// entries in the table
+    int numBlocks;			// sectors of the file
+    unsigned char *counts;		// extra references to each sector
+    bool *loaded;			// which blocks of counts were read in
+    bool *dirty;			// and which changed since
+
+    int Lookup(int sector);		// Read in the entry's block
+};
+
+#endif // REFCOUNT_H
@@ -7,8 +7,14 @@
 //
 //	Use a semaphore to synchronize the interrupt handlers with the
 //	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	handle one operation at a time, each disk keeps a queue of the
+//	requests waiting for it.
+//
+//	The volume may consist of several disks, striped and optionally
+//	mirrored; see synchdisk.h.  It may also be laid out as a log,
+//	in which case the sectors the file system asks for are remapped
+//	by the log (see lfs.h).  Above the log, recently used sectors
+//	are kept in a cache (see buffercache.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -16,20 +22,203 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "main.h"
+#include "disktrace.h"
+#include "lfs.h"
+#include "buffercache.h"
+#include "workqueue.h"
+
+//----------------------------------------------------------------------
+// DiskUnit::DiskUnit
+// 	Initialize one physical disk of the volume, with an empty queue.
+//
+//	"name" -- UNIX file holding the disk
+//	"queueDepth" -- how many requests the disk may order itself
+//----------------------------------------------------------------------
+
+DiskUnit::DiskUnit(char *name, int queueDepth)
+{
+    this->name = new char[strlen(name) + 1];
+    strcpy(this->name, name);
+    queue = new List<DiskRequest *>;
+    finished = new List<DiskRequest *>;
+    for (int i = 0; i < MaxQueueDepth; i++)
+        inDisk[i] = NULL;
+    numInDisk = 0;
+    numRequests = numQueued = maxLoad = totalLatency = 0;
+    disk = new Disk(this->name, this, queueDepth);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::~DiskUnit
+//----------------------------------------------------------------------
+
+DiskUnit::~DiskUnit()
+{
+    ASSERT(numInDisk == 0 && queue->IsEmpty());
+    delete disk;
+    delete queue;
+    delete finished;
+    delete [] name;
+}
 
+//----------------------------------------------------------------------
+// DiskUnit::Request
+// 	Hand a request to the disk now if it has room, otherwise queue
+//	it behind the others.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::Request(DiskRequest *request)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    request->start = kernel->stats->totalTicks;
+    numRequests++;
+    if (disk->IsFull())
+        {
+            numQueued++;
+        }
+    queue->Append(request);
+    if (Load() > maxLoad)
+        {
+            maxLoad = Load();
+        }
+    if (!disk->IsFull())
+        {
+            StartNext();
+        }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::StartNext
+// 	Hand the request at the front of the queue to the raw disk,
+//	tagged with a free slot.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::StartNext()
+{
+    DiskRequest *request;
+    int tag;
+
+    ASSERT(!disk->IsFull() && !queue->IsEmpty());
+
+    for (tag = 0; inDisk[tag] != NULL; tag++)
+        ;
+    request = queue->RemoveFront();
+    inDisk[tag] = request;
+    numInDisk++;
+    if (request->writing)
+        disk->WriteRequest(request->sector, request->data, tag);
+    else
+        disk->ReadRequest(request->sector, request->data, tag);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::CallBack
+// 	Disk interrupt handler.  Give the disk its next request, so it
+//	never waits for us, and leave waking up the thread waiting for
+//	the request that finished to the kernel's work queue.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::CallBack(int tag)
+{
+    DiskRequest *done = inDisk[tag];
+
+    ASSERT(done != NULL);
+    inDisk[tag] = NULL;
+    numInDisk--;
+    totalLatency += kernel->stats->totalTicks - done->start;
+    finished->Append(done);
+    if (!queue->IsEmpty())
+        {
+            StartNext();
+        }
+    kernel->workQueue->Enqueue(DiskUnit::Complete, this);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::Complete
+// 	Wake up the threads waiting for every request that has finished
+//	since we last ran.  Run by the work queue, with interrupts on.
+//
+//	"data" -- the disk unit
+//----------------------------------------------------------------------
+
+void
+DiskUnit::Complete(void *data)
+{
+    DiskUnit *unit = (DiskUnit *) data;
+    DiskRequest *done;
+
+    for (;;)
+        {
+            IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+            done = unit->finished->IsEmpty() ? NULL :
+                   unit->finished->RemoveFront();
+            (void) kernel->interrupt->SetLevel(oldLevel);
+            if (done == NULL)
+                break;
+            done->done->V();
+            delete done;
+        }
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::PrintStats
+//----------------------------------------------------------------------
+
+void
+DiskUnit::PrintStats()
+{
+    cout << "Disk " << name << ": requests " << numRequests;
+    cout << ", queued " << numQueued;
+    cout << ", max queue " << maxLoad;
+    if (numRequests > 0)
+        {
+            cout << ", mean latency " << totalLatency / numRequests;
+        }
+    cout << "\n";
+}
 
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
-// 	Initialize the synchronous interface to the physical disk, in turn
-//	initializing the physical disk.
+// 	Initialize the synchronous interface to the physical disks, in
+//	turn initializing the physical disks.  A single disk is kept in
+//	DISK_<host>; the disks of a larger volume in DISK_<host>_<i>.
 //
+//	"numDisks" -- how many disks make up the volume
+//	"mirror" -- keep every sector on two disks
+//	"queueDepth" -- requests each disk may have outstanding
+//	"cacheSectors" -- sectors to cache, 0 for no cache
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk()
+SynchDisk::SynchDisk(int numDisks, bool mirror, int queueDepth,
+                     int cacheSectors)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(this);
+    char name[32];
+
+    ASSERT((numDisks >= 1) && (numDisks <= MaxDisks));
+    ASSERT(!mirror || (numDisks % 2 == 0));
+    this->numDisks = numDisks;
+    this->mirror = mirror;
+    numSectors = (mirror ? numDisks / 2 : numDisks) * ::NumSectors;
+    log = NULL;
+    cache = (cacheSectors > 0) ? new BufferCache(cacheSectors) : NULL;
+    lock = new SpinLock("synch disk");
+    sprintf(warmName, "DISK_%d.warm", kernel->hostName);
+
+    for (int i = 0; i < numDisks; i++)
+        {
+            if (numDisks == 1)
+                sprintf(name, "DISK_%d", kernel->hostName);
+            else
+                sprintf(name, "DISK_%d_%d", kernel->hostName, i);
+            units[i] = new DiskUnit(name, queueDepth);
+        }
 }
 
 //----------------------------------------------------------------------
@@ -40,9 +229,77 @@ SynchDisk::SynchDisk()
 
 SynchDisk::~SynchDisk()
 {
-    delete disk;
+    delete cache;
+    delete log;
     delete lock;
-    delete semaphore;
+    for (int i = 0; i < numDisks; i++)
+        delete units[i];
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Queue
+// 	Queue the physical requests for one logical sector, and return
+//	how many there are (two for a mirrored write, otherwise one).
+//	"done" is V'ed as each of them completes.
+//
+//	Stripe unit s of the volume goes to disk (or pair) s % groups,
+//	at stripe unit s / groups on that disk.
+//
+//	With "-dt", each physical request is also logged to the trace,
+//	on behalf of the thread issuing it.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::Queue(int sectorNumber, char *data, bool writing,
+                 Semaphore *done)
+{
+    int groups = mirror ? numDisks / 2 : numDisks;
+    int stripe = sectorNumber / StripeSectors;
+    int group = stripe % groups;
+    int sector = (stripe / groups) * StripeSectors + sectorNumber % StripeSectors;
+    int first, count, which;
+    DiskRequest *request;
+
+    ASSERT((sectorNumber >= 0) && (sectorNumber < numSectors));
+
+    if (mirror)
+        {
+            first = 2 * group;
+            if (writing)  		// both copies
+                {
+                    count = 2;
+                    which = first;
+                }
+            else  			// the less busy copy
+                {
+                    count = 1;
+                    which = (units[first + 1]->Load() < units[first]->Load())
+                            ? first + 1 : first;
+                }
+        }
+    else
+        {
+            count = 1;
+            which = group;
+        }
+
+    for (int i = 0; i < count; i++)
+        {
+            request = new DiskRequest;
+            request->sector = sector;
+            request->data = data;
+            request->writing = writing;
+            request->done = done;
+            if (kernel->diskTrace != NULL)
+                {
+                    kernel->diskTrace->Record(kernel->stats->totalTicks,
+                                              which + i, sector, writing,
+                                              kernel->currentThread->getID(),
+                                              kernel->currentThread->getIOContext());
+                }
+            units[which + i]->Request(request);
+        }
+    return count;
 }
 
 //----------------------------------------------------------------------
@@ -57,10 +314,7 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    ReadSectors(1, &sectorNumber, data);
 }
 
 //----------------------------------------------------------------------
@@ -75,20 +329,258 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
+    WriteSectors(1, &sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read several sectors at once.  Those in the cache are copied
+//	from it; the requests for the others are all queued before we
+//	wait, so that each disk can work on its share while the others
+//	work on theirs.
+//
+//	The sectors read are cached afterwards, unless something was
+//	written while we waited, in which case what we read may already
+//	be out of date.
+//
+//	"numSectors" -- how many sectors to read
+//	"sectorNumbers" -- which ones
+//	"data" -- buffer for numSectors * SectorSize bytes
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int numSectors, int *sectorNumbers, char* data)
+{
+    int *which, *missing, numMissing = 0, writes;
+    char *buffer;
+
+    if (cache == NULL)
+        {
+            ReadUncached(numSectors, sectorNumbers, data);
+            return;
+        }
+
+    which = new int[numSectors];
+    missing = new int[numSectors];
+    for (int i = 0; i < numSectors; i++)
+        {
+            if (!cache->Read(sectorNumbers[i], &data[i * SectorSize]))
+                {
+                    which[numMissing] = i;
+                    missing[numMissing++] = sectorNumbers[i];
+                }
+        }
+    if (numMissing > 0)
+        {
+            buffer = new char[numMissing * SectorSize];
+            writes = cache->Writes();
+            ReadUncached(numMissing, missing, buffer);
+            for (int j = 0; j < numMissing; j++)
+                {
+                    bcopy(&buffer[j * SectorSize], &data[which[j] * SectorSize],
+                          SectorSize);
+                    if (cache->Writes() == writes)
+                        cache->Fill(missing[j], &buffer[j * SectorSize], FALSE);
+                }
+            delete [] buffer;
+        }
+    delete [] which;
+    delete [] missing;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadUncached
+// 	Read sectors from the log, or the volume if there is none,
+//	without looking in the cache.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadUncached(int numSectors, int *sectorNumbers, char* data)
+{
+    if (log != NULL)
+        log->Read(numSectors, sectorNumbers, data);
+    else
+        ReadPhysical(numSectors, sectorNumbers, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write several sectors at once, in parallel like ReadSectors.
+//	The cache is written through: its copies are brought up to date
+//	before the disk is.
+//
+//	"numSectors" -- how many sectors to write
+//	"sectorNumbers" -- which ones
+//	"data" -- numSectors * SectorSize bytes to write
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int numSectors, int *sectorNumbers, char* data)
+{
+    if (cache != NULL)
+        {
+            for (int i = 0; i < numSectors; i++)
+                cache->Update(sectorNumbers[i], &data[i * SectorSize]);
+        }
+    if (log != NULL)
+        log->Write(numSectors, sectorNumbers, data);
+    else
+        WritePhysical(numSectors, sectorNumbers, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadPhysical
+// 	Read sectors of the volume itself, whether or not it holds a
+//	log.  The requests are queued under the disk lock, which is let
+//	go before we wait for them.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadPhysical(int numSectors, int *sectorNumbers, char* data)
+{
+    Semaphore *done = new Semaphore("synch disk", 0);
+    int pending = 0;
+
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++)
+        pending += Queue(sectorNumbers[i], &data[i * SectorSize], FALSE, done);
     lock->Release();
+    while (pending-- > 0)
+        done->P();			// wait for interrupts
+    delete done;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WritePhysical
+// 	Write sectors of the volume itself, whether or not it holds a
+//	log, queueing the requests under the disk lock.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WritePhysical(int numSectors, int *sectorNumbers, char* data)
+{
+    Semaphore *done = new Semaphore("synch disk", 0);
+    int pending = 0;
+
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++)
+        pending += Queue(sectorNumbers[i], &data[i * SectorSize], TRUE, done);
+    lock->Release();
+    while (pending-- > 0)
+        done->P();			// wait for interrupts
+    delete done;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::MountLog
+// 	Switch to the log-structured layout, if asked to format the
+//	volume that way or if the volume already holds a log.
+//
+//	"format" -- lay out a fresh log
+//----------------------------------------------------------------------
+
+void
+SynchDisk::MountLog(bool format)
+{
+    ASSERT(log == NULL);
+    if (format || SegmentLog::IsPresent(this))
+        {
+            log = new SegmentLog(this, format);
+        }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::BeginBatch, EndBatch
+// 	Bracket a file system operation, so that with a log its writes
+//	go to disk together when it is done.  Without a log, writes are
+//	never held back.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::BeginBatch()
+{
+    if (log != NULL)
+        log->BeginBatch();
+}
+
+void
+SynchDisk::EndBatch()
+{
+    if (log != NULL)
+        log->EndBatch();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Warmup
+// 	Read the sectors named in the warm file into the cache, before
+//	the file system is mounted.  They are read in increasing order
+//	and queued all at once, so each disk serves its share in one
+//	sweep, instead of one read at a time as the mount asks for them.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Warmup()
+{
+    int sectors[WarmSectors], count;
+    char *buffer;
+
+    if (cache == NULL)
+        {
+            return;
+        }
+    count = cache->LoadWarm(warmName, sectors, NumSectors());
+    if (count == 0)
+        {
+            return;
+        }
+    DEBUG(dbgFile, "Warming up " << count << " sectors from " << warmName);
+    buffer = new char[count * SectorSize];
+    ReadUncached(count, sectors, buffer);
+    for (int i = 0; i < count; i++)
+        cache->Fill(sectors[i], &buffer[i * SectorSize], TRUE);
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::SaveWarmup
+// 	Record the sectors this run read most, for the next one to
+//	warm up with.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::SaveWarmup()
+{
+    if (cache != NULL)
+        cache->SaveWarm(warmName);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::NumSectors
+// 	Return how many sectors the file system may use: the whole
+//	volume, or what the log offers.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::NumSectors()
+{
+    return (log != NULL) ? log->NumSectors() : numSectors;
 }
 
 //----------------------------------------------------------------------
-// SynchDisk::CallBack
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// SynchDisk::PrintStats
+// 	Print how busy each disk was, and how often threads queueing
+//	requests had to spin on the disk lock, e.g. to see how the volume
+//	scales in SMP mode.
 //----------------------------------------------------------------------
 
 void
-SynchDisk::CallBack()
+SynchDisk::PrintStats()
 {
-    semaphore->V();
+    for (int i = 0; i < numDisks; i++)
+        units[i]->PrintStats();
+    lock->PrintStats();
+    if (log != NULL)
+        log->PrintStats();
+    if (cache != NULL)
+        cache->PrintStats();
 }
@@ -14,6 +14,71 @@
 #include "disk.h"
 #include "synch.h"
 #include "callback.h"
+#include "list.h"
+
+class SegmentLog;
+class BufferCache;
+
+const int MaxDisks = 8;			// most disks in one volume
+const int StripeSectors = 8;		// sectors per stripe unit
+
+// A request waiting for, or being served by, one physical disk.
+class DiskRequest
+{
+public:
+    int sector;				// sector on the physical disk
+    char *data;				// where to read into / write from
+    bool writing;
+    Semaphore *done;			// V'ed when the request completes
+    int start;				// when it was requested
+};
+
+// The following class defines one physical disk of a volume, with
+// its own queue of requests.  The raw disk takes up to "queueDepth"
+// requests at a time (just one, unless "-ncq" is given) and orders
+// them itself; the others wait in the queue and are handed to the
+// disk by the interrupt handler as earlier ones complete, so the
+// disks of a volume all work at the same time.
+
+class DiskUnit : public TaggedCallBackObj
+{
+public:
+    DiskUnit(char *name, int queueDepth);
+    // Initialize a disk and its queue
+    ~DiskUnit();
+
+    void Request(DiskRequest *request);	// Queue a request, start it if
+    // the disk has room.  Returns right
+    // away; request->done is V'ed later.
+    int Load()
+    {
+        return queue->NumInList() + numInDisk;
+    }
+    // requests queued or in progress
+
+    void CallBack(int tag);		// Disk interrupt handler, "tag"
+    // is the slot of the request
+    static void Complete(void *data);	// Wake up the threads whose
+    // requests finished; run by the
+    // kernel's work queue
+
+    void PrintStats();			// Print how busy the disk was
+
+private:
+    Disk *disk;				// Raw disk device
+    List<DiskRequest *> *queue;		// Requests not yet given to the disk
+    DiskRequest *inDisk[MaxQueueDepth];	// Requests given to the disk, by tag
+    List<DiskRequest *> *finished;	// Requests done, waiter not yet woken
+    int numInDisk;
+    char *name;
+
+    int numRequests;			// requests served
+    int numQueued;			// ... of which had to wait
+    int maxLoad;			// deepest the queue got
+    int totalLatency;			// ticks from request to completion
+
+    void StartNext();			// hand the next request to the disk
+};
 
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
@@ -25,12 +90,22 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// The volume may span several disks ("-disks N").  Logical sectors are
+// striped over the disks in units of StripeSectors sectors (RAID-0).
+// With mirroring ("-mirror"), the disks are paired up, both disks of a
+// pair hold the same data, and the stripes go over the pairs (RAID-1,
+// or RAID-10 with more than one pair): writes go to both disks of the
+// pair, reads to the one with the shorter queue.  Multi-sector
+// requests are spread over the disks and served in parallel.
 
-class SynchDisk : public CallBackObj
+class SynchDisk
 {
 public:
-    SynchDisk();    		        // Initialize a synchronous disk,
-    // by initializing the raw Disk.
+    SynchDisk(int numDisks, bool mirror, int queueDepth, int cacheSectors);
+    // Initialize a synchronous disk,
+    // by initializing the raw Disks,
+    // with a cache of "cacheSectors"
     ~SynchDisk();			// De-allocate the synch disk data
 
     void ReadSector(int sectorNumber, char* data);
@@ -41,16 +116,54 @@ public:
     // then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
 
-    void CallBack();			// Called by the disk device interrupt
-    // handler, to signal that the
-    // current disk operation is complete.
+    void ReadSectors(int numSectors, int *sectorNumbers, char* data);
+    void WriteSectors(int numSectors, int *sectorNumbers, char* data);
+    // Read/write several sectors, to or
+    // from consecutive SectorSize chunks
+    // of "data", using all the disks in
+    // parallel.
+
+    void ReadPhysical(int numSectors, int *sectorNumbers, char* data);
+    void WritePhysical(int numSectors, int *sectorNumbers, char* data);
+    // The same, bypassing the log; used
+    // by the log itself.
+
+    void MountLog(bool format);		// Use the log-structured layout
+    // (lfs.h): a fresh one if "format",
+    // else the one on the volume, if any
+    void BeginBatch();			// With a log, hold back writes
+    void EndBatch();			// until the outermost batch ends
+
+    void Warmup();			// Read in the sectors the last run
+    // used most (buffercache.h)
+    void SaveWarmup();			// Record the ones this run used
+
+    int NumSectors();			// size of the volume, in sectors
+    int NumPhysicalSectors()
+    {
+        return numSectors;
+    }
+    // ... not counting the log's overhead
+
+    void PrintStats();			// Print how busy each disk was,
+    // and how contended the disk lock
 
 private:
-    Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread
-    // with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-    // can be sent to the disk at a time
+    DiskUnit *units[MaxDisks];		// the physical disks
+    int numDisks;
+    bool mirror;			// disks 2i and 2i+1 are copies
+    int numSectors;			// sectors in the volume
+    SegmentLog *log;			// remaps every sector, if not NULL
+    BufferCache *cache;			// recently used sectors, or NULL
+    char warmName[32];			// file naming the sectors to warm up
+    SpinLock *lock;			// only one thread queues requests
+    // at a time
+
+    void ReadUncached(int numSectors, int *sectorNumbers, char* data);
+    // read past the cache
+    int Queue(int sectorNumber, char *data, bool writing,
+              Semaphore *done);		// queue requests for one logical
+    // sector, return how many
 };
 
 #endif // SYNCHDISK_H
@@ -0,0 +1,489 @@
+// tmpfs.cc
+//	Routines for a file system kept in memory.  See tmpfs.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "tmpfs.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// HashName
+// 	Hash a path name, for MemFileSystem's table.
+//----------------------------------------------------------------------
+
+static unsigned
+HashName(char *name)
+{
+    unsigned hash = 0;
+
+    for (; *name != '\0'; name++)
+        hash = hash * 31 + (unsigned char) *name;
+    return hash;
+}
+
+//----------------------------------------------------------------------
+// MemFile::MemFile
+// 	Initialize an empty file or directory.
+//
+//	"name" -- its path below the mount point
+//	"directoryFlag" -- is it a directory?
+//----------------------------------------------------------------------
+
+MemFile::MemFile(char *name, bool directoryFlag)
+{
+    this->name = new char[strlen(name) + 1];
+    strcpy(this->name, name);
+    this->directoryFlag = directoryFlag;
+    length = 0;
+    pages = NULL;
+    numPages = 0;
+    numOpen = 0;
+    removed = FALSE;
+    parent = firstChild = prevSibling = nextSibling = nextHash = NULL;
+}
+
+//----------------------------------------------------------------------
+// MemFile::~MemFile
+// 	De-allocate the file and its data.
+//----------------------------------------------------------------------
+
+MemFile::~MemFile()
+{
+    for (int i = 0; i < numPages; i++)
+        delete [] pages[i];
+    delete [] pages;
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// MemFile::Page
+// 	Return page "page" of the file's data, allocating it, zeroed,
+//	if it was never written.  The page table doubles as needed.
+//----------------------------------------------------------------------
+
+char *
+MemFile::Page(int page)
+{
+    if (page >= numPages)
+        {
+            int size = (numPages == 0) ? 8 : numPages;
+            char **bigger;
+
+            while (size <= page)
+                size *= 2;
+            bigger = new char *[size];
+            for (int i = 0; i < size; i++)
+                bigger[i] = (i < numPages) ? pages[i] : NULL;
+            delete [] pages;
+            pages = bigger;
+            numPages = size;
+        }
+    if (pages[page] == NULL)
+        {
+            pages[page] = new char[PageSize];
+            bzero(pages[page], PageSize);
+        }
+    return pages[page];
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::MemFileSystem
+// 	Initialize an empty tmpfs: just its root directory.
+//
+//	"mountPoint" -- where it is mounted, e.g. "/tmp"
+//----------------------------------------------------------------------
+
+MemFileSystem::MemFileSystem(char *mountPoint)
+{
+    int length = strlen(mountPoint);
+
+    ASSERT(mountPoint[0] == '/');
+    while ((length > 0) && (mountPoint[length - 1] == '/'))
+        length--;			// "/tmp/" is "/tmp", "/" is ""
+    this->mountPoint = new char[length + 1];
+    strncpy(this->mountPoint, mountPoint, length);
+    this->mountPoint[length] = '\0';
+
+    numBuckets = 64;
+    buckets = new MemFile *[numBuckets];
+    for (int i = 0; i < numBuckets; i++)
+        buckets[i] = NULL;
+    numFiles = 0;
+    root = new MemFile("", TRUE);
+    Insert(root);
+    DEBUG(dbgFile, "Mounted a tmpfs at " << mountPoint);
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::~MemFileSystem
+// 	De-allocate every file, open or not; Nachos is halting.
+//----------------------------------------------------------------------
+
+MemFileSystem::~MemFileSystem()
+{
+    MemFile *file;
+
+    for (int i = 0; i < numBuckets; i++)
+        {
+            while ((file = buckets[i]) != NULL)
+                {
+                    buckets[i] = file->nextHash;
+                    delete file;
+                }
+        }
+    delete [] buckets;
+    delete [] mountPoint;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Covers
+// 	Return TRUE if "name" is the mount point or below it, and set
+//	"rest" to what follows the mount point ("" for the mount point
+//	itself).
+//----------------------------------------------------------------------
+
+bool
+MemFileSystem::Covers(char *name, char **rest)
+{
+    int length = strlen(mountPoint);
+
+    if ((strncmp(name, mountPoint, length) != 0)
+            || ((name[length] != '\0') && (name[length] != '/')))
+        {
+            return FALSE;
+        }
+    *rest = &name[length];
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Find
+// 	Return the file called "name", or NULL if there is none.
+//----------------------------------------------------------------------
+
+MemFile *
+MemFileSystem::Find(char *name)
+{
+    MemFile *file = buckets[HashName(name) % numBuckets];
+
+    while ((file != NULL) && (strcmp(file->name, name) != 0))
+        file = file->nextHash;
+    return file;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Insert
+// 	Enter "file" in the hash table, doubling the table when it has
+//	more files than buckets.
+//----------------------------------------------------------------------
+
+void
+MemFileSystem::Insert(MemFile *file)
+{
+    int bucket;
+
+    if (numFiles >= numBuckets)
+        {
+            MemFile **old = buckets, *next;
+            int oldSize = numBuckets;
+
+            numBuckets *= 2;
+            buckets = new MemFile *[numBuckets];
+            for (int i = 0; i < numBuckets; i++)
+                buckets[i] = NULL;
+            for (int i = 0; i < oldSize; i++)
+                {
+                    for (MemFile *f = old[i]; f != NULL; f = next)
+                        {
+                            next = f->nextHash;
+                            bucket = HashName(f->name) % numBuckets;
+                            f->nextHash = buckets[bucket];
+                            buckets[bucket] = f;
+                        }
+                }
+            delete [] old;
+        }
+    bucket = HashName(file->name) % numBuckets;
+    file->nextHash = buckets[bucket];
+    buckets[bucket] = file;
+    numFiles++;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Unlink
+// 	Take "file" out of the hash table and out of its directory.
+//----------------------------------------------------------------------
+
+void
+MemFileSystem::Unlink(MemFile *file)
+{
+    MemFile **link = &buckets[HashName(file->name) % numBuckets];
+
+    while (*link != file)
+        link = &(*link)->nextHash;
+    *link = file->nextHash;
+    numFiles--;
+
+    if (file->prevSibling != NULL)
+        file->prevSibling->nextSibling = file->nextSibling;
+    else
+        file->parent->firstChild = file->nextSibling;
+    if (file->nextSibling != NULL)
+        file->nextSibling->prevSibling = file->prevSibling;
+    file->parent = file->prevSibling = file->nextSibling = NULL;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Create
+// 	Create a file or directory.  The data of a file is only
+//	allocated as it is written; until then it reads as zeroes.
+//
+//	Return FALSE if the name exists already, or its directory does
+//	not.
+//
+//	"name" -- path of the new file below the mount point
+//	"initialSize" -- its length
+//	"directoryFlag" -- is it a directory?
+//----------------------------------------------------------------------
+
+bool
+MemFileSystem::Create(char *name, int initialSize, bool directoryFlag)
+{
+    char *slash = strrchr(name, '/'), *parentName;
+    MemFile *parent, *file;
+
+    if ((slash == NULL) || (slash[1] == '\0') || (Find(name) != NULL))
+        {
+            return FALSE;
+        }
+    parentName = new char[slash - name + 1];
+    strncpy(parentName, name, slash - name);
+    parentName[slash - name] = '\0';
+    parent = Find(parentName);
+    delete [] parentName;
+    if ((parent == NULL) || !parent->directoryFlag)
+        {
+            return FALSE;
+        }
+
+    DEBUG(dbgFile, "Creating tmpfs file " << mountPoint << name);
+    file = new MemFile(name, directoryFlag);
+    file->length = directoryFlag ? 0 : initialSize;
+    file->parent = parent;
+    file->nextSibling = parent->firstChild;
+    if (parent->firstChild != NULL)
+        parent->firstChild->prevSibling = file;
+    parent->firstChild = file;
+    Insert(file);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Open
+// 	Open a file for reading and writing.  Return NULL if there is
+//	no such file.
+//
+//	"name" -- path of the file below the mount point
+//----------------------------------------------------------------------
+
+OpenFile *
+MemFileSystem::Open(char *name)
+{
+    MemFile *file = Find(name);
+
+    if ((file == NULL) || file->directoryFlag)
+        {
+            return NULL;
+        }
+    file->numOpen++;
+    return new MemOpenFile(this, file);
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Remove
+// 	Remove a file, or with "recursiveFlag" a directory and all it
+//	holds.  Return FALSE if there is no such file, or it is a
+//	directory and "recursiveFlag" is not set.  The tmpfs root stays.
+//
+//	"name" -- path of the file below the mount point
+//----------------------------------------------------------------------
+
+bool
+MemFileSystem::Remove(char *name, bool recursiveFlag)
+{
+    MemFile *file = Find(name);
+
+    if ((file == NULL) || (file == root)
+            || (file->directoryFlag && !recursiveFlag))
+        {
+            return FALSE;
+        }
+    DEBUG(dbgFile, "Removing tmpfs file " << mountPoint << name);
+    Detach(file);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Detach
+// 	Take "file" and, if it is a directory, everything in it out of
+//	the tmpfs.  Files that are open are de-allocated when closed.
+//----------------------------------------------------------------------
+
+void
+MemFileSystem::Detach(MemFile *file)
+{
+    while (file->firstChild != NULL)
+        Detach(file->firstChild);
+    Unlink(file);
+    file->removed = TRUE;
+    if (file->numOpen == 0)
+        {
+            delete file;
+        }
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::Close
+// 	An OpenFile for "file" was closed; if it was the last, and the
+//	file has been removed, de-allocate it.
+//----------------------------------------------------------------------
+
+void
+MemFileSystem::Close(MemFile *file)
+{
+    ASSERT(file->numOpen > 0);
+    file->numOpen--;
+    if ((file->numOpen == 0) && file->removed)
+        {
+            delete file;
+        }
+}
+
+//----------------------------------------------------------------------
+// MemFileSystem::List
+// 	List the entries of a directory, as Directory::List does, and
+//	with "recursiveFlag" what they hold, indented.
+//
+//	"name" -- path of the directory below the mount point
+//----------------------------------------------------------------------
+
+void
+MemFileSystem::List(char *name, bool recursiveFlag)
+{
+    MemFile *dir = Find(name);
+
+    if ((dir != NULL) && dir->directoryFlag)
+        {
+            ListDirectory(dir, 0, recursiveFlag);
+        }
+}
+
+void
+MemFileSystem::ListDirectory(MemFile *dir, int level, bool recursiveFlag)
+{
+    for (MemFile *file = dir->firstChild; file != NULL; file = file->nextSibling)
+        {
+            for (int j = 0; j < level; j++)
+                printf(" ");
+            printf("%s\n", strrchr(file->name, '/'));
+            if (recursiveFlag && file->directoryFlag)
+                ListDirectory(file, level + 1, recursiveFlag);
+        }
+}
+
+//----------------------------------------------------------------------
+// MemOpenFile::MemOpenFile
+// 	Open a tmpfs file.  MemFileSystem::Open has counted it open.
+//----------------------------------------------------------------------
+
+MemOpenFile::MemOpenFile(MemFileSystem *fileSystem, MemFile *file)
+{
+    this->fileSystem = fileSystem;
+    this->file = file;
+}
+
+//----------------------------------------------------------------------
+// MemOpenFile::~MemOpenFile
+//----------------------------------------------------------------------
+
+MemOpenFile::~MemOpenFile()
+{
+    fileSystem->Close(file);
+}
+
+//----------------------------------------------------------------------
+// MemOpenFile::ReadAt
+// 	Copy data out of the file's pages; pages never written read as
+//	zeroes.  Return the number of bytes read, which is less than
+//	"numBytes" at the end of the file.
+//----------------------------------------------------------------------
+
+int
+MemOpenFile::ReadAt(char *into, int numBytes, int position)
+{
+    int done = 0, page, offset, chunk;
+
+    if ((numBytes <= 0) || (position < 0) || (position >= file->length))
+        {
+            return 0;
+        }
+    if (position + numBytes > file->length)
+        numBytes = file->length - position;
+    while (done < numBytes)
+        {
+            page = (position + done) / PageSize;
+            offset = (position + done) % PageSize;
+            chunk = min(PageSize - offset, numBytes - done);
+            if ((page < file->numPages) && (file->pages[page] != NULL))
+                bcopy(&file->pages[page][offset], &into[done], chunk);
+            else
+                bzero(&into[done], chunk);
+            done += chunk;
+        }
+    return numBytes;
+}
+
+//----------------------------------------------------------------------
+// MemOpenFile::WriteAt
+// 	Copy data into the file's pages, allocating them as needed.
+//	Writing past the end makes the file longer.
+//----------------------------------------------------------------------
+
+int
+MemOpenFile::WriteAt(char *from, int numBytes, int position)
+{
+    int done = 0, page, offset, chunk;
+
+    if ((numBytes <= 0) || (position < 0))
+        {
+            return 0;
+        }
+    while (done < numBytes)
+        {
+            page = (position + done) / PageSize;
+            offset = (position + done) % PageSize;
+            chunk = min(PageSize - offset, numBytes - done);
+            bcopy(&from[done], &file->Page(page)[offset], chunk);
+            done += chunk;
+        }
+    if (position + numBytes > file->length)
+        file->length = position + numBytes;
+    return numBytes;
+}
+
+//----------------------------------------------------------------------
+// MemOpenFile::Length
+//----------------------------------------------------------------------
+
+int
+MemOpenFile::Length()
+{
+    return file->length;
+}
+
+#endif // FILESYS_STUB
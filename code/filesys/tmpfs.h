@@ -0,0 +1,109 @@
+// tmpfs.h
+//	Data structures for a file system kept in memory ("tmpfs").
+//
+//	A tmpfs is mounted at a path of the Nachos file system ("-tmpfs
+//	/tmp"); FileSystem hands every name at or below that path to it
+//	instead of to the disk.  Its files last until Nachos halts, and
+//	never cost a disk request: scratch files are created, written
+//	and removed without touching the headers, the directories or
+//	the free map on the disk.
+//
+//	Files are found by name in a hash table, so creating, opening
+//	and removing one takes constant time, however many files there
+//	are.  Each directory also links its entries together, for
+//	listing them and removing them with it.  The data of a file is
+//	kept in pages of PageSize bytes, allocated when first written;
+//	unlike a file on the disk, a tmpfs file grows as it is written
+//	past its end.
+//
+//	As in UNIX, a file removed while it is open goes away only when
+//	the last OpenFile for it is closed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef TMPFS_H
+#define TMPFS_H
+
+#include "openfile.h"
+
+// One file or directory of a tmpfs.
+class MemFile
+{
+public:
+    MemFile(char *name, bool directoryFlag);
+    ~MemFile();
+
+    char *name;				// path below the mount point, e.g.
+    // "/a/f"; the tmpfs root is ""
+    bool directoryFlag;
+    int length;				// bytes in the file
+    char **pages;			// its data; a NULL page reads as 0
+    int numPages;			// room in "pages"
+    int numOpen;			// OpenFiles for it
+    bool removed;			// no longer in the tmpfs
+
+    MemFile *parent;			// directory holding it
+    MemFile *firstChild;		// if a directory, its entries
+    MemFile *prevSibling;		// the other entries of "parent"
+    MemFile *nextSibling;
+    MemFile *nextHash;			// next file in the same hash bucket
+
+    char *Page(int page);		// page "page" of the data, allocated
+    // if need be
+};
+
+class MemFileSystem
+{
+public:
+    MemFileSystem(char *mountPoint);	// An empty tmpfs at "mountPoint"
+    ~MemFileSystem();
+
+    bool Covers(char *name, char **rest);
+    // Is "name" in this tmpfs?  If so,
+    // "rest" is its path below the mount
+    // point
+
+    bool Create(char *name, int initialSize, bool directoryFlag);
+    OpenFile *Open(char *name);
+    bool Remove(char *name, bool recursiveFlag);
+    void List(char *name, bool recursiveFlag);
+    // As in FileSystem, with "name" taken
+    // below the mount point
+
+    void Close(MemFile *file);		// An OpenFile for "file" is closed
+
+private:
+    char *mountPoint;			// "" if mounted at "/"
+    MemFile *root;
+    MemFile **buckets;			// the files, by hash of their name
+    int numBuckets;
+    int numFiles;
+
+    MemFile *Find(char *name);		// the file called "name", or NULL
+    void Insert(MemFile *file);		// enter it in the hash table,
+    void Unlink(MemFile *file);		// or take it out
+    void Detach(MemFile *file);		// remove it and what it holds
+    void ListDirectory(MemFile *dir, int level, bool recursiveFlag);
+};
+
+// An open file of a tmpfs.
+class MemOpenFile : public OpenFile
+{
+public:
+    MemOpenFile(MemFileSystem *fileSystem, MemFile *file);
+    ~MemOpenFile();
+
+    int ReadAt(char *into, int numBytes, int position);
+    int WriteAt(char *from, int numBytes, int position);
+    int Length();
+
+private:
+    MemFileSystem *fileSystem;
+    MemFile *file;
+};
+
+#endif // TMPFS_H
@@ -126,6 +126,41 @@ Bitmap::FindAndSet()
     return -1;
 }
 
+//----------------------------------------------------------------------
+// Bitmap::FindAndSet
+// 	Return the number of the first clear bit at or after "from",
+//	wrapping around to bit 0, and set it.  Used to allocate disk
+//	sectors close to a given one.  Words with every bit set are
+//	skipped whole.
+//
+//	If no bits are clear, return -1.
+//
+//	"from" -- where to start looking
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindAndSet(int from)
+{
+    ASSERT(from >= 0 && from < numBits);
+
+    for (int n = 0; n < numBits; n++)
+        {
+            int i = (from + n) % numBits;
+
+            if (i % BitsInWord == 0 && map[i / BitsInWord] == ~0u)
+                {
+                    n += BitsInWord - 1;		// whole word in use
+                    continue;
+                }
+            if (!Test(i))
+                {
+                    Mark(i);
+                    return i;
+                }
+        }
+    return -1;
+}
+
 //----------------------------------------------------------------------
 // Bitmap::NumClear
 // 	Return the number of clear bits in the bitmap.
@@ -147,6 +182,27 @@ Bitmap::NumClear() const
     return count;
 }
 
+//----------------------------------------------------------------------
+// Bitmap::NumClear
+// 	Return the number of clear bits among bits from .. to-1.
+//----------------------------------------------------------------------
+
+int
+Bitmap::NumClear(int from, int to) const
+{
+    int count = 0;
+
+    ASSERT(from >= 0 && from <= to && to <= numBits);
+    for (int i = from; i < to; i++)
+        {
+            if (!Test(i))
+                {
+                    count++;
+                }
+        }
+    return count;
+}
+
 //----------------------------------------------------------------------
 // Bitmap::Print
 // 	Print the contents of the bitmap, for debugging.
@@ -43,7 +43,12 @@ public:
     int FindAndSet();         // Return the # of a clear bit, and as a side
     // effect, set the bit.
     // If no bits are clear, return -1.
+    int FindAndSet(int from);	// Same, but return the first clear bit
+    // at or after "from", wrapping around
+    // to the start if there is none
     int NumClear() const;	// Return the number of clear bits
+    int NumClear(int from, int to) const;
+    // ... among bits from .. to-1
 
     void Print() const;		// Print contents of bitmap
     void SelfTest();		// Test whether bitmap is working
@@ -41,7 +41,7 @@ private:
     char *enableFlags;		// controls which DEBUG messages are printed
 };
 
-extern Debug *debug;
+extern __thread Debug *debug;	// one per simulated machine
 
 
 //----------------------------------------------------------------------
@@ -47,9 +47,16 @@
 #define NO_MPROT
 #endif
 
+#ifdef LINUX	// host threads can sleep on a word with a futex
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 extern "C" {
 #include <signal.h>
 #include <sys/types.h>
+#include <pthread.h>
+#include <sched.h>
 
 #ifndef NO_MPROT
 #include <sys/mman.h>
@@ -175,12 +182,33 @@ Exit(int exitCode)
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
 //	now obsolete "srand" and "rand" because they are more portable!
+//	Once RandomPerHostThread has been called, each host thread keeps
+//	a state of its own instead, so that several simulated machines in
+//	one process ("-hosts N") each get a repeatable sequence.
 //----------------------------------------------------------------------
 
+static bool randomPerThread = FALSE;
+static __thread unsigned int randomState = 1;
+
 void
 RandomInit(unsigned seed)
 {
-    srand(seed);
+    if (randomPerThread)
+        randomState = seed;
+    else
+        srand(seed);
+}
+
+//----------------------------------------------------------------------
+// RandomPerHostThread
+// 	Give every host thread its own random number sequence.  Call it
+//	before starting the host threads.
+//----------------------------------------------------------------------
+
+void
+RandomPerHostThread()
+{
+    randomPerThread = TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -191,9 +219,105 @@ RandomInit(unsigned seed)
 unsigned int
 RandomNumber()
 {
+    if (randomPerThread)
+        return rand_r(&randomState);
     return rand();
 }
 
+//----------------------------------------------------------------------
+// StartHostThread
+// 	Start a UNIX thread running "func(arg)", and return its id.
+//	Used to run several simulated machines in one process.
+//----------------------------------------------------------------------
+
+unsigned long
+StartHostThread(HostThreadFunc func, void *arg)
+{
+    pthread_t id;
+    int retVal;
+
+    retVal = pthread_create(&id, NULL, func, arg);
+    ASSERT(retVal == 0);
+    return (unsigned long) id;
+}
+
+//----------------------------------------------------------------------
+// JoinHostThread
+// 	Wait for a thread started by StartHostThread to finish.
+//----------------------------------------------------------------------
+
+void
+JoinHostThread(unsigned long id)
+{
+    (void) pthread_join((pthread_t) id, NULL);
+}
+
+//----------------------------------------------------------------------
+// ExitHostThread
+// 	Terminate the calling host thread, leaving the rest of the
+//	process running.  This may be called on the stack of any Nachos
+//	thread, which the UNIX thread library did not allocate, so we
+//	cannot use pthread_exit: it unwinds the stack, and on a Nachos
+//	stack there is nothing to unwind to.  Instead the thread leaves
+//	through the system call, which still wakes up JoinHostThread.
+//	Anything the thread holds must have been handed off before.
+//----------------------------------------------------------------------
+
+void
+ExitHostThread()
+{
+#ifdef LINUX
+    (void) syscall(SYS_exit, 0);
+#else
+    pthread_exit(NULL);
+#endif
+}
+
+//----------------------------------------------------------------------
+// YieldHostThread
+// 	Let another host thread run, while waiting for it to make
+//	progress.
+//----------------------------------------------------------------------
+
+void
+YieldHostThread()
+{
+    (void) sched_yield();
+}
+
+//----------------------------------------------------------------------
+// WaitHostWord
+// 	Put the calling host thread to sleep while "*word" still holds
+//	"value", until another host thread calls WakeHostWord on it.  May
+//	return early, so callers check the word again.  Without futexes,
+//	just let another host thread run.
+//----------------------------------------------------------------------
+
+void
+WaitHostWord(volatile unsigned int *word, unsigned int value)
+{
+#ifdef LINUX
+    (void) syscall(SYS_futex, (unsigned int *) word, FUTEX_WAIT, value,
+                   NULL, NULL, 0);
+#else
+    YieldHostThread();
+#endif
+}
+
+//----------------------------------------------------------------------
+// WakeHostWord
+// 	Wake up the host threads sleeping in WaitHostWord on "word".
+//----------------------------------------------------------------------
+
+void
+WakeHostWord(volatile unsigned int *word)
+{
+#ifdef LINUX
+    (void) syscall(SYS_futex, (unsigned int *) word, FUTEX_WAKE, 0x7fffffff,
+                   NULL, NULL, 0);
+#endif
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before
@@ -379,6 +503,27 @@ Lseek(int fd, int offset, int whence)
     ASSERT(retVal >= 0);
 }
 
+//----------------------------------------------------------------------
+// ReadAt/WriteAt
+// 	Read/write characters at "offset" in an open file, without
+//	moving its file pointer, so that a host thread other than the
+//	one using the file pointer may call them.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+ReadAt(int fd, char *buffer, int nBytes, int offset)
+{
+    int retVal = pread(fd, buffer, nBytes, offset);
+    ASSERT(retVal == nBytes);
+}
+
+void
+WriteAt(int fd, char *buffer, int nBytes, int offset)
+{
+    int retVal = pwrite(fd, buffer, nBytes, offset);
+    ASSERT(retVal == nBytes);
+}
+
 //----------------------------------------------------------------------
 // Tell
 // 	Report the current location within an open file.
@@ -30,8 +30,18 @@ extern void CallOnUserAbort(void (*cleanup)(int));
 
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
+extern void RandomPerHostThread();	// one sequence per host thread
 extern unsigned int RandomNumber();
 
+// Host threads, for running several simulated machines in one process
+typedef void *(*HostThreadFunc)(void *arg);
+extern unsigned long StartHostThread(HostThreadFunc func, void *arg);
+extern void JoinHostThread(unsigned long id);
+extern void ExitHostThread();
+extern void YieldHostThread();
+extern void WaitHostWord(volatile unsigned int *word, unsigned int value);
+extern void WakeHostWord(volatile unsigned int *word);
+
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
@@ -49,6 +59,8 @@ extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
+extern void ReadAt(int fd, char *buffer, int nBytes, int offset);
+extern void WriteAt(int fd, char *buffer, int nBytes, int offset);
 extern int Tell(int fd);
 extern int Close(int fd);
 extern bool Unlink(char *name);
@@ -42,4 +42,17 @@ protected:
     virtual ~CallBackObj() {};
 };
 
+// Abstract base class for objects that register callbacks for
+// devices with several requests outstanding at once; the device
+// passes back the tag of the request that completed.
+
+class TaggedCallBackObj
+{
+public:
+    virtual void CallBack(int tag) = 0;
+protected:
+    TaggedCallBackObj() {};
+    virtual ~TaggedCallBackObj() {};
+};
+
 #endif
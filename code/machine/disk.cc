@@ -34,20 +34,26 @@ const int DiskSize = (MagicSize + (NumSectors * SectorSize));
 //	if it doesn't exist), and check the magic number to make sure it's
 // 	ok to treat it as Nachos disk storage.
 //
+//	"name" -- UNIX file holding the disk, e.g. "DISK_0"
 //	"toCall" -- object to call when disk read/write request completes
+//	"queueDepth" -- how many requests may be outstanding at a time
 //----------------------------------------------------------------------
 
-Disk::Disk(CallBackObj *toCall)
+Disk::Disk(char *name, TaggedCallBackObj *toCall, int queueDepth)
 {
     int magicNum;
     int tmp = 0;
 
-    DEBUG(dbgDisk, "Initializing the disk.");
+    DEBUG(dbgDisk, "Initializing the disk " << name);
+    ASSERT((queueDepth >= 1) && (queueDepth <= MaxQueueDepth));
     callWhenDone = toCall;
-    lastSector = 0;
-    bufferInit = 0;
+    this->queueDepth = queueDepth;
+    numQueued = 0;
+    model = DiskModel::Load(kernel->diskProfile);
+    DEBUG(dbgDisk, "Disk model " << model->Name());
 
-    sprintf(diskname,"DISK_%d",kernel->hostName);
+    ASSERT(strlen(name) < sizeof(diskname));
+    strcpy(diskname, name);
     fileno = OpenForReadWrite(diskname, FALSE);
     if (fileno >= 0)  		 	// file exists, check magic number
         {
@@ -64,18 +70,21 @@ Disk::Disk(CallBackObj *toCall)
             Lseek(fileno, DiskSize - sizeof(int), 0);
             WriteFile(fileno, (char *)&tmp, sizeof(int));
         }
+    hostIO = kernel->hostIO ? new HostIO(fileno) : NULL;
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk, once the host worker (if any) is done with it.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    delete hostIO;			// finishes the file accesses
     Close(fileno);
+    delete model;
 }
 
 //----------------------------------------------------------------------
@@ -102,172 +111,178 @@ PrintSector (bool writing, int sector, char *data)
 //----------------------------------------------------------------------
 // Disk::ReadRequest/WriteRequest
 // 	Simulate a request to read/write a single disk sector
-//	   Do the read/write immediately to the UNIX file
-//	   Set up an interrupt handler to be called later,
-//	      that will notify the caller when the simulator says
-//	      the operation has completed.
+//	   Do the read/write immediately to the UNIX file, or hand it
+//	      to the host worker (-hio)
+//	   Queue the request; when its turn comes, set up an interrupt
+//	      handler to be called later, that will notify the caller
+//	      when the simulator says the operation has completed.
 //
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
 //
 //	"sectorNumber" -- the disk sector to read/write
 //	"data" -- the bytes to be written, the buffer to hold the incoming bytes
+//	"tag" -- passed back to the caller when the request completes
 //----------------------------------------------------------------------
 
 void
-Disk::ReadRequest(int sectorNumber, char* data)
+Disk::ReadRequest(int sectorNumber, char* data, int tag)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    unsigned int ticket = 0;
 
-    ASSERT(!active);				// only one request at a time
+    ASSERT(!IsFull());				// only queueDepth at a time
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
 
-    DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
-    if (debug->IsEnabled('d'))
-        PrintSector(FALSE, sectorNumber, data);
+    DEBUG(dbgDisk, "Reading from sector " << sectorNumber << ", tag " << tag);
+    if (hostIO != NULL)  		// data arrives before the interrupt
+        {
+            ticket = hostIO->Read(SectorSize * sectorNumber + MagicSize,
+                                  data, SectorSize);
+        }
+    else
+        {
+            Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+            Read(fileno, data, SectorSize);
+            if (debug->IsEnabled('d'))
+                PrintSector(FALSE, sectorNumber, data);
+        }
 
-    active = TRUE;
-    UpdateLast(sectorNumber);
     kernel->stats->numDiskReads++;
-    kernel->interrupt->Schedule(this, ticks, DiskInt);
+    Enqueue(sectorNumber, data, FALSE, tag, ticket);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteRequest(int sectorNumber, char* data, int tag)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    unsigned int ticket = 0;
 
-    ASSERT(!active);
+    ASSERT(!IsFull());
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
 
-    DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    DEBUG(dbgDisk, "Writing to sector " << sectorNumber << ", tag " << tag);
+    if (hostIO != NULL)
+        {
+            ticket = hostIO->Write(SectorSize * sectorNumber + MagicSize,
+                                   data, SectorSize);
+        }
+    else
+        {
+            Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+            WriteFile(fileno, data, SectorSize);
+        }
     if (debug->IsEnabled('d'))
         PrintSector(TRUE, sectorNumber, data);
 
-    active = TRUE;
-    UpdateLast(sectorNumber);
     kernel->stats->numDiskWrites++;
-    kernel->interrupt->Schedule(this, ticks, DiskInt);
+    Enqueue(sectorNumber, data, TRUE, tag, ticket);
 }
 
 //----------------------------------------------------------------------
-// Disk::CallBack()
-// 	Called by the machine simulation when the disk interrupt occurs.
+// Disk::Enqueue
+// 	Add a request to the queue, and start it if the disk is idle.
+//
+//	"ticket" -- the host worker's request for the data, with -hio
 //----------------------------------------------------------------------
 
 void
-Disk::CallBack ()
+Disk::Enqueue(int sectorNumber, char *data, bool writing, int tag,
+              unsigned int ticket)
 {
-    active = FALSE;
-    callWhenDone->CallBack();
+    DiskCommand *command = &queue[numQueued++];
+
+    command->tag = tag;
+    command->sector = sectorNumber;
+    command->writing = writing;
+    command->data = data;
+    command->ticket = ticket;
+    command->passedOver = 0;
+    if (!active)
+        {
+            StartNext();
+        }
 }
 
 //----------------------------------------------------------------------
-// Disk::TimeToSeek()
-//	Returns how long it will take to position the disk head over the correct
-//	track on the disk.  Since when we finish seeking, we are likely
-//	to be in the middle of a sector that is rotating past the head,
-//	we also return how long until the head is at the next sector boundary.
-//
-//   	Disk seeks at one track per SeekTime ticks (cf. stats.h)
-//   	and rotates at one sector per RotationTime ticks
+// Disk::StartNext
+// 	Pick the queued request with the shortest positioning time (or
+//	one that has waited too long), and start serving it.
 //----------------------------------------------------------------------
 
-int
-Disk::TimeToSeek(int newSector, int *rotation)
+void
+Disk::StartNext()
 {
-    int newTrack = newSector / SectorsPerTrack;
-    int oldTrack = lastSector / SectorsPerTrack;
-    int seek = abs(newTrack - oldTrack) * SeekTime;
-    // how long will seek take?
-    int over = (kernel->stats->totalTicks + seek) % RotationTime;
-    // will we be in the middle of a sector when
-    // we finish the seek?
-
-    *rotation = 0;
-    if (over > 0)	 	// if so, need to round up to next full sector
-        *rotation = RotationTime - over;
-    return seek;
-}
+    int best = -1, bestTicks = 0, ticks;
 
-//----------------------------------------------------------------------
-// Disk::ModuloDiff()
-// 	Return number of sectors of rotational delay between target sector
-//	"to" and current sector position "from"
-//----------------------------------------------------------------------
+    ASSERT(!active && numQueued > 0);
 
-int
-Disk::ModuloDiff(int to, int from)
-{
-    int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    for (int i = 0; i < numQueued; i++)
+        {
+            if (queue[i].passedOver >= MaxPassOver)  	// oldest starving one
+                {
+                    best = i;
+                    break;
+                }
+            ticks = ComputeLatency(queue[i].sector, queue[i].writing);
+            if (best < 0 || ticks < bestTicks)
+                {
+                    best = i;
+                    bestTicks = ticks;
+                }
+        }
+
+    current = queue[best];
+    for (int i = best; i < numQueued - 1; i++)  	// keep arrival order
+        queue[i] = queue[i + 1];
+    numQueued--;
+    for (int i = 0; i < numQueued; i++)
+        if (i < best)
+            queue[i].passedOver++;
 
-    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+    ticks = ComputeLatency(current.sector, current.writing);
+    active = TRUE;
+    kernel->stats->numSeekTicks += model->SeekTicks(current.sector);
+    model->Access(kernel->stats->totalTicks, current.sector, current.writing);
+    kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
 //----------------------------------------------------------------------
-// Disk::ComputeLatency()
-// 	Return how long will it take to read/write a disk sector, from
-//	the current position of the disk head.
-//
-//   	Latency = seek time + rotational latency + transfer time
-//   	Disk seeks at one track per SeekTime ticks (cf. stats.h)
-//   	and rotates at one sector per RotationTime ticks
-//
-//   	To find the rotational latency, we first must figure out where the
-//   	disk head will be after the seek (if any).  We then figure out
-//   	how long it will take to rotate completely past newSector after
-//	that point.
-//
-//   	The disk also has a "track buffer"; the disk continuously reads
-//   	the contents of the current disk track into the buffer.  This allows
-//   	read requests to the current track to be satisfied more quickly.
-//   	The contents of the track buffer are discarded after every seek to
-//   	a new track.
+// Disk::CallBack()
+// 	Called by the machine simulation when the disk interrupt occurs.
+//	Start on the next request before telling the caller, so the disk
+//	stays busy.  With a host worker, first wait for it to have done
+//	the request's file access; it has usually long finished.
 //----------------------------------------------------------------------
 
-int
-Disk::ComputeLatency(int newSector, bool writing)
+void
+Disk::CallBack ()
 {
-    int rotation;
-    int seek = TimeToSeek(newSector, &rotation);
-    int timeAfter = kernel->stats->totalTicks + seek + rotation;
-
-#ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
-    // check if track buffer applies
-    if ((writing == FALSE) && (seek == 0)
-            && (((timeAfter - bufferInit) / RotationTime)
-                > ModuloDiff(newSector, bufferInit / RotationTime)))
+    int tag = current.tag;
+
+    if (hostIO != NULL)
         {
-            DEBUG(dbgDisk, "Request latency = " << RotationTime);
-            return RotationTime; // time to transfer sector from the track buffer
+            hostIO->Wait(current.ticket);
+            if (!current.writing && debug->IsEnabled('d'))
+                PrintSector(FALSE, current.sector, current.data);
         }
-#endif
-
-    rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
-
-    DEBUG(dbgDisk, "Request latency = " << (seek + rotation + RotationTime));
-    return(seek + rotation + RotationTime);
+    active = FALSE;
+    if (numQueued > 0)
+        {
+            StartNext();
+        }
+    callWhenDone->CallBack(tag);
 }
 
 //----------------------------------------------------------------------
-// Disk::UpdateLast
-//   	Keep track of the most recently requested sector.  So we can know
-//	what is in the track buffer.
+// Disk::ComputeLatency()
+// 	Return how long will it take to read/write a disk sector, from
+//	the current state of the device, according to its model.
 //----------------------------------------------------------------------
 
-void
-Disk::UpdateLast(int newSector)
+int
+Disk::ComputeLatency(int newSector, bool writing)
 {
-    int rotate;
-    int seek = TimeToSeek(newSector, &rotate);
+    int latency = model->Latency(kernel->stats->totalTicks, newSector, writing);
 
-    if (seek != 0)
-        bufferInit = kernel->stats->totalTicks + seek + rotate;
-    lastSector = newSector;
-    DEBUG(dbgDisk, "Updating last sector = " << lastSector << " , " << bufferInit);
+    DEBUG(dbgDisk, "Request latency = " << latency);
+    return latency;
 }
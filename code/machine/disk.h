@@ -20,6 +20,8 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "diskmodel.h"
+#include "hostio.h"
 
 // The following class defines a physical disk I/O device.  The disk
 // has a single surface, split up into "tracks", and each track split
@@ -46,48 +48,94 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// How long a request takes is up to a DiskModel (diskmodel.h): the
+// rotational disk described above by default, or, given a device
+// profile ("-dp"), a flash device.
+//
+// The disk accepts up to "queueDepth" tagged requests at a time
+// (native command queueing, "-ncq").  It serves them one after the
+// other, each time picking the queued request that its model says
+// will take the shortest time from the current head position, and
+// signals each completion with the request's tag.  So that nothing
+// starves, a request that has been passed over MaxPassOver times is
+// served next.  The data is transferred to or from the UNIX file when
+// the request is queued, so reordering never changes what is read.
+//
+// With "-hio", the UNIX file is read and written by a host worker
+// thread instead (hostio.h), in the order the requests are queued; a
+// request's interrupt waits for the worker to have finished it, so
+// the simulation sees the same data at the same simulated times.
 
 const int SectorSize = 128;		// number of bytes per disk sector
 const int SectorsPerTrack  = 32 * 512;	// number of sectors per disk track
 const int NumTracks = 32;		// number of tracks per disk
 const int NumSectors = (SectorsPerTrack * NumTracks);
 // total # of sectors per disk
+const int MaxQueueDepth = 32;		// most requests queued in a disk
+const int MaxPassOver = 8;		// times a request may be passed over
+
+// A request queued in the disk.
+class DiskCommand
+{
+public:
+    int tag;				// passed back when it completes
+    int sector;
+    bool writing;
+    int passedOver;			// times another request went first
+    char *data;				// the caller's buffer
+    unsigned int ticket;		// its host worker request, with -hio
+};
 
 class Disk : public CallBackObj
 {
 public:
-    Disk(CallBackObj *toCall);          // Create a simulated disk.
-    // Invoke toCall->CallBack()
+    Disk(char *name, TaggedCallBackObj *toCall, int queueDepth);
+    // Create a simulated disk, stored
+    // in UNIX file "name".
+    // Invoke toCall->CallBack(tag)
     // when each request completes.
     ~Disk();				// Deallocate the disk.
 
-    void ReadRequest(int sectorNumber, char* data);
+    void ReadRequest(int sectorNumber, char* data, int tag);
     // Read/write an single disk sector.
     // These routines send a request to
     // the disk and return immediately.
-    // Only one request allowed at a time!
-    void WriteRequest(int sectorNumber, char* data);
+    // Only queueDepth requests allowed
+    // at a time!
+    void WriteRequest(int sectorNumber, char* data, int tag);
+
+    bool IsFull()
+    {
+        return numQueued + (active ? 1 : 0) >= queueDepth;
+    }
+    // can't take another request
 
     void CallBack();			// Invoked when disk request
     // finishes. In turn calls, callWhenDone.
 
     int ComputeLatency(int newSector, bool writing);
     // Return how long a request to
-    // newSector will take:
+    // newSector will take, e.g.
     // (seek + rotational delay + transfer)
 
 private:
     int fileno;				// UNIX file number for simulated disk
     char diskname[32];			// name of simulated disk's file
-    CallBackObj *callWhenDone;		// Invoke when any disk request finishes
+    TaggedCallBackObj *callWhenDone;	// Invoke when any disk request finishes
     bool active;     			// Is a disk operation in progress?
-    int lastSector;			// The previous disk request
-    int bufferInit;			// When the track buffer started
-    // being loaded
+    DiskModel *model;			// How long requests take
+    HostIO *hostIO;			// does the UNIX file accesses, if
+    // not NULL (-hio)
+
+    int queueDepth;			// most requests outstanding at a time
+    DiskCommand queue[MaxQueueDepth];	// requests waiting to be served
+    int numQueued;
+    DiskCommand current;		// request being served, if active
 
-    int TimeToSeek(int newSector, int *rotate); // time to get to the new track
-    int ModuloDiff(int to, int from);        // # sectors between to and from
-    void UpdateLast(int newSector);
+    void Enqueue(int sectorNumber, char *data, bool writing, int tag,
+                 unsigned int ticket);
+    void StartNext();			// serve the best queued request
 };
 
 #endif // DISK_H
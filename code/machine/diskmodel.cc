@@ -0,0 +1,277 @@
+// diskmodel.cc
+//	Routines to compute how long block device requests take, for a
+//	rotational disk and for a flash device, and to read the device
+//	profile that selects between them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "diskmodel.h"
+#include "disk.h"
+#include "stats.h"
+#include "debug.h"
+#include "sysdep.h"
+
+#ifdef NOTRACKBUF
+static const bool DefaultTrackBuffer = FALSE;
+#else
+static const bool DefaultTrackBuffer = TRUE;
+#endif
+
+//----------------------------------------------------------------------
+// DiskModel::Load
+// 	Read a device profile and build the model it describes.
+//	With no profile, return the classic Nachos rotational disk.
+//
+//	"profile" -- name of the UNIX profile file, or NULL
+//----------------------------------------------------------------------
+
+DiskModel *
+DiskModel::Load(char *profile)
+{
+    char line[128], key[64], model[64];
+    int value;
+    FILE *file;
+
+    // defaults
+    strcpy(model, "rotational");
+    int seekTime = SeekTime, rotationTime = RotationTime;
+    int trackBuffer = DefaultTrackBuffer;
+    int pageRead = 50, pageProgram = 200, blockErase = 2000;
+    int pagesPerBlock = 64;
+
+    if (profile != NULL)
+        {
+            file = fopen(profile, "r");
+            if (file == NULL)
+                {
+                    cerr << "Cannot open disk profile " << profile << "\n";
+                    Abort();
+                }
+            while (fgets(line, sizeof(line), file) != NULL)
+                {
+                    char *comment = strchr(line, '#');
+                    if (comment != NULL)
+                        *comment = '\0';
+                    if (sscanf(line, " model = %63s", model) == 1)
+                        continue;
+                    if (sscanf(line, " %63[a-z_] = %d", key, &value) != 2)
+                        {
+                            continue;			// blank line
+                        }
+                    if (strcmp(key, "seek_time") == 0)
+                        seekTime = value;
+                    else if (strcmp(key, "rotation_time") == 0)
+                        rotationTime = value;
+                    else if (strcmp(key, "track_buffer") == 0)
+                        trackBuffer = value;
+                    else if (strcmp(key, "page_read") == 0)
+                        pageRead = value;
+                    else if (strcmp(key, "page_program") == 0)
+                        pageProgram = value;
+                    else if (strcmp(key, "block_erase") == 0)
+                        blockErase = value;
+                    else if (strcmp(key, "pages_per_block") == 0)
+                        pagesPerBlock = value;
+                    else
+                        {
+                            cerr << "Unknown key " << key << " in disk profile " << profile << "\n";
+                            Abort();
+                        }
+                }
+            fclose(file);
+        }
+
+    if (strcmp(model, "rotational") == 0)
+        return new RotationalModel(seekTime, rotationTime, trackBuffer != 0);
+    if (strcmp(model, "flash") == 0)
+        return new FlashModel(pageRead, pageProgram, blockErase,
+                              pagesPerBlock);
+    cerr << "Unknown model " << model << " in disk profile " << profile << "\n";
+    Abort();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::RotationalModel
+// 	Initialize a disk with the head over sector 0.
+//
+//	"seekTime" -- ticks to seek past one track
+//	"rotationTime" -- ticks for one sector to rotate past the head
+//	"trackBuffer" -- does the disk have a track buffer?
+//----------------------------------------------------------------------
+
+RotationalModel::RotationalModel(int seekTime, int rotationTime,
+                                 bool trackBuffer)
+{
+    ASSERT(seekTime >= 0 && rotationTime > 0);
+    this->seekTime = seekTime;
+    this->rotationTime = rotationTime;
+    this->trackBuffer = trackBuffer;
+    lastSector = 0;
+    bufferInit = 0;
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::TimeToSeek()
+//	Returns how long it will take to position the disk head over the correct
+//	track on the disk.  Since when we finish seeking, we are likely
+//	to be in the middle of a sector that is rotating past the head,
+//	we also return how long until the head is at the next sector boundary.
+//
+//   	Disk seeks at one track per seekTime ticks
+//   	and rotates at one sector per rotationTime ticks
+//----------------------------------------------------------------------
+
+int
+RotationalModel::TimeToSeek(int now, int newSector, int *rotation)
+{
+    int newTrack = newSector / SectorsPerTrack;
+    int oldTrack = lastSector / SectorsPerTrack;
+    int seek = abs(newTrack - oldTrack) * seekTime;
+    // how long will seek take?
+    int over = (now + seek) % rotationTime;
+    // will we be in the middle of a sector when
+    // we finish the seek?
+
+    *rotation = 0;
+    if (over > 0)	 	// if so, need to round up to next full sector
+        *rotation = rotationTime - over;
+    return seek;
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::ModuloDiff()
+// 	Return number of sectors of rotational delay between target sector
+//	"to" and current sector position "from"
+//----------------------------------------------------------------------
+
+int
+RotationalModel::ModuloDiff(int to, int from)
+{
+    int toOffset = to % SectorsPerTrack;
+    int fromOffset = from % SectorsPerTrack;
+
+    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::Latency()
+// 	Return how long will it take to read/write a disk sector, from
+//	the current position of the disk head.
+//
+//   	Latency = seek time + rotational latency + transfer time
+//
+//   	To find the rotational latency, we first must figure out where the
+//   	disk head will be after the seek (if any).  We then figure out
+//   	how long it will take to rotate completely past newSector after
+//	that point.
+//
+//   	The disk also has a "track buffer"; the disk continuously reads
+//   	the contents of the current disk track into the buffer.  This allows
+//   	read requests to the current track to be satisfied more quickly.
+//   	The contents of the track buffer are discarded after every seek to
+//   	a new track.
+//----------------------------------------------------------------------
+
+int
+RotationalModel::Latency(int now, int newSector, bool writing)
+{
+    int rotation;
+    int seek = TimeToSeek(now, newSector, &rotation);
+    int timeAfter = now + seek + rotation;
+
+    // check if track buffer applies
+    if (trackBuffer && (writing == FALSE) && (seek == 0)
+            && (((timeAfter - bufferInit) / rotationTime)
+                > ModuloDiff(newSector, bufferInit / rotationTime)))
+        {
+            return rotationTime; // time to transfer sector from the track buffer
+        }
+
+    rotation += ModuloDiff(newSector, timeAfter / rotationTime) * rotationTime;
+    return(seek + rotation + rotationTime);
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::Access
+//   	Keep track of the most recently requested sector.  So we can know
+//	what is in the track buffer.
+//----------------------------------------------------------------------
+
+void
+RotationalModel::Access(int now, int newSector, bool writing)
+{
+    int rotate;
+    int seek = TimeToSeek(now, newSector, &rotate);
+
+    if (seek != 0)
+        bufferInit = now + seek + rotate;
+    lastSector = newSector;
+}
+
+//----------------------------------------------------------------------
+// RotationalModel::SeekTicks
+//   	Return how long the head would spend moving to the track of
+//	"sector".
+//----------------------------------------------------------------------
+
+int
+RotationalModel::SeekTicks(int sector)
+{
+    return abs(sector / SectorsPerTrack - lastSector / SectorsPerTrack) * seekTime;
+}
+
+//----------------------------------------------------------------------
+// FlashModel::FlashModel
+// 	Initialize an idle flash device.
+//
+//	"pageRead", "pageProgram", "blockErase" -- ticks per operation
+//	"pagesPerBlock" -- pages programmed before a block is full
+//----------------------------------------------------------------------
+
+FlashModel::FlashModel(int pageRead, int pageProgram, int blockErase,
+                       int pagesPerBlock)
+{
+    ASSERT(pageRead > 0 && pageProgram > 0 && blockErase >= 0);
+    ASSERT(pagesPerBlock > 0);
+    this->pageRead = pageRead;
+    this->pageProgram = pageProgram;
+    this->blockErase = blockErase;
+    this->pagesPerBlock = pagesPerBlock;
+    busyUntil = 0;
+    programmed = 0;
+}
+
+//----------------------------------------------------------------------
+// FlashModel::Latency
+// 	Wait for an erase in progress to finish, then read or program
+//	the page.
+//----------------------------------------------------------------------
+
+int
+FlashModel::Latency(int now, int sector, bool writing)
+{
+    int wait = (busyUntil > now) ? busyUntil - now : 0;
+
+    return wait + (writing ? pageProgram : pageRead);
+}
+
+//----------------------------------------------------------------------
+// FlashModel::Access
+// 	Keep the device busy for the request; once a block has been
+//	programmed full, keep it busy erasing the next one as well.
+//----------------------------------------------------------------------
+
+void
+FlashModel::Access(int now, int sector, bool writing)
+{
+    busyUntil = now + Latency(now, sector, writing);
+    if (writing && ++programmed == pagesPerBlock)
+        {
+            programmed = 0;
+            busyUntil += blockErase;
+        }
+}
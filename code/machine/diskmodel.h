@@ -0,0 +1,129 @@
+// diskmodel.h
+//	Data structures to model how long block device requests take.
+//
+//	The simulated disk (disk.h) decides *what* a request does; a
+//	DiskModel decides *how long* it takes.  Two models are provided:
+//
+//	RotationalModel -- a single-surface moving-head disk with a track
+//		buffer; this is the classic Nachos disk.
+//
+//	FlashModel -- a flash device: pages are read and programmed in
+//		fixed time, and a block has to be erased after it has been
+//		programmed full.
+//
+//	The model and its parameters come from a profile file of
+//	"key = value" lines ("#" starts a comment), for example
+//
+//		model = flash
+//		page_read = 50
+//		page_program = 200
+//		block_erase = 2000
+//		pages_per_block = 64
+//
+//	or, for the rotational model, "seek_time", "rotation_time" and
+//	"track_buffer" (0 or 1).  Missing keys keep their defaults.
+//
+//	The models only depend on the disk geometry, not on the rest of
+//	Nachos, so tools outside the kernel can use them too.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DISKMODEL_H
+#define DISKMODEL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the interface of a latency model.
+// Times are in ticks; "now" is the time the request is started.
+
+class DiskModel
+{
+public:
+    virtual ~DiskModel() {}
+
+    virtual int Latency(int now, int sector, bool writing) = 0;
+    // How long would a request to
+    // "sector" take, if started now?
+    virtual void Access(int now, int sector, bool writing) = 0;
+    // The request has been started now;
+    // update the device state (head
+    // position, erase in progress, ...)
+    virtual char *Name() = 0;		// for statistics and debugging
+    virtual int SeekTicks(int sector)
+    {
+        return 0;
+    }
+    // How much of the latency of a
+    // request to "sector" is seeking?
+
+    static DiskModel *Load(char *profile);
+    // Build the model described by the
+    // profile file; NULL gives the
+    // default rotational disk.
+};
+
+// The following class defines the classic Nachos disk: seeks take
+// SeekTime per track, the disk rotates past one sector every
+// RotationTime, and the track buffer holds the current track.
+
+class RotationalModel : public DiskModel
+{
+public:
+    RotationalModel(int seekTime, int rotationTime, bool trackBuffer);
+
+    int Latency(int now, int sector, bool writing);
+    void Access(int now, int sector, bool writing);
+    char *Name()
+    {
+        return "rotational";
+    }
+    int SeekTicks(int sector);
+
+private:
+    int seekTime;			// ticks to seek past one track
+    int rotationTime;			// ticks for one sector to rotate by
+    bool trackBuffer;			// model the track buffer?
+    int lastSector;			// The previous disk request
+    int bufferInit;			// When the track buffer started
+    // being loaded
+
+    int TimeToSeek(int now, int newSector, int *rotate);
+    // time to get to the new track
+    int ModuloDiff(int to, int from);	// # sectors between to and from
+};
+
+// The following class defines a flash device.  Each sector is one
+// flash page.  Writes are appended to the open block; when a block has
+// been programmed full, the device spends "blockErase" ticks erasing a
+// block for later use, during which it can serve nothing else.
+//
+// The disk serves one request at a time, so the device has a single
+// channel: spreading pages over parallel channels would never overlap
+// anything.
+
+class FlashModel : public DiskModel
+{
+public:
+    FlashModel(int pageRead, int pageProgram, int blockErase,
+               int pagesPerBlock);
+
+    int Latency(int now, int sector, bool writing);
+    void Access(int now, int sector, bool writing);
+    char *Name()
+    {
+        return "flash";
+    }
+
+private:
+    int pageRead;			// ticks to read one page
+    int pageProgram;			// ticks to program one page
+    int blockErase;			// ticks to erase one block
+    int pagesPerBlock;
+    int busyUntil;			// when the device is free again
+    int programmed;			// pages written into the open block
+};
+
+#endif // DISKMODEL_H
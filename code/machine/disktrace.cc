@@ -0,0 +1,95 @@
+// disktrace.cc
+//	Routines to record the requests seen by the disks into a trace
+//	file.  See disktrace.h for the file format.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "disktrace.h"
+#include "debug.h"
+#include "sysdep.h"
+
+char *ioContextNames[NumIOContexts] = { "data", "header", "directory",
+                                        "freemap"
+                                      };
+
+//----------------------------------------------------------------------
+// DiskTrace::DiskTrace
+// 	Create a new trace file, replacing any old one.
+//
+//	"fileName" -- UNIX file to hold the trace
+//	"numDisks" -- how many disks the requests may go to
+//----------------------------------------------------------------------
+
+DiskTrace::DiskTrace(char *fileName, int numDisks)
+{
+    TraceHeader header;
+
+    header.magic = TraceMagic;
+    header.version = TraceVersion;
+    header.recordSize = sizeof(TraceRecord);
+    header.numDisks = numDisks;
+
+    file = OpenForWrite(fileName);
+    WriteFile(file, (char *) &header, sizeof(header));
+    numBuffered = numRecords = 0;
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::~DiskTrace
+// 	Write out the records still buffered, and close the file.
+//----------------------------------------------------------------------
+
+DiskTrace::~DiskTrace()
+{
+    Flush();
+    Close(file);
+    DEBUG(dbgDisk, "Disk trace: " << numRecords << " requests recorded");
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Record
+// 	Log one request handed to a physical disk.
+//
+//	"tick" -- simulated time of the request
+//	"disk", "sector" -- where it goes
+//	"writing" -- write or read?
+//	"thread" -- id of the thread that issued it
+//	"context" -- what the file system was doing (an IOContext)
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Record(int tick, int disk, int sector, bool writing,
+                  int thread, int context)
+{
+    TraceRecord *record = &buffer[numBuffered];
+
+    ASSERT((context >= 0) && (context < NumIOContexts));
+    record->tick = tick;
+    record->sector = sector;
+    record->thread = thread;
+    record->disk = disk;
+    record->flags = (writing ? TraceWrite : 0) | (context << TraceContextShift);
+    if (++numBuffered == TraceBufferSize)
+        {
+            Flush();
+        }
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Flush
+// 	Write out the buffered records.
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Flush()
+{
+    if (numBuffered > 0)
+        {
+            WriteFile(file, (char *) buffer, numBuffered * sizeof(TraceRecord));
+            numRecords += numBuffered;
+            numBuffered = 0;
+        }
+}
@@ -0,0 +1,95 @@
+// disktrace.h
+//	Data structures to record the stream of requests seen by the
+//	disks, so that it can be replayed later outside of Nachos
+//	(see tracereplay.cc) to try other caches and queue policies.
+//
+//	A trace file is a TraceHeader followed by one TraceRecord per
+//	physical disk request, in the order the requests were issued.
+//	Records are fixed size and stored in host byte order, so a trace
+//	can only be replayed on the kind of machine that recorded it.
+//
+//	The records only depend on the disk geometry, not on the rest of
+//	Nachos, so tools outside the kernel can read them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DISKTRACE_H
+#define DISKTRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// What the file system was doing when it issued a request.  Kept
+// per thread; see Thread::getIOContext.
+enum IOContext { IOData,		// contents of an ordinary file
+                 IOHeader,		// a file header
+                 IODirectory,		// contents of a directory
+                 IOFreeMap,		// the free sector map
+                 NumIOContexts
+               };
+
+extern char *ioContextNames[NumIOContexts];
+
+const int TraceMagic = 0x4352544e;	// "NTRC" on a little-endian host
+const int TraceVersion = 1;
+const int TraceBufferSize = 256;	// records written at a time
+
+class TraceHeader
+{
+public:
+    int magic;				// TraceMagic
+    int version;			// TraceVersion
+    int recordSize;			// sizeof(TraceRecord)
+    int numDisks;			// disks in the traced volume
+};
+
+// Flag bits of a TraceRecord
+const char TraceWrite = 0x1;		// a write, not a read
+const int TraceContextShift = 1;	// IOContext in the bits above
+
+class TraceRecord
+{
+public:
+    int tick;				// when the request was issued
+    int sector;				// sector on the physical disk
+    short thread;			// id of the issuing thread
+    char disk;				// which disk of the volume
+    char flags;				// TraceWrite | context << TraceContextShift
+
+    bool IsWrite()
+    {
+        return (flags & TraceWrite) != 0;
+    }
+    int Context()
+    {
+        return flags >> TraceContextShift;
+    }
+};
+
+// The following class defines a trace being recorded.  Records are
+// buffered and written out TraceBufferSize at a time, and when the
+// trace is deleted.
+
+class DiskTrace
+{
+public:
+    DiskTrace(char *fileName, int numDisks);
+    // Create the trace file, write its header
+    ~DiskTrace();			// Write out what is left, close the file
+
+    void Record(int tick, int disk, int sector, bool writing,
+                int thread, int context);
+    // Log one physical disk request
+
+private:
+    int file;				// UNIX file descriptor
+    TraceRecord buffer[TraceBufferSize];
+    int numBuffered;
+    int numRecords;			// written so far
+
+    void Flush();			// write out the buffered records
+};
+
+#endif // DISKTRACE_H
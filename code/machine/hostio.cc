@@ -0,0 +1,207 @@
+// hostio.cc
+//	Routines to read and write the UNIX file behind a simulated disk
+//	on a host worker thread, fed by a lock-free request ring.
+//
+//	The ring is shared by the simulation's host thread and the
+//	worker; the worker touches nothing else in Nachos.  The GCC atomic
+//	builtins provide the memory barriers.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "hostio.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// HostIO::HostIO
+// 	Initialize an empty ring, and start the worker.
+//
+//	"fileno" -- the open UNIX file the requests go to
+//----------------------------------------------------------------------
+
+HostIO::HostIO(int fileno)
+{
+    this->fileno = fileno;
+    head = tail = 0;
+    workerAsleep = callerAsleep = FALSE;
+    worker = StartHostThread(Serve, this);
+}
+
+//----------------------------------------------------------------------
+// HostIO::~HostIO
+// 	Tell the worker to stop once it has served every request before,
+//	and wait for it to exit.
+//----------------------------------------------------------------------
+
+HostIO::~HostIO()
+{
+    Slot *slot = Claim();
+
+    slot->stop = TRUE;
+    Post();
+    JoinHostThread(worker);
+}
+
+//----------------------------------------------------------------------
+// HostIO::Read/Write
+// 	Put a request on the ring for the worker, and return its ticket
+//	right away.  A write copies its data, so the caller may reuse
+//	"data" at once; a read fills "data" by the time Wait returns.
+//
+//	"offset" -- byte offset in the UNIX file
+//	"data" -- the buffer to fill, or the bytes to write
+//	"size" -- how many bytes, at most MaxIOSize
+//----------------------------------------------------------------------
+
+unsigned int
+HostIO::Read(int offset, char *data, int size)
+{
+    Slot *slot = Claim();
+
+    ASSERT(size <= MaxIOSize);
+    slot->offset = offset;
+    slot->size = size;
+    slot->writing = FALSE;
+    slot->stop = FALSE;
+    slot->data = data;
+    return Post();
+}
+
+unsigned int
+HostIO::Write(int offset, char *data, int size)
+{
+    Slot *slot = Claim();
+
+    ASSERT(size <= MaxIOSize);
+    slot->offset = offset;
+    slot->size = size;
+    slot->writing = TRUE;
+    slot->stop = FALSE;
+    slot->data = NULL;
+    bcopy(data, slot->buffer, size);
+    return Post();
+}
+
+//----------------------------------------------------------------------
+// HostIO::Wait
+// 	Wait until the worker has finished the request with "ticket".
+//	Requests are served in ring order, so every earlier request is
+//	finished too.
+//----------------------------------------------------------------------
+
+void
+HostIO::Wait(unsigned int ticket)
+{
+    unsigned int done;
+
+    while ((int) ((done = head) - ticket) <= 0)
+        {
+            Await(&head, done, &callerAsleep);
+        }
+    __sync_synchronize();		// new head before the data read
+}
+
+//----------------------------------------------------------------------
+// HostIO::Claim
+// 	Return the next free slot, waiting for the worker if the ring is
+//	full.  Called only by the simulation.
+//----------------------------------------------------------------------
+
+HostIO::Slot *
+HostIO::Claim()
+{
+    unsigned int done;
+
+    while (tail - (done = head) == IORingSize)
+        {
+            Await(&head, done, &callerAsleep);
+        }
+    __sync_synchronize();		// worker done with the slot
+    return &slots[tail % IORingSize];
+}
+
+//----------------------------------------------------------------------
+// HostIO::Post
+// 	Hand the slot returned by Claim to the worker, and return its
+//	ticket.  Wake the worker if it has gone to sleep.
+//----------------------------------------------------------------------
+
+unsigned int
+HostIO::Post()
+{
+    unsigned int ticket = tail;
+
+    __sync_synchronize();		// slot contents before the new tail
+    tail = tail + 1;
+    __sync_synchronize();		// new tail before looking for sleepers
+    if (workerAsleep)
+        WakeHostWord(&tail);
+    return ticket;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Await
+// 	Wait until the ring index "index" no longer holds "value": yield
+//	the host CPU IOSpins times, then sleep on the index.  The other
+//	thread changes the index before it looks at "asleep", and we set
+//	"asleep" before we look at the index again, so one of the two
+//	always sees the other and no wake up is lost.
+//----------------------------------------------------------------------
+
+void
+HostIO::Await(volatile unsigned int *index, unsigned int value,
+              volatile bool *asleep)
+{
+    for (int i = 0; i < IOSpins; i++)
+        {
+            if (*index != value)
+                return;
+            YieldHostThread();
+        }
+    *asleep = TRUE;
+    __sync_synchronize();		// flag before the new look at the index
+    if (*index == value)
+        WaitHostWord(index, value);
+    *asleep = FALSE;
+}
+
+//----------------------------------------------------------------------
+// HostIO::Serve
+// 	The worker: serve the requests on the ring, in order, until told
+//	to stop.  Runs on its own host thread.
+//
+//	"arg" -- the HostIO whose ring to serve
+//----------------------------------------------------------------------
+
+void *
+HostIO::Serve(void *arg)
+{
+    HostIO *io = (HostIO *) arg;
+    Slot *slot;
+    bool stop;
+
+    do
+        {
+            while (io->head == io->tail)
+                {
+                    Await(&io->tail, io->head, &io->workerAsleep);
+                }
+            __sync_synchronize();	// new tail before the slot contents
+            slot = &io->slots[io->head % IORingSize];
+            stop = slot->stop;
+            if (!stop && slot->writing)
+                WriteAt(io->fileno, slot->buffer, slot->size, slot->offset);
+            else if (!stop)
+                ReadAt(io->fileno, slot->data, slot->size, slot->offset);
+            __sync_synchronize();	// done with the slot before freeing it
+            io->head = io->head + 1;
+            __sync_synchronize();	// new head before looking for sleepers
+            if (io->callerAsleep)
+                WakeHostWord(&io->head);
+        }
+    while (!stop);
+    return NULL;
+}
@@ -0,0 +1,83 @@
+// hostio.h
+//	Data structures to move the UNIX file accesses of a simulated
+//	disk off the host thread that runs the simulation ("nachos -hio").
+//
+//	Each disk gets a host worker thread, fed by a lock-free,
+//	single-producer/single-consumer ring of requests.  The simulation
+//	puts a request on the ring when the disk request is queued, and
+//	goes on; the worker reads or writes the UNIX file in the
+//	background, in ring order.  Before the disk interrupt for a request
+//	is delivered, the simulation waits for the worker to have finished
+//	it, so what a request reads and when it completes in simulated time
+//	are exactly as without the worker; only the wall clock time changes.
+//
+//	A host thread that has to wait for the other (the worker for a
+//	request, the simulation for a free slot or a finished request)
+//	first yields the host CPU a few times, then sleeps on the ring
+//	index it is waiting for; the other side wakes it only when it has
+//	said it is asleep, so the common case makes no system call.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTIO_H
+#define HOSTIO_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int IORingSize = 64;	// requests in flight per disk
+const int MaxIOSize = 512;	// largest request, in bytes
+const int IOSpins = 100;	// yields before a waiting thread sleeps
+
+// The following class defines a worker that reads and writes one UNIX
+// file for the simulation.  Only the simulation's host thread calls
+// Read, Write and Wait, only the worker takes requests off the ring,
+// so no lock is needed; memory barriers order the slot contents with
+// respect to the indices.  A request is finished once the worker has
+// moved "head" past it.
+
+class HostIO
+{
+public:
+    HostIO(int fileno);			// start a worker on file "fileno"
+    ~HostIO();				// finish every request, stop it
+
+    unsigned int Read(int offset, char *data, int size);
+    // Read "size" bytes at "offset" into
+    // "data", which must stay valid until
+    // the request is finished
+    unsigned int Write(int offset, char *data, int size);
+    // Write a copy of "size" bytes of
+    // "data" at "offset"
+    // Both return a ticket for Wait.
+    void Wait(unsigned int ticket);	// until that request is finished
+
+private:
+    struct Slot
+    {
+        int offset;			// where in the file
+        int size;			// how many bytes
+        bool writing;
+        bool stop;			// tells the worker to exit
+        char *data;			// where a read goes
+        char buffer[MaxIOSize];		// what a write writes
+    } slots[IORingSize];
+    volatile unsigned int head;		// next slot to serve
+    volatile unsigned int tail;		// next slot to fill
+    volatile bool workerAsleep;		// sleeping on "tail"
+    volatile bool callerAsleep;		// simulation sleeping on "head"
+    int fileno;				// UNIX file being accessed
+    unsigned long worker;		// host thread id
+
+    Slot *Claim();			// wait for a free slot
+    unsigned int Post();		// hand the claimed slot to the worker
+    static void *Serve(void *arg);	// the worker's loop
+    static void Await(volatile unsigned int *index, unsigned int value,
+                      volatile bool *asleep);
+    // wait for "index" to move on
+    // from "value"
+};
+
+#endif // HOSTIO_H
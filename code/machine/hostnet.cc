@@ -0,0 +1,287 @@
+// hostnet.cc
+//	Routines to connect several simulated machines running in the
+//	same UNIX process, using in-memory packet rings instead of
+//	UNIX sockets, and to keep their simulated clocks in step.
+//
+//	The rings and clocks are shared by the host threads; everything
+//	else in Nachos belongs to exactly one machine.  The GCC atomic
+//	builtins provide the memory barriers.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "hostnet.h"
+#include "stats.h"
+#include "sysdep.h"
+
+HostNet *hostNet = NULL;
+
+// clock value of a machine that has halted -- never waited for
+static const int Finished = 0x7fffffff;
+
+//----------------------------------------------------------------------
+// PacketRing::PacketRing
+// 	Initialize an empty ring.
+//----------------------------------------------------------------------
+
+PacketRing::PacketRing()
+{
+    head = tail = 0;
+}
+
+//----------------------------------------------------------------------
+// PacketRing::Put
+// 	Append a packet, if there is room.  Called only by the sender.
+//
+//	"packet" -- MaxWireSize bytes to send
+//	"when" -- simulated time at which the packet arrives
+//----------------------------------------------------------------------
+
+bool
+PacketRing::Put(char *packet, int when)
+{
+    Slot *slot;
+
+    if (tail - head == RingSize)
+        {
+            return FALSE;
+        }
+    slot = &slots[tail % RingSize];
+    slot->when = when;
+    bcopy(packet, slot->data, MaxWireSize);
+    __sync_synchronize();		// slot contents before the new tail
+    tail = tail + 1;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// PacketRing::Peek
+// 	Return the arrival time of the oldest packet, if any.  Called
+//	only by the receiver.
+//----------------------------------------------------------------------
+
+bool
+PacketRing::Peek(int *when)
+{
+    if (head == tail)
+        {
+            return FALSE;
+        }
+    __sync_synchronize();		// new tail before the slot contents
+    *when = slots[head % RingSize].when;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// PacketRing::Get
+// 	Remove the oldest packet.  The ring must not be empty.
+//----------------------------------------------------------------------
+
+void
+PacketRing::Get(char *packet)
+{
+    ASSERT(head != tail);
+    __sync_synchronize();
+    bcopy(slots[head % RingSize].data, packet, MaxWireSize);
+    __sync_synchronize();		// done with the slot before freeing it
+    head = head + 1;
+}
+
+//----------------------------------------------------------------------
+// PacketRing::IsEmpty
+//----------------------------------------------------------------------
+
+bool
+PacketRing::IsEmpty()
+{
+    return head == tail;
+}
+
+//----------------------------------------------------------------------
+// HostNet::HostNet
+// 	Connect every pair of "numHosts" machines, all starting at
+//	time 0.
+//----------------------------------------------------------------------
+
+HostNet::HostNet(int numHosts)
+{
+    ASSERT((numHosts >= 1) && (numHosts <= MaxHosts));
+    this->numHosts = numHosts;
+    for (int from = 0; from < numHosts; from++)
+        {
+            for (int to = 0; to < numHosts; to++)
+                rings[from][to] = (from == to) ? NULL : new PacketRing;
+            clock[from] = 0;
+            idle[from] = FALSE;
+            received[from] = 0;
+        }
+}
+
+//----------------------------------------------------------------------
+// HostNet::~HostNet
+// 	Called once every host thread has finished.
+//----------------------------------------------------------------------
+
+HostNet::~HostNet()
+{
+    for (int from = 0; from < numHosts; from++)
+        for (int to = 0; to < numHosts; to++)
+            delete rings[from][to];
+}
+
+//----------------------------------------------------------------------
+// HostNet::Publish
+// 	Let the other machines know that "host" has reached time "now".
+//	No packet it sends from now on can arrive before
+//	now + NetworkTime.
+//----------------------------------------------------------------------
+
+void
+HostNet::Publish(int host, int now)
+{
+    ASSERT(now >= clock[host]);
+    __sync_synchronize();		// earlier sends before the new clock
+    clock[host] = now;
+    __sync_synchronize();
+}
+
+//----------------------------------------------------------------------
+// HostNet::WaitForOthers
+// 	Wait until every other machine has reached now - NetworkTime + 1,
+//	so that all packets arriving by "now" are already on the rings.
+//----------------------------------------------------------------------
+
+void
+HostNet::WaitForOthers(int host, int now)
+{
+    for (int i = 0; i < numHosts; i++)
+        {
+            if (i == host)
+                continue;
+            while (clock[i] <= now - NetworkTime)
+                YieldHostThread();
+        }
+    __sync_synchronize();		// their clocks before our ring reads
+}
+
+//----------------------------------------------------------------------
+// HostNet::Send
+// 	Send a wire packet from one machine to another.  If the ring is
+//	full, wait for the receiver to drain it.
+//
+//	"from", "to" -- machine ids
+//	"packet" -- MaxWireSize bytes, header included
+//	"now" -- simulated time of the sender
+//----------------------------------------------------------------------
+
+void
+HostNet::Send(int from, int to, char *packet, int now)
+{
+    ASSERT((to >= 0) && (to < numHosts) && (to != from));
+
+    idle[from] = FALSE;
+    Publish(from, now);
+    if (clock[to] == Finished)  	// nobody left to receive it
+        {
+            return;
+        }
+    while (!rings[from][to]->Put(packet, now + NetworkTime))
+        YieldHostThread();
+}
+
+//----------------------------------------------------------------------
+// HostNet::Receive
+// 	Take the packet for machine "to" with the earliest arrival time
+//	not after "now", breaking ties by sender id.  Returns FALSE if
+//	no packet has arrived.
+//
+//	"idleNow" -- the receiving machine has no runnable thread and
+//		nothing pending but its network polls
+//----------------------------------------------------------------------
+
+bool
+HostNet::Receive(int to, char *packet, int now, bool idleNow)
+{
+    int best = -1, bestWhen = 0, when;
+
+    if (!idleNow)
+        {
+            idle[to] = FALSE;
+        }
+    Publish(to, now);
+    WaitForOthers(to, now);
+
+    for (int from = 0; from < numHosts; from++)
+        {
+            if (from == to || !rings[from][to]->Peek(&when) || when > now)
+                continue;
+            if (best < 0 || when < bestWhen)
+                {
+                    best = from;
+                    bestWhen = when;
+                }
+        }
+    if (best < 0)
+        {
+            idle[to] = idleNow;
+            return FALSE;
+        }
+
+    idle[to] = FALSE;
+    __sync_fetch_and_add(&received[to], 1);	// see Quiescent
+    rings[best][to]->Get(packet);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// HostNet::Quiescent
+// 	Return TRUE if every machine is idle or finished and no packet
+//	is in flight; then nothing can ever happen again.
+//
+//	A machine clears its idle flag and bumps its receive count
+//	before it takes a packet off a ring, so if the counts are the
+//	same before and after the scan, no packet slipped past it.
+//----------------------------------------------------------------------
+
+bool
+HostNet::Quiescent()
+{
+    int before = 0, after = 0;
+
+    for (int i = 0; i < numHosts; i++)
+        before += received[i];
+    __sync_synchronize();
+    for (int i = 0; i < numHosts; i++)
+        {
+            if (!idle[i])
+                return FALSE;
+        }
+    for (int from = 0; from < numHosts; from++)
+        for (int to = 0; to < numHosts; to++)
+            if (from != to && clock[to] != Finished &&
+                    !rings[from][to]->IsEmpty())
+                return FALSE;
+    __sync_synchronize();
+    for (int i = 0; i < numHosts; i++)
+        after += received[i];
+    return before == after;
+}
+
+//----------------------------------------------------------------------
+// HostNet::Finish
+// 	Machine "host" has halted; the others need not wait for it.
+//	Packets still on its rings are never delivered, and packets
+//	sent to it from now on are dropped.
+//----------------------------------------------------------------------
+
+void
+HostNet::Finish(int host)
+{
+    idle[host] = TRUE;
+    __sync_synchronize();
+    clock[host] = Finished;
+    __sync_synchronize();
+}
@@ -0,0 +1,107 @@
+// hostnet.h
+//	Data structures to connect several simulated machines that run
+//	in the same UNIX process ("nachos -hosts N"), each on its own
+//	host thread, without going through UNIX sockets.
+//
+//	Every ordered pair of machines is connected by a lock-free,
+//	single-producer/single-consumer ring of wire packets.  Each packet
+//	is stamped with the simulated time at which it arrives
+//	(send time + NetworkTime).
+//
+//	The machines keep their own simulated clocks.  To keep a run
+//	deterministic, synchronization is conservative: before a machine
+//	looks for packets that have arrived by time "now", it waits until
+//	every other machine has reached at least now - NetworkTime + 1.
+//	Any packet sent after that point cannot arrive by "now", so the
+//	packets delivered never depend on how the host threads happen to
+//	be scheduled.  The machine with the lowest clock never waits, so
+//	the scheme cannot deadlock.
+//
+//	When every machine is idle, with nothing pending but network
+//	polls, and no packet is in flight, no machine can ever receive
+//	anything again; the machines then stop polling and halt.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTNET_H
+#define HOSTNET_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "network.h"
+
+const int MaxHosts = 8;		// most machines in one process
+const int RingSize = 256;	// packets in flight per pair of machines
+
+// The following class defines a ring of packets from one machine to
+// another.  Only the sending host thread calls Put, only the receiving
+// host thread calls Peek and Get, so no lock is needed; memory barriers
+// order the slot contents with respect to the indices.
+
+class PacketRing
+{
+public:
+    PacketRing();
+
+    bool Put(char *packet, int when);	// FALSE if the ring is full
+    bool Peek(int *when);		// FALSE if the ring is empty,
+    // otherwise arrival time of the oldest packet
+    void Get(char *packet);		// remove the oldest packet
+    bool IsEmpty();
+
+private:
+    struct Slot
+    {
+        int when;			// simulated arrival time
+        char data[MaxWireSize];		// packet header and payload
+    } slots[RingSize];
+    volatile unsigned int head;		// next slot to read
+    volatile unsigned int tail;		// next slot to write
+};
+
+// The following class defines the whole in-process network: a ring for
+// every pair of machines and the published simulated clock of each.
+
+class HostNet
+{
+public:
+    HostNet(int numHosts);		// connect "numHosts" machines
+    ~HostNet();
+
+    int NumHosts()
+    {
+        return numHosts;
+    }
+
+    void Send(int from, int to, char *packet, int now);
+    // Put a wire packet sent at "now"
+    // on the ring from "from" to "to".
+    bool Receive(int to, char *packet, int now, bool idle);
+    // Wait until no other machine can
+    // still send a packet arriving by
+    // "now", then take the earliest such
+    // packet.  "idle" says whether the
+    // receiver has nothing to do but wait
+    // for packets.
+    bool Quiescent();			// TRUE once every machine is idle
+    // and no packet is in flight
+    void Finish(int host);		// machine has halted, stop waiting
+    // for it
+
+private:
+    int numHosts;
+    PacketRing *rings[MaxHosts][MaxHosts];	// rings[from][to]
+    volatile int clock[MaxHosts];	// published simulated time
+    volatile bool idle[MaxHosts];	// nothing to do but wait for packets
+    volatile int received[MaxHosts];	// packets each machine took in
+
+    void Publish(int host, int now);	// tell the others our clock
+    void WaitForOthers(int host, int now);
+    // conservative time synchronization
+};
+
+extern HostNet *hostNet;		// NULL unless running "-hosts N"
+
+#endif // HOSTNET_H
@@ -186,6 +186,8 @@ Interrupt::OneTick()
         {
             // for a context switch, ok to do it now
             yieldOnReturn = FALSE;
+            if (oldStatus == UserMode)
+                kernel->machine->ClearLink();	// break an LL/SC sequence
             status = SystemMode;		// yield is a kernel routine
             kernel->currentThread->Yield();
             status = oldStatus;
@@ -304,6 +306,30 @@ Interrupt::IntCloseFile(OpenFileId id)
     return kernel->KClose(id);
 }
 
+int
+Interrupt::IntCloneFile(char *from, char *to)
+{
+    return kernel->KClone(from, to);
+}
+
+int
+Interrupt::IntRemoveFile(char *filename)
+{
+    return kernel->KRemove(filename);
+}
+
+int
+Interrupt::IntSeekFile(int position, OpenFileId id)
+{
+    return kernel->KSeek(position, id);
+}
+
+int
+Interrupt::IntPipe(OpenFileId *readId, OpenFileId *writeId)
+{
+    return kernel->KPipe(readId, writeId);
+}
+
 #endif
 
 //----------------------------------------------------------------------
@@ -411,6 +437,28 @@ PrintPending (PendingInterrupt *pending)
     cout << ", scheduled at " << pending->when;
 }
 
+//----------------------------------------------------------------------
+// Interrupt::IsPendingOtherThan
+// 	Return TRUE if any interrupt other than one of type "type" is
+//	scheduled.  Used by the in-process network to tell whether a
+//	machine has anything left to do besides polling for packets.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::IsPendingOtherThan(IntType type)
+{
+    ListIterator<PendingInterrupt *> iter(pending);
+
+    for (; !iter.IsDone(); iter.Next())
+        {
+            if (iter.Item()->type != type)
+                {
+                    return TRUE;
+                }
+        }
+    return FALSE;
+}
+
 //----------------------------------------------------------------------
 // DumpState
 // 	Print the complete interrupt state - the status, and all interrupts
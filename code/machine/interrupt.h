@@ -111,6 +111,10 @@ public:
     int IntReadFile(char *buf, int size, OpenFileId id);
     int IntWriteFile(char *buf, int size, OpenFileId id);
     int IntCloseFile(OpenFileId id);
+    int IntCloneFile(char *from, char *to);
+    int IntRemoveFile(char *filename);
+    int IntSeekFile(int position, OpenFileId id);
+    int IntPipe(OpenFileId *readId, OpenFileId *writeId);
 #endif
 
     void YieldOnReturn();	// cause a context switch on return
@@ -128,6 +132,10 @@ public:
 
     void DumpState();		// Print interrupt state
 
+    bool IsPendingOtherThan(IntType type);
+    // Is any interrupt of another type
+    // scheduled?
+
 
     // NOTE: the following are internal to the hardware simulation code.
     // DO NOT call these directly.  I should make them "private",
@@ -11,6 +11,10 @@
 #include "machine.h"
 #include "main.h"
 
+// size of physical memory, may be changed on the command line
+__thread int PageSize = DefaultPageSize;
+__thread int NumPhysPages = DefaultNumPhysPages;
+
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
 static char* exceptionNames[] = { "no exception", "syscall",
@@ -52,26 +56,34 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"numCpus" -- how many CPUs share main memory (1 for a uniprocessor)
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, int numCpus)
 {
-    int i;
+    int i, j;
 
-    for (i = 0; i < NumTotalRegs; i++)
-        registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
-        mainMemory[i] = 0;
+    ASSERT((numCpus >= 1) && (numCpus <= MaxCpus));
+    this->numCpus = numCpus;
+    for (j = 0; j < numCpus; j++)
+        {
+            for (i = 0; i < NumTotalRegs; i++)
+                cpuRegisters[j][i] = 0;
+            link[j] = -1;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-        tlb[i].valid = FALSE;
-    pageTable = NULL;
+            cpuTlb[j] = new TranslationEntry[TLBSize];
+            for (i = 0; i < TLBSize; i++)
+                cpuTlb[j][i].valid = FALSE;
 #else	// use linear page table
-    tlb = NULL;
-    pageTable = NULL;
+            cpuTlb[j] = NULL;
 #endif
+        }
+    ASSERT((PageSize >= 4) && ((PageSize & (PageSize - 1)) == 0));
+    ASSERT(NumPhysPages > 0);
+    mainMemory = new char[MemorySize];
+    bzero(mainMemory, MemorySize);
+    pageTable = NULL;
+    SetCpu(0);
 
     singleStep = debug;
     CheckEndian();
@@ -85,8 +97,26 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
-    if (tlb != NULL)
-        delete [] tlb;
+    for (int j = 0; j < numCpus; j++)
+        if (cpuTlb[j] != NULL)
+            delete [] cpuTlb[j];
+}
+
+//----------------------------------------------------------------------
+// Machine::SetCpu
+// 	Switch the simulation to CPU "which": from now on, user instructions
+//	use that CPU's register file and TLB.  Main memory is shared.
+//
+//	"which" -- the CPU to switch to
+//----------------------------------------------------------------------
+
+void
+Machine::SetCpu(int which)
+{
+    ASSERT((which >= 0) && (which < numCpus));
+    cpu = which;
+    registers = cpuRegisters[which];
+    tlb = cpuTlb[which];
 }
 
 //----------------------------------------------------------------------
@@ -105,6 +135,7 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    ClearLink();			// the kernel may switch threads
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     kernel->interrupt->setStatus(UserMode);
@@ -26,20 +26,26 @@
 #include "translate.h"
 
 // Definitions related to the size, and format of user memory
+//
+// The page size and the number of pages of physical memory are chosen
+// at startup ("-ps" and "-pages", see Kernel::Kernel), before the
+// Machine is created, so that memory experiments need no rebuild.
+// They are kept per host thread, like the kernel itself.
 
-const int PageSize = 128; 		// set the page size equal to
+const int DefaultPageSize = 128;	// set the page size equal to
 // the disk sector size, for simplicity
+const int DefaultNumPhysPages = 128;
 
-//
-// You are allowed to change this value.
-// Doing so will change the number of pages of physical memory
-// available on the simulated machine.
-//
-const int NumPhysPages = 128;
+extern __thread int PageSize;		// bytes per page, a power of two
+extern __thread int NumPhysPages;	// pages of physical memory
 
-const int MemorySize = (NumPhysPages * PageSize);
+#define MemorySize (NumPhysPages * PageSize)
 const int TLBSize = 4;			// if there is a TLB, make it small
 
+// In SMP mode the machine has several CPUs sharing "mainMemory".
+// Each CPU has its own register file and TLB.
+const int MaxCpus = 8;
+
 enum ExceptionType { NoException,           // Everything ok!
                      SyscallException,      // A program executed a system call.
                      PageFaultException,    // No valid translation found
@@ -94,8 +100,8 @@ class Interrupt;
 class Machine
 {
 public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-    // for running user programs
+    Machine(bool debug, int numCpus);	// Initialize the simulation of the
+    // hardware for running user programs
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -106,6 +112,24 @@ public:
     void WriteRegister(int num, int value);
     // store a value into a CPU register
 
+    void SetCpu(int which);	// Make CPU "which" the one that executes
+    // the next user instruction; switches
+    // the register file and the TLB
+    int CurrentCpu()
+    {
+        return cpu;
+    }
+    int NumCpus()
+    {
+        return numCpus;
+    }
+    void ClearLink()
+    {
+        link[cpu] = -1;
+    }
+    // Make the next SC of the current CPU
+    // fail; done on every trap and switch
+
 // Data structures accessible to the Nachos kernel -- main memory and the
 // page table/TLB.
 //
@@ -129,7 +153,8 @@ public:
 //
 // For simplicity, both the page table pointer and the TLB pointer are
 // public.  However, while there can be multiple page tables (one per address
-// space, stored in memory), there is only one TLB (implemented in hardware).
+// space, stored in memory), there is only one TLB per CPU (implemented in
+// hardware).
 // Thus the TLB pointer should be considered as *read-only*, although
 // the contents of the TLB are free to be modified by the kernel software.
 
@@ -172,7 +197,15 @@ private:
 
 // Internal data structures
 
-    int registers[NumTotalRegs]; // CPU registers, for executing user programs
+    int *registers;		// CPU registers of the current CPU, for
+    // executing user programs
+    int cpuRegisters[MaxCpus][NumTotalRegs]; // one register file per CPU
+    TranslationEntry *cpuTlb[MaxCpus];	// one TLB per CPU, if any
+    int cpu;			// the CPU currently executing
+    int link[MaxCpus];		// physical address each CPU's last LL
+    // loaded, until a store to it or a trap;
+    // -1 if none
+    int numCpus;		// number of simulated CPUs
 
     bool singleStep;		// drop back into the debugger after each
     // simulated instruction
@@ -132,6 +132,8 @@ Machine::OneInstruction(Instruction *instr)
     int nextLoadReg = 0;
     int nextLoadValue = 0; 	// record delayed load operation, to apply
     // in the future
+    int pAddr;			// physical address, for LL and SC
+    ExceptionType exception;
 
     // Fetch instruction
     if (!ReadMem(registers[PCReg], 4, &raw))
@@ -325,6 +327,26 @@ Machine::OneInstruction(Instruction *instr)
             nextLoadValue = value;
             break;
 
+        case OP_LL:
+            // load linked: LW, and remember the word for the SC that
+            // follows, so that user programs can build atomic operations
+            tmp = registers[instr->rs] + instr->extra;
+            if (tmp & 0x3)
+                {
+                    RaiseException(AddressErrorException, tmp);
+                    return;
+                }
+            exception = Translate(tmp, &pAddr, 4, FALSE);
+            if (exception != NoException)
+                {
+                    RaiseException(exception, tmp);
+                    return;
+                }
+            link[cpu] = pAddr;
+            nextLoadReg = instr->rt;
+            nextLoadValue = WordToHost(*(unsigned int *) &mainMemory[pAddr]);
+            break;
+
         case OP_LWL:
             tmp = registers[instr->rs] + instr->extra;
 
@@ -566,6 +588,35 @@ Machine::OneInstruction(Instruction *instr)
                 return;
             break;
 
+        case OP_SC:
+            // store conditional: SW, only if nothing has stored to the
+            // word, and no trap has happened, since the LL; rt gets 1 if
+            // the store was done, and 0 if not
+            tmp = registers[instr->rs] + instr->extra;
+            if (tmp & 0x3)
+                {
+                    RaiseException(AddressErrorException, tmp);
+                    return;
+                }
+            exception = Translate(tmp, &pAddr, 4, TRUE);
+            if (exception != NoException)
+                {
+                    RaiseException(exception, tmp);
+                    return;
+                }
+            if (link[cpu] == pAddr)
+                {
+                    if (!WriteMem(tmp, 4, registers[instr->rt]))
+                        return;
+                    registers[instr->rt] = 1;
+                }
+            else
+                {
+                    registers[instr->rt] = 0;
+                }
+            link[cpu] = -1;
+            break;
+
         case OP_SWL:
             tmp = registers[instr->rs] + instr->extra;
 
@@ -1,6 +1,8 @@
 // network.cc
 //	Routines to simulate a network interface, using UNIX sockets
 //	to deliver packets between multiple invocations of nachos.
+//	When several machines run in one process ("-hosts N"), packets
+//	go through the in-memory rings of hostnet.cc instead.
 //
 //  DO NOT CHANGE -- part of the machine emulation
 //
@@ -10,6 +12,7 @@
 
 #include "copyright.h"
 #include "network.h"
+#include "hostnet.h"
 #include "main.h"
 
 //-----------------------------------------------------------------------
@@ -26,10 +29,14 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
     packetAvail = FALSE;
     inHdr.length = 0;
 
-    sock = OpenSocket();
-    sprintf(sockName, "SOCKET_%d", kernel->hostName);
-    AssignNameToSocket(sockName, sock);		 // Bind socket to a filename
-    // in the current directory.
+    sock = -1;
+    if (hostNet == NULL)
+        {
+            sock = OpenSocket();
+            sprintf(sockName, "SOCKET_%d", kernel->hostName);
+            AssignNameToSocket(sockName, sock);	// Bind socket to a filename
+            // in the current directory.
+        }
 
     // start polling for incoming packets
     kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
@@ -43,8 +50,11 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 
 NetworkInput::~NetworkInput()
 {
-    CloseSocket(sock);
-    DeAssignNameToSocket(sockName);
+    if (sock >= 0)
+        {
+            CloseSocket(sock);
+            DeAssignNameToSocket(sockName);
+        }
 }
 
 //-----------------------------------------------------------------------
@@ -60,6 +70,14 @@ NetworkInput::~NetworkInput()
 void
 NetworkInput::CallBack()
 {
+    char *buffer;
+
+    if (hostNet != NULL)
+        {
+            InProcessCallBack();
+            return;
+        }
+
     // schedule the next time to poll for a packet
     kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
 
@@ -69,8 +87,58 @@ NetworkInput::CallBack()
         return;
 
     // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
+    buffer = new char[MaxWireSize];
     ReadFromSocket(sock, buffer, MaxWireSize);
+    Deliver(buffer);
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::InProcessCallBack
+//	Poll the in-memory rings of the other machines in this process.
+//	Once every machine is idle and no packet is in flight, stop
+//	polling, so that the machine can halt.
+//-----------------------------------------------------------------------
+
+void
+NetworkInput::InProcessCallBack()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    bool idle;
+    char *buffer;
+
+    if (inHdr.length != 0)  	// packet is buffered, wait for the driver
+        {
+            interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+            return;
+        }
+
+    idle = (interrupt->getStatus() == IdleMode) &&
+           !interrupt->IsPendingOtherThan(NetworkRecvInt);
+    buffer = new char[MaxWireSize];
+    if (hostNet->Receive(kernel->hostName, buffer, kernel->stats->totalTicks, idle))
+        {
+            interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+            Deliver(buffer);
+            return;
+        }
+    delete [] buffer;
+    if (!idle || !hostNet->Quiescent())
+        {
+            interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+        }
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::Deliver
+//	Buffer a packet that came in off the wire, and tell whoever
+//	wants it.
+//
+//	"buffer" -- the wire packet, de-allocated here
+//-----------------------------------------------------------------------
+
+void
+NetworkInput::Deliver(char *buffer)
+{
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
@@ -120,7 +188,7 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
     // set up the stuff to emulate asynchronous interrupts
     callWhenDone = toCall;
     sendBusy = FALSE;
-    sock = OpenSocket();
+    sock = (hostNet == NULL) ? OpenSocket() : -1;
 }
 
 //-----------------------------------------------------------------------
@@ -130,7 +198,10 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
 
 NetworkOutput::~NetworkOutput()
 {
-    CloseSocket(sock);
+    if (sock >= 0)
+        {
+            CloseSocket(sock);
+        }
 }
 
 //-----------------------------------------------------------------------
@@ -179,6 +250,13 @@ NetworkOutput::Send(PacketHeader hdr, char* data)
     char *buffer = new char[MaxWireSize];
     *(PacketHeader *)buffer = hdr;
     bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
+    if (hostNet != NULL)
+        {
+            hostNet->Send(kernel->hostName, hdr.to, buffer, kernel->stats->totalTicks);
+        }
+    else
+        {
+            SendToSocket(sock, buffer, MaxWireSize, toName);
+        }
     delete [] buffer;
 }
@@ -71,7 +71,11 @@ public:
     void CallBack();		// A packet may have arrived.
 
 private:
-    int sock;                   // UNIX socket number for incoming packets
+    void InProcessCallBack();	// CallBack when running "-hosts N"
+    void Deliver(char *buffer);	// Hand a wire packet to callWhenAvail
+
+    int sock;                   // UNIX socket number for incoming packets,
+    // -1 in "-hosts N" mode
     char sockName[32];          // File name corresponding to UNIX socket
 
     CallBackObj *callWhenAvail; // Interrupt handler, signalling packet has
@@ -103,7 +107,8 @@ public:
     // sent
 
 private:
-    int sock;                   // UNIX socket number for outgoing packets
+    int sock;                   // UNIX socket number for outgoing packets,
+    // -1 in "-hosts N" mode
     double chanceToWork;	// Likelihood packet will be dropped
     CallBackObj *callWhenDone;  // Interrupt handler, signalling next packet
     //      can be sent.
@@ -19,9 +19,12 @@
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
-    numDiskReads = numDiskWrites = 0;
+    numDiskReads = numDiskWrites = numSeekTicks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSyscalls = 0;
+    numContextSwitches = numUserLoads = numPageTableLoads = 0;
+    numRealTimeJobs = numDeadlineMisses = numRealTimeRejects = 0;
 }
 
 //----------------------------------------------------------------------
@@ -36,10 +39,21 @@ Statistics::Print()
     cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
     cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
-    cout << ", writes " << numDiskWrites << "\n";
+    cout << ", writes " << numDiskWrites;
+    cout << ", seek ticks " << numSeekTicks << "\n";
     cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
     cout << ", sent " << numPacketsSent << "\n";
+    cout << "System calls: " << numSyscalls << "\n";
+    cout << "Context switches: " << numContextSwitches;
+    cout << ", user registers loaded " << numUserLoads;
+    cout << ", page tables loaded " << numPageTableLoads << "\n";
+    if (numRealTimeJobs > 0 || numDeadlineMisses > 0 || numRealTimeRejects > 0)
+        {
+            cout << "Real-time: jobs " << numRealTimeJobs;
+            cout << ", deadline misses " << numDeadlineMisses;
+            cout << ", rejected " << numRealTimeRejects << "\n";
+        }
 }
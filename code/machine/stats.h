@@ -31,11 +31,19 @@ public:
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numSeekTicks;		// time the disk heads spent seeking
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numSyscalls;		// number of system calls made by user programs
+    int numContextSwitches;	// number of thread switches
+    int numUserLoads;		// user register sets loaded into a CPU
+    int numPageTableLoads;	// page tables loaded into the machine
+    int numRealTimeJobs;	// jobs real-time threads finished
+    int numDeadlineMisses;	// jobs that were not done by their deadline
+    int numRealTimeRejects;	// real-time threads refused admission
 
     Statistics(); 		// initialize everything to zero
 
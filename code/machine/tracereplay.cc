@@ -0,0 +1,515 @@
+// tracereplay.cc
+//	A standalone tool (not part of the Nachos kernel) to replay a
+//	disk trace recorded with "nachos -dt" through a disk latency
+//	model, so that caches and queue policies can be compared on the
+//	same request stream without rerunning the workload.
+//
+//	Usage: tracereplay [-dp profile] [-q fifo|sptf] [-k depth]
+//			   [-c cacheSectors] [-cp lru|fifo] [-b] trace
+//
+//	-dp reads the latency model from a profile (see diskmodel.h);
+//	    the default is the classic rotational disk
+//	-q picks the order in which queued requests are served: first
+//	    come first served, or shortest positioning time first
+//	    (as the disk does with "-ncq")
+//	-k is how many requests the disk may hold at once (default 1)
+//	-c puts a cache of that many sectors in front of each disk
+//	    (default none); read hits never reach the disk, writes are
+//	    written through
+//	-cp picks which sector the cache replaces (default lru)
+//	-b ignores the recorded times and issues every request as soon
+//	    as there is room in the queue, to measure raw throughput
+//
+//	Requests are otherwise issued at the tick they were recorded at,
+//	open loop: a faster disk does not make later requests arrive
+//	sooner.  Each disk of the traced volume is replayed separately,
+//	with its own model, queue and cache.
+//
+//	For every disk, and for the whole trace, we report the total
+//	ticks until the last request completes, the cache hit rate, the
+//	mean response time, and how far the head had to seek.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "disktrace.h"
+#include "diskmodel.h"
+#include "disk.h"
+#include "debug.h"
+#include "sysdep.h"
+
+__thread Debug *debug;			// the library routines use it
+
+const int NumSeekBuckets = 7;		// 0, 1, 2-3, 4-7, 8-15, 16-31, more
+
+// Replay options, from the command line
+static char *profile = NULL;
+static bool shortestFirst = FALSE;
+static int queueDepth = 1;
+static int cacheSize = 0;
+static bool lruCache = TRUE;
+static bool backToBack = FALSE;
+
+// The following class defines a cache of sectors in front of one
+// disk.  Every sector of the disk has a slot telling where it is in
+// the cache, so lookups are cheap; finding a victim scans the cache.
+
+class SectorCache
+{
+public:
+    SectorCache(int size);
+    ~SectorCache();
+
+    bool Lookup(int sector, int now);	// is "sector" cached?  If so,
+    // count a use
+    void Insert(int sector, int now);	// cache it, replacing another
+
+private:
+    int size;
+    int *sectors;			// sector cached in each entry, or -1
+    int *stamps;			// when it was last used (LRU) or
+    // brought in (FIFO)
+    int *where;				// entry holding each disk sector
+};
+
+//----------------------------------------------------------------------
+// SectorCache::SectorCache
+// 	Initialize an empty cache of "size" sectors.
+//----------------------------------------------------------------------
+
+SectorCache::SectorCache(int size)
+{
+    this->size = size;
+    sectors = new int[size];
+    stamps = new int[size];
+    for (int i = 0; i < size; i++)
+        {
+            sectors[i] = -1;
+            stamps[i] = -1;
+        }
+    where = new int[NumSectors];
+    for (int i = 0; i < NumSectors; i++)
+        where[i] = -1;
+}
+
+SectorCache::~SectorCache()
+{
+    delete [] sectors;
+    delete [] stamps;
+    delete [] where;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Lookup
+// 	Return TRUE if "sector" is in the cache.
+//
+//	"now" -- a counter giving the order of the accesses
+//----------------------------------------------------------------------
+
+bool
+SectorCache::Lookup(int sector, int now)
+{
+    if (where[sector] < 0)
+        {
+            return FALSE;
+        }
+    if (lruCache)
+        {
+            stamps[where[sector]] = now;
+        }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Insert
+// 	Bring "sector" into the cache, if it is not there already,
+//	replacing the entry with the oldest stamp.
+//----------------------------------------------------------------------
+
+void
+SectorCache::Insert(int sector, int now)
+{
+    int victim = 0;
+
+    if (Lookup(sector, now))
+        {
+            return;
+        }
+    for (int i = 1; i < size; i++)
+        {
+            if (stamps[i] < stamps[victim])
+                victim = i;
+        }
+    if (sectors[victim] >= 0)
+        {
+            where[sectors[victim]] = -1;
+        }
+    sectors[victim] = sector;
+    stamps[victim] = now;
+    where[sector] = victim;
+}
+
+// What replaying one disk, or the whole trace, came to.
+class ReplayStats
+{
+public:
+    int numRequests;
+    int numHits;			// reads served by the cache
+    int endTime;			// when the last request completed
+    double totalResponse;		// ticks from issue to completion
+    double totalSeek;			// tracks the head moved over
+    int seeks[NumSeekBuckets];		// requests, by tracks moved
+    int byContext[NumIOContexts];	// requests, by file system context
+    int hitsByContext[NumIOContexts];
+
+    ReplayStats()
+    {
+        bzero(this, sizeof(ReplayStats));
+    }
+    void Add(ReplayStats *other);	// accumulate another disk's stats
+    void Print(char *title);
+};
+
+//----------------------------------------------------------------------
+// ReplayStats::Add
+// 	Accumulate the statistics of another disk into these.
+//----------------------------------------------------------------------
+
+void
+ReplayStats::Add(ReplayStats *other)
+{
+    numRequests += other->numRequests;
+    numHits += other->numHits;
+    if (other->endTime > endTime)
+        endTime = other->endTime;
+    totalResponse += other->totalResponse;
+    totalSeek += other->totalSeek;
+    for (int i = 0; i < NumSeekBuckets; i++)
+        seeks[i] += other->seeks[i];
+    for (int i = 0; i < NumIOContexts; i++)
+        {
+            byContext[i] += other->byContext[i];
+            hitsByContext[i] += other->hitsByContext[i];
+        }
+}
+
+//----------------------------------------------------------------------
+// ReplayStats::Print
+//----------------------------------------------------------------------
+
+void
+ReplayStats::Print(char *title)
+{
+    int misses = numRequests - numHits;
+    int low = 0;
+
+    cout << title << ": requests " << numRequests;
+    cout << ", total ticks " << endTime;
+    if (numRequests > 0)
+        {
+            cout << ", cache hits " << numHits << " ("
+                 << (100.0 * numHits / numRequests) << "%)";
+            cout << ", mean response " << totalResponse / numRequests;
+        }
+    cout << "\n";
+
+    if (misses > 0)
+        {
+            cout << "    seek distance in tracks, mean " << totalSeek / misses << ":";
+            for (int i = 0; i < NumSeekBuckets; i++)
+                {
+                    if (i < 2)
+                        cout << " " << i;
+                    else if (i < NumSeekBuckets - 1)
+                        cout << " " << low << "-" << (2 * low - 1);
+                    else
+                        cout << " " << low << "+";
+                    cout << ": " << seeks[i];
+                    low = (i == 0) ? 1 : 2 * low;
+                }
+            cout << "\n";
+        }
+
+    cout << "    by context:";
+    for (int i = 0; i < NumIOContexts; i++)
+        {
+            cout << " " << ioContextNames[i] << " " << byContext[i];
+            if (byContext[i] > 0 && cacheSize > 0)
+                {
+                    cout << " (" << (100.0 * hitsByContext[i] / byContext[i])
+                         << "% hits)";
+                }
+        }
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// SeekBucket
+// 	Return the histogram bucket for a seek of "tracks" tracks.
+//----------------------------------------------------------------------
+
+static int
+SeekBucket(int tracks)
+{
+    int bucket = 0;
+
+    while (tracks > 0 && bucket < NumSeekBuckets - 1)
+        {
+            tracks >>= 1;
+            bucket++;
+        }
+    return bucket;
+}
+
+//----------------------------------------------------------------------
+// ReplayDisk
+// 	Replay the requests of one disk through a fresh latency model,
+//	queue and cache.
+//
+//	"records", "numRecords" -- the whole trace
+//	"disk" -- which disk to replay
+//	"stats" -- where to put the results
+//----------------------------------------------------------------------
+
+static void
+ReplayDisk(TraceRecord *records, int numRecords, int disk, ReplayStats *stats)
+{
+    DiskModel *model = DiskModel::Load(profile);
+    SectorCache *cache = (cacheSize > 0) ? new SectorCache(cacheSize) : NULL;
+    TraceRecord *queue[MaxQueueDepth];
+    int issued[MaxQueueDepth];		// when each queued request was issued
+    int passedOver[MaxQueueDepth];
+    int numQueued = 0;
+    int now = 0, lastSector = 0, next = 0, accesses = 0;
+
+    for (;;)
+        {
+            // issue everything that has arrived, while there is room
+            while (next < numRecords && numQueued < queueDepth)
+                {
+                    TraceRecord *record = &records[next];
+                    int when = backToBack ? now : record->tick;
+
+                    if (record->disk != disk)
+                        {
+                            next++;
+                            continue;
+                        }
+                    if (when > now)
+                        break;
+                    next++;
+                    stats->numRequests++;
+                    stats->byContext[record->Context()]++;
+                    if (cache != NULL && !record->IsWrite()
+                            && cache->Lookup(record->sector, accesses++))
+                        {
+                            stats->numHits++;
+                            stats->hitsByContext[record->Context()]++;
+                            stats->totalResponse += now - when;
+                            continue;
+                        }
+                    queue[numQueued] = record;
+                    issued[numQueued] = when;
+                    passedOver[numQueued] = 0;
+                    numQueued++;
+                }
+
+            if (numQueued == 0)  		// disk idle: wait for the next one
+                {
+                    while (next < numRecords && records[next].disk != disk)
+                        next++;
+                    if (next == numRecords)
+                        break;
+                    if (!backToBack && records[next].tick > now)
+                        now = records[next].tick;
+                    continue;
+                }
+
+            // pick the request to serve, as Disk::StartNext does
+            int best = 0;
+            if (shortestFirst)
+                {
+                    int bestLatency = -1;
+                    for (int i = 0; i < numQueued; i++)
+                        {
+                            if (passedOver[i] >= MaxPassOver)
+                                {
+                                    best = i;
+                                    break;
+                                }
+                            int latency = model->Latency(now, queue[i]->sector,
+                                                         queue[i]->IsWrite());
+                            if (bestLatency < 0 || latency < bestLatency)
+                                {
+                                    best = i;
+                                    bestLatency = latency;
+                                }
+                        }
+                    for (int i = 0; i < best; i++)	// older ones
+                        passedOver[i]++;
+                }
+
+            TraceRecord *record = queue[best];
+            int latency = model->Latency(now, record->sector, record->IsWrite());
+            int tracks = abs(record->sector / SectorsPerTrack
+                             - lastSector / SectorsPerTrack);
+
+            model->Access(now, record->sector, record->IsWrite());
+            now += latency;
+            lastSector = record->sector;
+            stats->totalSeek += tracks;
+            stats->seeks[SeekBucket(tracks)]++;
+            stats->totalResponse += now - issued[best];
+            if (cache != NULL)
+                {
+                    cache->Insert(record->sector, accesses++);
+                }
+
+            // keep the queue in arrival order, for FIFO
+            for (int i = best; i < numQueued - 1; i++)
+                {
+                    queue[i] = queue[i + 1];
+                    issued[i] = issued[i + 1];
+                    passedOver[i] = passedOver[i + 1];
+                }
+            numQueued--;
+        }
+
+    stats->endTime = now;
+    delete cache;
+    delete model;
+}
+
+//----------------------------------------------------------------------
+// ReadTrace
+// 	Read a whole trace file into memory, checking its header.
+//	Returns the records; "numRecords" and "numDisks" are set.
+//----------------------------------------------------------------------
+
+static TraceRecord *
+ReadTrace(char *name, int *numRecords, int *numDisks)
+{
+    int file = OpenForReadWrite(name, TRUE);
+    TraceHeader header;
+    TraceRecord *records;
+    int size;
+
+    Lseek(file, 0, 2);
+    size = Tell(file) - sizeof(TraceHeader);
+    Lseek(file, 0, 0);
+    if (size < 0 || ReadPartial(file, (char *) &header, sizeof(header))
+            != sizeof(header) || header.magic != TraceMagic)
+        {
+            cerr << name << " is not a disk trace\n";
+            Exit(1);
+        }
+    if (header.version != TraceVersion
+            || header.recordSize != sizeof(TraceRecord))
+        {
+            cerr << name << ": unsupported trace version " << header.version << "\n";
+            Exit(1);
+        }
+
+    *numRecords = size / sizeof(TraceRecord);
+    *numDisks = header.numDisks;
+    records = new TraceRecord[*numRecords + 1];
+    size = *numRecords * sizeof(TraceRecord);
+    if (ReadPartial(file, (char *) records, size) != size)
+        {
+            cerr << name << ": short read\n";
+            Exit(1);
+        }
+    Close(file);
+    return records;
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Parse the options, replay each disk of the trace, and report.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    char *traceName = NULL;
+    char title[32];
+    TraceRecord *records;
+    int numRecords, numDisks;
+    ReplayStats total;
+
+    debug = new Debug("");
+    for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-dp") == 0 && i + 1 < argc)
+                {
+                    profile = argv[++i];
+                }
+            else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+                {
+                    i++;
+                    shortestFirst = (strcmp(argv[i], "sptf") == 0);
+                    ASSERT(shortestFirst || strcmp(argv[i], "fifo") == 0);
+                }
+            else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+                {
+                    queueDepth = atoi(argv[++i]);
+                    ASSERT((queueDepth >= 1) && (queueDepth <= MaxQueueDepth));
+                }
+            else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+                {
+                    cacheSize = atoi(argv[++i]);
+                    ASSERT(cacheSize >= 0);
+                }
+            else if (strcmp(argv[i], "-cp") == 0 && i + 1 < argc)
+                {
+                    i++;
+                    lruCache = (strcmp(argv[i], "lru") == 0);
+                    ASSERT(lruCache || strcmp(argv[i], "fifo") == 0);
+                }
+            else if (strcmp(argv[i], "-b") == 0)
+                {
+                    backToBack = TRUE;
+                }
+            else if (argv[i][0] != '-' && traceName == NULL)
+                {
+                    traceName = argv[i];
+                }
+            else
+                {
+                    traceName = NULL;
+                    break;
+                }
+        }
+    if (traceName == NULL)
+        {
+            cerr << "Usage: tracereplay [-dp profile] [-q fifo|sptf] [-k depth]\n";
+            cerr << "                   [-c cacheSectors] [-cp lru|fifo] [-b] trace\n";
+            Exit(1);
+        }
+
+    records = ReadTrace(traceName, &numRecords, &numDisks);
+    cout << traceName << ": " << numRecords << " requests, " << numDisks
+         << " disk(s); queue " << (shortestFirst ? "sptf" : "fifo")
+         << " depth " << queueDepth << ", cache " << cacheSize << " sectors "
+         << (lruCache ? "lru" : "fifo") << "\n";
+
+    for (int disk = 0; disk < numDisks; disk++)
+        {
+            ReplayStats stats;
+
+            ReplayDisk(records, numRecords, disk, &stats);
+            if (numDisks > 1)
+                {
+                    sprintf(title, "Disk %d", disk);
+                    stats.Print(title);
+                }
+            total.Add(&stats);
+        }
+    total.Print("Total");
+
+    delete [] records;
+    delete debug;
+    return 0;
+}
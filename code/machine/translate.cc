@@ -177,6 +177,12 @@ Machine::WriteMem(int addr, int size, int value)
             ASSERT(FALSE);
         }
 
+    // a store to a linked word makes the SC that follows the LL fail
+    for (int i = 0; i < numCpus; i++)
+        {
+            if (link[i] == (physicalAddress & ~0x3))
+                link[i] = -1;
+        }
     return TRUE;
 }
 
@@ -260,7 +266,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong!
     // An invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NumPhysPages)
+    if (pageFrame >= (unsigned int) NumPhysPages)
         {
             DEBUG(dbgAddr, "Illegal pageframe " << pageFrame);
             return BusErrorException;
@@ -18,6 +18,8 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "main.h"
+#include "workqueue.h"
 
 //----------------------------------------------------------------------
 // Mail::Mail
@@ -143,78 +145,75 @@ MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data)
 //	Also initialize the network device, to allow post offices
 //	on different machines to deliver messages to one another.
 //
-//      We use a separate thread "the postal worker" to wait for messages
-//	to arrive, and deliver them to the correct mailbox.  Note that
-//	delivering messages to the mailboxes can't be done directly
-//	by the interrupt handlers, because it requires a Lock.
+//	The interrupt handler only pulls arriving messages off the
+//	network; delivering them to the mailboxes can't be done directly
+//	by the interrupt handler, because it requires a Lock, so it is
+//	left to the kernel's work queue.
 //
 //	"nBoxes" is the number of mail boxes in this Post Office
 //----------------------------------------------------------------------
 
 PostOfficeInput::PostOfficeInput(int nBoxes)
 {
-    messageAvailable = new Semaphore("message available", 0);
+    arrived = new List<Mail *>;
 
     numBoxes = nBoxes;
     boxes = new MailBox[nBoxes];
 
     network = new NetworkInput(this);
-
-    Thread *t = new Thread("postal worker", 1);
-
-    t->Fork(PostOfficeInput::PostalDelivery, this);
 }
 
 //----------------------------------------------------------------------
 // PostOfficeInput::~PostOfficeInput
-// 	De-allocate the post office data structures.
-//
-//	Since the postal helper is waiting on the "messageAvail" semaphore,
-//	we don't deallocate it!  This leaves garbage lying about,
-//	but the alternative is worse!
+// 	De-allocate the post office data structures, and any messages
+//	that never made it to their mailboxes.
 //----------------------------------------------------------------------
 
 PostOfficeInput::~PostOfficeInput()
 {
     delete network;
     delete [] boxes;
+    while (!arrived->IsEmpty())
+        delete arrived->RemoveFront();
+    delete arrived;
 }
 
 //----------------------------------------------------------------------
 // PostOffice::PostalDelivery
-// 	Wait for incoming messages, and put them in the right mailbox.
+// 	Put every message that has arrived since we last ran in the right
+//	mailbox.  Run by the work queue, with interrupts on.
 //
-//      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//	"data" -- the post office
 //----------------------------------------------------------------------
 
 void
 PostOfficeInput::PostalDelivery(void* data)
 {
     PostOfficeInput* _this = (PostOfficeInput*)data;
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
+    Mail *mail;
 
     for (;;)
         {
-            // first, wait for a message
-            _this->messageAvailable->P();
-            pktHdr = _this->network->Receive(buffer);
+            IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+            mail = _this->arrived->IsEmpty() ? NULL :
+                   _this->arrived->RemoveFront();
+            (void) kernel->interrupt->SetLevel(oldLevel);
+            if (mail == NULL)
+                break;
 
-            mailHdr = *(MailHeader *)buffer;
             if (debug->IsEnabled('n'))
                 {
                     cout << "Putting mail into mailbox: ";
-                    PrintHeader(pktHdr, mailHdr);
+                    PrintHeader(mail->pktHdr, mail->mailHdr);
                 }
 
             // check that arriving message is legal!
-            ASSERT(0 <= mailHdr.to && mailHdr.to < _this->numBoxes);
-            ASSERT(mailHdr.length <= MaxMailSize);
+            ASSERT(0 <= mail->mailHdr.to && mail->mailHdr.to < _this->numBoxes);
 
             // put into mailbox
-            _this->boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
+            _this->boxes[mail->mailHdr.to].Put(mail->pktHdr, mail->mailHdr,
+                                               mail->data);
+            delete mail;
         }
 }
 
@@ -247,13 +246,23 @@ PostOfficeInput::Receive(int box, PacketHeader *pktHdr,
 // PostOffice::CallBack
 // 	Interrupt handler, called when a packet arrives from the network.
 //
-//	Signal the PostalDelivery routine that it is time to get to work!
+//	Pull the packet off the network, so the next one can come in,
+//	and have the work queue run PostalDelivery.  Incoming messages
+//	have had the PacketHeader stripped off, but the MailHeader is
+//	still tacked on the front of the data.
 //----------------------------------------------------------------------
 
 void
 PostOfficeInput::CallBack()
 {
-    messageAvailable->V();
+    char buffer[MaxPacketSize];
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    pktHdr = network->Receive(buffer);
+    mailHdr = *(MailHeader *)buffer;
+    arrived->Append(new Mail(pktHdr, mailHdr, buffer + sizeof(MailHeader)));
+    kernel->workQueue->Enqueue(PostOfficeInput::PostalDelivery, this);
 }
 
 //----------------------------------------------------------------------
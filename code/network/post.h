@@ -117,8 +117,9 @@ public:
     // there is no message in the box.
 
     static void PostalDelivery(void* data);
-    // Wait for incoming messages,
-    // and then put them in the correct mailbox
+    // Put the messages that have arrived
+    // in the correct mailboxes; run by
+    // the kernel's work queue
 
     void CallBack();		// Called when incoming packet has arrived
     // and can be pulled off of network
@@ -128,7 +129,8 @@ private:
     NetworkInput *network;	// Physical network connection
     MailBox *boxes;		// Table of mail boxes to hold incoming mail
     int numBoxes;		// Number of mail boxes
-    Semaphore *messageAvailable;// V'ed when message has arrived from network
+    List<Mail *> *arrived;	// Messages pulled off the network, not
+    // yet in their mailboxes
 };
 
 class PostOfficeOutput : public CallBackObj
@@ -0,0 +1,77 @@
+# Run the file system benchmarks and print what each cost, in total
+# and per operation, as CSV (or JSON, with "-json").  Each benchmark
+# starts on a freshly formatted disk, onto which the program is then
+# copied; only the run that executes it is measured.  Flags in
+# $NACHOS_FLAGS are passed to every run, e.g. NACHOS_FLAGS="-lfs" or
+# "-bc 256", so that a change can be measured against the same suite:
+#
+#	make bench
+#	NACHOS_FLAGS="-bc 256" ./FS_bench.sh -json > cache.json
+#
+# The operation counts follow the parameters the programs are built
+# with (see the Makefile and the comment at the top of each program).
+
+NACHOS=../build.linux/nachos
+FORMAT=csv
+if [ "$1" = "-json" ]
+then
+    FORMAT=json
+fi
+
+# name, operations, directories to make first
+BENCHMARKS="
+FS_bseq_4k 64 -
+FS_bseq_64k 1024 -
+FS_bseq_1m 16384 -
+FS_brand_64k 512 -
+FS_brand_1m 512 -
+FS_bmeta 384 /d1,/d1/d2,/d1/d2/d3,/d1/d2/d3/d4
+FS_bappend 1024 -
+"
+
+if [ $FORMAT = csv ]
+then
+    echo "benchmark,ops,ticks,disk_reads,disk_writes,syscalls,ticks_per_op,reads_per_op,writes_per_op,syscalls_per_op"
+else
+    echo "["
+fi
+first=1
+echo "$BENCHMARKS" | while read name ops dirs
+do
+    if [ -z "$name" ]
+    then
+        continue
+    fi
+    $NACHOS $NACHOS_FLAGS -f > /dev/null
+    if [ "$dirs" != "-" ]
+    then
+        for dir in $(echo $dirs | tr , ' ')
+        do
+            $NACHOS $NACHOS_FLAGS -mkdir $dir > /dev/null
+        done
+    fi
+    $NACHOS $NACHOS_FLAGS -cp $name /$name > /dev/null
+    $NACHOS $NACHOS_FLAGS -stats -e /$name | awk -v name=$name -v ops=$ops \
+        -v format=$FORMAT -v first=$first '
+        /^Ticks: total/ { ticks = $3 + 0 }
+        /^Disk I\/O: reads/ { reads = $4 + 0; writes = $6 + 0 }
+        /^System calls:/ { syscalls = $3 + 0 }
+        END {
+            if (format == "csv")
+                printf "%s,%d,%d,%d,%d,%d,%.1f,%.3f,%.3f,%.3f\n", name, ops,
+                    ticks, reads, writes, syscalls, ticks / ops, reads / ops,
+                    writes / ops, syscalls / ops
+            else
+                printf "%s  {\"benchmark\": \"%s\", \"ops\": %d, \"ticks\": %d, " \
+                    "\"disk_reads\": %d, \"disk_writes\": %d, \"syscalls\": %d, " \
+                    "\"ticks_per_op\": %.1f, \"reads_per_op\": %.3f, " \
+                    "\"writes_per_op\": %.3f, \"syscalls_per_op\": %.3f}\n",
+                    first ? "" : ",", name, ops, ticks, reads, writes, syscalls,
+                    ticks / ops, reads / ops, writes / ops, syscalls / ops
+        }'
+    first=0
+done
+if [ $FORMAT = json ]
+then
+    echo "]"
+fi
@@ -0,0 +1,36 @@
+/* Large append stream benchmark.
+ * Streams BENCH_SIZE bytes into a file in BENCH_CHUNK byte writes,
+ * each one at the end of what was written so far.  A Nachos file gets
+ * its size when it is created, so the file is created at its final
+ * size and filled from the front.  FS_bench.sh counts
+ * BENCH_SIZE / BENCH_CHUNK operations.
+ */
+
+#include "syscall.h"
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE 1048576
+#endif
+#ifndef BENCH_CHUNK
+#define BENCH_CHUNK 1024
+#endif
+
+char buffer[BENCH_CHUNK];
+
+int main(void)
+{
+	OpenFileId fid;
+	int i;
+
+	for (i = 0; i < BENCH_CHUNK; i++)
+		buffer[i] = 'a' + i % 26;
+	if (Create("/stream", BENCH_SIZE) != 1) MSG("Failed on creating file");
+	fid = Open("/stream");
+	if (fid <= 0) MSG("Failed on opening file");
+	for (i = 0; i < BENCH_SIZE; i += BENCH_CHUNK) {
+		if (Write(buffer, BENCH_CHUNK, fid) != BENCH_CHUNK)
+			MSG("Failed on writing file");
+	}
+	Close(fid);
+	Halt();
+}
@@ -0,0 +1,49 @@
+/* Metadata benchmark: create, look up ("stat") and remove storms.
+ * FS_bench.sh first makes the directories /d1/d2/d3/d4; each of
+ * BENCH_ROUNDS rounds then creates BENCH_FILES empty files in the
+ * deepest one, opens and closes each (there is no Stat call, so this
+ * stands for one), and removes them all.  FS_bench.sh counts
+ * 3 * BENCH_ROUNDS * BENCH_FILES operations.
+ */
+
+#include "syscall.h"
+
+#ifndef BENCH_FILES
+#define BENCH_FILES 32
+#endif
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 4
+#endif
+
+char name[] = "/d1/d2/d3/d4/f00";
+
+/* point "name" at file "i" */
+void Name(int i)
+{
+	name[14] = '0' + i / 10;
+	name[15] = '0' + i % 10;
+}
+
+int main(void)
+{
+	OpenFileId fid;
+	int round, i;
+
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		for (i = 0; i < BENCH_FILES; i++) {
+			Name(i);
+			if (Create(name, 0) != 1) MSG("Failed on creating file");
+		}
+		for (i = 0; i < BENCH_FILES; i++) {
+			Name(i);
+			fid = Open(name);
+			if (fid <= 0) MSG("Failed on opening file");
+			Close(fid);
+		}
+		for (i = 0; i < BENCH_FILES; i++) {
+			Name(i);
+			if (Remove(name) != 1) MSG("Failed on removing file");
+		}
+	}
+	Halt();
+}
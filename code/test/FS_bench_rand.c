@@ -0,0 +1,49 @@
+/* Random read and write benchmark.
+ * Creates a BENCH_SIZE byte file, then does BENCH_OPS reads and
+ * BENCH_OPS writes of BENCH_CHUNK bytes, each at a random chunk of
+ * the file.  FS_bench.sh counts 2 * BENCH_OPS operations.
+ */
+
+#include "syscall.h"
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE 65536
+#endif
+#ifndef BENCH_CHUNK
+#define BENCH_CHUNK 128
+#endif
+#ifndef BENCH_OPS
+#define BENCH_OPS 256
+#endif
+
+char buffer[BENCH_CHUNK];
+unsigned seed = 1;
+
+/* the same sequence on every run, so that runs can be compared */
+int Random(int n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % n;
+}
+
+int main(void)
+{
+	OpenFileId fid;
+	int i, chunks = BENCH_SIZE / BENCH_CHUNK;
+
+	if (Create("/bench", BENCH_SIZE) != 1) MSG("Failed on creating file");
+	fid = Open("/bench");
+	if (fid <= 0) MSG("Failed on opening file");
+	for (i = 0; i < BENCH_OPS; i++) {
+		Seek(Random(chunks) * BENCH_CHUNK, fid);
+		if (Write(buffer, BENCH_CHUNK, fid) != BENCH_CHUNK)
+			MSG("Failed on writing file");
+	}
+	for (i = 0; i < BENCH_OPS; i++) {
+		Seek(Random(chunks) * BENCH_CHUNK, fid);
+		if (Read(buffer, BENCH_CHUNK, fid) != BENCH_CHUNK)
+			MSG("Failed on reading file");
+	}
+	Close(fid);
+	Halt();
+}
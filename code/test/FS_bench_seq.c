@@ -0,0 +1,45 @@
+/* Sequential read and write benchmark.
+ * Writes a BENCH_SIZE byte file from start to end in BENCH_CHUNK byte
+ * writes, then reads it back the same way.  Built at several sizes
+ * (see the Makefile); FS_bench.sh counts 2 * BENCH_SIZE / BENCH_CHUNK
+ * operations.
+ */
+
+#include "syscall.h"
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE 65536
+#endif
+#ifndef BENCH_CHUNK
+#define BENCH_CHUNK 128
+#endif
+
+char buffer[BENCH_CHUNK];
+
+int main(void)
+{
+	OpenFileId fid;
+	int i, j;
+
+	if (Create("/bench", BENCH_SIZE) != 1) MSG("Failed on creating file");
+	fid = Open("/bench");
+	if (fid <= 0) MSG("Failed on opening file");
+	for (i = 0; i < BENCH_SIZE; i += BENCH_CHUNK) {
+		for (j = 0; j < BENCH_CHUNK; j++)
+			buffer[j] = i + j;
+		if (Write(buffer, BENCH_CHUNK, fid) != BENCH_CHUNK)
+			MSG("Failed on writing file");
+	}
+	Close(fid);
+
+	fid = Open("/bench");
+	if (fid <= 0) MSG("Failed on opening file");
+	for (i = 0; i < BENCH_SIZE; i += BENCH_CHUNK) {
+		if (Read(buffer, BENCH_CHUNK, fid) != BENCH_CHUNK)
+			MSG("Failed on reading file");
+		if (buffer[0] != (char) i)
+			MSG("Failed: reading wrong result");
+	}
+	Close(fid);
+	Halt();
+}
@@ -0,0 +1,66 @@
+#include "syscall.h"
+
+int main(void)
+{
+	// you should run FS_test1 first before running this one
+	char test[27];
+	char check[] = "abcdefghijklmnopqrstuvwxyz\n";
+	char upper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ\n";
+	char reverse[] = "zyxwvutsrqponmlkjihgfedcba\n";
+	OpenFileId fid, fid2;
+	int count, success, i;
+	success = Clone("/file1", "/clone1");
+	if (success != 1) MSG("Failed on cloning file");
+	// write the clone; the original must not change
+	fid = Open("/clone1");
+	if (fid <= 0) MSG("Failed on opening clone");
+	count = Write(upper, 27, fid);
+	if (count != 27) MSG("Failed on writing clone");
+	success = Close(fid);
+	if (success != 1) MSG("Failed on closing clone");
+	fid = Open("/file1");
+	if (fid <= 0) MSG("Failed on opening file");
+	count = Read(test, 27, fid);
+	if (count != 27) MSG("Failed on reading file");
+	Close(fid);
+	for (i = 0; i < 27; ++i) {
+		if (test[i] != check[i]) MSG("Failed: original changed by the clone");
+	}
+	fid = Open("/clone1");
+	count = Read(test, 27, fid);
+	if (count != 27) MSG("Failed on reading clone");
+	Close(fid);
+	for (i = 0; i < 27; ++i) {
+		if (test[i] != upper[i]) MSG("Failed: reading wrong result");
+	}
+	// clone again, and write the original through two open files:
+	// the second must find the copy the first one made, and leave
+	// the clone alone
+	success = Clone("/file1", "/clone2");
+	if (success != 1) MSG("Failed on cloning file again");
+	fid = Open("/file1");
+	fid2 = Open("/file1");
+	if (fid <= 0 || fid2 <= 0) MSG("Failed on opening file twice");
+	count = Write(upper, 27, fid);
+	if (count != 27) MSG("Failed on writing file");
+	count = Write(reverse, 27, fid2);
+	if (count != 27) MSG("Failed on writing file again");
+	Close(fid);
+	Close(fid2);
+	fid = Open("/clone2");
+	count = Read(test, 27, fid);
+	if (count != 27) MSG("Failed on reading second clone");
+	Close(fid);
+	for (i = 0; i < 27; ++i) {
+		if (test[i] != check[i]) MSG("Failed: clone changed by a stale open file");
+	}
+	fid = Open("/file1");
+	count = Read(test, 27, fid);
+	if (count != 27) MSG("Failed on reading file");
+	Close(fid);
+	for (i = 0; i < 27; ++i) {
+		if (test[i] != reverse[i]) MSG("Failed: second write lost");
+	}
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,10 @@
+../build.linux/nachos -f
+../build.linux/nachos -cp num_1000.txt /1000
+../build.linux/nachos -clone /1000 /copy
+../build.linux/nachos -p /copy > /tmp/FS_clone.out
+cmp /tmp/FS_clone.out num_1000.txt && echo "clone matches"
+../build.linux/nachos -cp FS_test1 /FS_test1
+../build.linux/nachos -e /FS_test1
+../build.linux/nachos -cp FS_clone /FS_clone
+../build.linux/nachos -e /FS_clone
+../build.linux/nachos -l /
@@ -0,0 +1,18 @@
+# Fragment the disk by creating files and removing every other one, so
+# that the last file is split across the holes, then defragment it.
+../build.linux/nachos -f
+../build.linux/nachos -mkdir /d
+for f in f1 f2 f3 f4 f5 f6
+do
+    ../build.linux/nachos -cp num_100.txt /d/$f
+done
+for f in f1 f3 f5
+do
+    ../build.linux/nachos -r /d/$f
+done
+../build.linux/nachos -cp num_1000.txt /d/big
+../build.linux/nachos -p /d/big > /tmp/FS_defrag.before
+../build.linux/nachos -defrag
+../build.linux/nachos -p /d/big > /tmp/FS_defrag.after
+cmp /tmp/FS_defrag.before /tmp/FS_defrag.after && echo "contents unchanged"
+../build.linux/nachos -lr /
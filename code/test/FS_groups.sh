@@ -0,0 +1,48 @@
+# Build the FS_partIII.sh tree twice, once with first-free placement and
+# once with allocation groups (-ag), list and read it back, and add up
+# the seek ticks each nachos run reports under -stats.  Both totals must
+# be nonzero, and differ.
+for flags in "" "-ag"
+do
+    total=0
+    while read args
+    do
+        ticks=`../build.linux/nachos -stats $flags $args | sed -n 's/.*seek ticks \([0-9]*\).*/\1/p'`
+        total=`expr $total + ${ticks:-0}`
+    done <<EOF
+-f
+-mkdir /t0
+-mkdir /t1
+-mkdir /t2
+-cp num_100.txt /t0/f1
+-mkdir /t0/aa
+-mkdir /t0/bb
+-mkdir /t0/cc
+-cp num_100.txt /t0/bb/f1
+-cp num_100.txt /t0/bb/f2
+-cp num_100.txt /t0/bb/f3
+-cp num_100.txt /t0/bb/f4
+-l /
+-l /t0
+-l /t0/bb
+-p /t0/f1
+-p /t0/bb/f3
+EOF
+    echo "nachos $flags: seek ticks $total"
+    if [ -z "$flags" ]
+    then
+        firstfree=$total
+    else
+        groups=$total
+    fi
+done
+if [ $firstfree -eq 0 -o $groups -eq 0 ]
+then
+    echo "FAILED: no seek ticks reported"
+    exit 1
+fi
+if [ $firstfree -eq $groups ]
+then
+    echo "FAILED: allocation groups did not change the seek ticks"
+    exit 1
+fi
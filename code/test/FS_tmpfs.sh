@@ -0,0 +1,16 @@
+# A tmpfs only lasts one run, so each test does its work in one
+# invocation.  With "-ds", the tmpfs runs show no disk requests beyond
+# the ones mounting the disk takes.
+../build.linux/nachos -f
+../build.linux/nachos -tmpfs /tmp -cp num_1000.txt /tmp/n -p /tmp/n > /tmp/FS_tmpfs.out
+cmp /tmp/FS_tmpfs.out num_1000.txt && echo "tmpfs copy matches"
+../build.linux/nachos -tmpfs /tmp -cp num_100.txt /tmp/n -l /tmp
+../build.linux/nachos -l /
+echo "========================================="
+# With the root in memory, the program itself has to be copied into
+# the tmpfs in the same run that executes it.
+../build.linux/nachos -ds -tmpfs / -cp FS_test1 /FS_test1 -e /FS_test1
+../build.linux/nachos -cp FS_test1 /FS_test1
+../build.linux/nachos -ds -e /FS_test1
+../build.linux/nachos -cp FS_test2 /FS_test2
+../build.linux/nachos -e /FS_test2
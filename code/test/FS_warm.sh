@@ -0,0 +1,14 @@
+# Run the same listing several times with -warm.  The first run starts
+# cold and records its hot sectors in DISK_0.warm; the later ones read
+# them in at mount, so their "Mount:" ticks should drop.  A run with
+# the same cache but without -warm is the cold baseline.
+../build.linux/nachos -f
+../build.linux/nachos -mkdir /t0
+../build.linux/nachos -mkdir /t0/aa
+../build.linux/nachos -cp num_100.txt /t0/aa/f1
+rm -f DISK_0.warm
+for run in 1 2 3
+do
+    ../build.linux/nachos -ds -warm -l /t0/aa | grep -E "f1|Mount|Buffer"
+done
+../build.linux/nachos -ds -bc 256 -l /t0/aa | grep -E "f1|Mount|Buffer"
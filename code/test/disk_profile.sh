@@ -0,0 +1,58 @@
+# Copy a file into a fresh disk and read it back, once with the default
+# disk model and once with each sample profile, adding up the seek ticks
+# and total ticks each nachos run reports under -stats.  Every profile
+# must change the totals; flash must not seek at all.
+for profile in "" rotational.profile flash.profile
+do
+    if [ -z "$profile" ]
+    then
+        dp=""
+    else
+        dp="-dp $profile"
+    fi
+    seeks=0
+    ticks=0
+    while read args
+    do
+        out=`../build.linux/nachos -stats $dp $args`
+        n=`echo "$out" | sed -n 's/.*seek ticks \([0-9]*\).*/\1/p'`
+        seeks=`expr $seeks + ${n:-0}`
+        n=`echo "$out" | sed -n 's/.*Ticks: total \([0-9]*\).*/\1/p'`
+        ticks=`expr $ticks + ${n:-0}`
+    done <<EOF
+-f
+-cp num_1000.txt /f
+-p /f
+EOF
+    echo "nachos $dp: seek ticks $seeks, total ticks $ticks"
+    case "$profile" in
+    "")
+        defseeks=$seeks
+        defticks=$ticks
+        ;;
+    flash.profile)
+        if [ $seeks -ne 0 ]
+        then
+            echo "FAILED: the flash model reported seek ticks"
+            exit 1
+        fi
+        ;;
+    *)
+        if [ $seeks -eq $defseeks ]
+        then
+            echo "FAILED: $profile did not change the seek ticks"
+            exit 1
+        fi
+        ;;
+    esac
+    if [ $ticks -eq $defticks -a -n "$profile" ]
+    then
+        echo "FAILED: $profile did not change the total ticks"
+        exit 1
+    fi
+done
+if [ $defseeks -eq 0 ]
+then
+    echo "FAILED: the default disk reported no seek ticks"
+    exit 1
+fi
@@ -0,0 +1,11 @@
+# How the disk lock scales: run an I/O heavy workload of kernel threads
+# (see threads/workload.h) on 1, 2 and 4 CPUs, and print the disk lock's
+# contention and the time the CPUs spent spinning on it.
+NACHOS=../build.linux/nachos
+WORKLOAD=${1:-seed=1,io=90,lock=0}
+
+for cpus in 1 2 4
+do
+    echo "-smp $cpus:"
+    $NACHOS -ds -smp $cpus -wl $WORKLOAD | grep -e "^SpinLock synch disk" -e "^SMP:"
+done
@@ -0,0 +1,8 @@
+# A flash device: no seeks, a fixed cost per page, and an erase every
+# time a block's worth of pages has been programmed.
+# Use with "nachos -dp flash.profile ...".
+model = flash
+page_read = 50		# ticks to read one page (sector)
+page_program = 200	# ticks to program one page
+block_erase = 2000	# ticks to erase one block
+pages_per_block = 64
@@ -0,0 +1,15 @@
+# Two machines in one process (-hosts 2) run the network test (-N), with
+# random time slices: each must get the other's message and then its
+# acknowledgement, and both must halt cleanly.  The run is
+# deterministic, so a second one prints the same lines.
+../build.linux/nachos -hosts 2 -f -rs 7 -N > /tmp/hosts_1.out || exit 1
+../build.linux/nachos -hosts 2 -f -rs 7 -N > /tmp/hosts_2.out || exit 1
+cat /tmp/hosts_1.out
+if [ `grep -c "^Got: " /tmp/hosts_1.out` -ne 4 ]
+then
+    echo "FAILED: the machines did not exchange both messages"
+    exit 1
+fi
+sort /tmp/hosts_1.out > /tmp/hosts_1.sorted
+sort /tmp/hosts_2.out > /tmp/hosts_2.sorted
+cmp /tmp/hosts_1.sorted /tmp/hosts_2.sorted && echo "hosts: repeatable"
@@ -0,0 +1,8 @@
+# Sbrk and Malloc.  "Paging: faults" in the statistics counts the pages
+# the program touched: its uninitialized data, heap and stack get memory
+# only then.  stack_test grows the stack on demand, and shrinks the heap.
+../build.linux/nachos -f
+../build.linux/nachos -cp malloc_test /malloc_test
+../build.linux/nachos -cp stack_test /stack_test
+../build.linux/nachos -stats -e /malloc_test
+../build.linux/nachos -stats -e /stack_test
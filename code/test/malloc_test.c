@@ -0,0 +1,74 @@
+/* Exercise Sbrk and Malloc: blocks of every size class and a few big
+ * ones are written, checked, freed and allocated again; then a large
+ * array is allocated and only a little of it touched.  Run with "-stats"
+ * (see malloc.sh) to see the page faults: one per page touched, not
+ * one per page allocated.
+ */
+
+#include "umalloc.h"
+
+#define NUM_BLOCKS	16
+#define BIG_SIZE	65536
+
+char *blocks[NUM_BLOCKS];
+
+/* one block of each small size class up to 1024 bytes, and one of a
+ * big block, twice over
+ */
+int SizeOf(int i)
+{
+	return (i % 8 < 7) ? (8 << (i % 8)) - 3 : 2500;
+}
+
+void Fill(int round)
+{
+	int i, j;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		blocks[i] = Malloc(SizeOf(i));
+		if (blocks[i] == 0) MSG("Failed on allocating a block");
+		if ((int) blocks[i] & 7) MSG("Failed: block not aligned");
+		for (j = 0; j < SizeOf(i); j++)
+			blocks[i][j] = i + j + round;
+	}
+}
+
+void Check(int round)
+{
+	int i, j;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		for (j = 0; j < SizeOf(i); j++) {
+			if (blocks[i][j] != (char) (i + j + round))
+				MSG("Failed: blocks overlap");
+		}
+	}
+}
+
+int main(void)
+{
+	char *start, *end, *big;
+	int i;
+
+	start = Sbrk(0);
+	if (*start != 0) MSG("Failed: new heap is not zero");
+
+	Fill(0);
+	Check(0);
+	end = Sbrk(0);
+	for (i = 0; i < NUM_BLOCKS; i++)
+		Free(blocks[i]);
+	Fill(1);
+	Check(1);
+	if (Sbrk(0) != end) MSG("Failed: freed blocks were not reused");
+
+	big = Malloc(BIG_SIZE);
+	if (big == 0) MSG("Failed on allocating a big block");
+	for (i = 0; i < BIG_SIZE; i += 8192)
+		big[i] = 1;
+	if (big[BIG_SIZE - 1] != 0) MSG("Failed: big block is not zero");
+
+	if (Sbrk(1 << 30) != (void *) -1) MSG("Failed: heap grew into the stack");
+	MSG("Passed! ^_^");
+	Halt();
+}
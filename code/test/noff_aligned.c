@@ -0,0 +1,25 @@
+/* Built twice (see the Makefile): "noff_aligned" with the aligned
+ * layout of "coff2noff -a", whose pages Nachos loads as whole sectors,
+ * and "noff_packed" with the usual one.  Both must find their
+ * initialized data, which spans more than one page, as it was written;
+ * "-d a" (see noff_aligned.sh) shows which layout was loaded.
+ */
+
+#include "syscall.h"
+
+#define TABLE_SIZE	2048
+
+int table[TABLE_SIZE] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+int main(void)
+{
+	int i, sum = 0;
+
+	for (i = 0; i < TABLE_SIZE; i++)
+		sum += table[i];
+	if (sum == 36)
+		MSG("Passed");
+	else
+		MSG("Failed on the initialized data");
+	Halt();
+}
@@ -0,0 +1,7 @@
+# A program converted with "coff2noff -a" and the same program in the
+# usual layout; each prints the layout it was loaded with, then "Passed".
+../build.linux/nachos -f
+../build.linux/nachos -cp noff_aligned /noff_aligned
+../build.linux/nachos -cp noff_packed /noff_packed
+../build.linux/nachos -d a -e /noff_aligned | grep -e layout -e Passed -e Failed
+../build.linux/nachos -d a -e /noff_packed | grep -e layout -e Passed -e Failed
@@ -0,0 +1,30 @@
+# Measure pipe throughput between two user programs, at several sizes
+# of Read and Write, as CSV.  Each run moves the same number of bytes
+# (PIPE_BYTES in the programs); flags in $NACHOS_FLAGS are passed to
+# every run, as for FS_bench.sh.  The programs are copied onto a
+# freshly formatted disk first:
+#
+#	make pipebench
+
+NACHOS=../build.linux/nachos
+BYTES=65536
+
+$NACHOS $NACHOS_FLAGS -f > /dev/null
+for chunk in 128 1k 4k
+do
+    $NACHOS $NACHOS_FLAGS -cp pipe_w_$chunk /pipe_w_$chunk > /dev/null
+    $NACHOS $NACHOS_FLAGS -cp pipe_r_$chunk /pipe_r_$chunk > /dev/null
+done
+
+echo "chunk,bytes,ticks,syscalls,bytes_per_kilotick,syscalls_per_kb"
+for chunk in 128 1k 4k
+do
+    $NACHOS $NACHOS_FLAGS -stats -e /pipe_w_$chunk -e /pipe_r_$chunk | \
+        awk -v chunk=$chunk -v bytes=$BYTES '
+        /^Ticks: total/ { ticks = $3 + 0 }
+        /^System calls:/ { syscalls = $3 + 0 }
+        END {
+            printf "%s,%d,%d,%d,%.1f,%.2f\n", chunk, bytes, ticks, syscalls,
+                ticks ? bytes * 1000 / ticks : 0, syscalls * 1024 / bytes
+        }'
+done
@@ -0,0 +1,48 @@
+/* Pipe throughput benchmark, reader side.
+ * Waits for pipe_bench_w to publish the pipe, then reads it in
+ * PIPE_CHUNK byte reads until the writer closes it, checking every
+ * byte.  Halts, so that "-stats" shows what the transfer cost.
+ */
+
+#include "syscall.h"
+
+#ifndef PIPE_BYTES
+#define PIPE_BYTES 65536
+#endif
+#ifndef PIPE_CHUNK
+#define PIPE_CHUNK 128
+#endif
+
+#define SHM_KEY		9
+#define SHM_ADDR	0x10000
+
+struct rendezvous {
+	volatile int ready;
+	volatile OpenFileId readId;
+};
+
+char buffer[PIPE_CHUNK];
+
+int main(void)
+{
+	struct rendezvous *r = (struct rendezvous *) SHM_ADDR;
+	int id, total = 0, count, j;
+
+	id = ShmCreate(SHM_KEY, 128);
+	if (id < 0 || ShmAttach(id, (char *) SHM_ADDR) != 1)
+		MSG("Failed on attaching the segment");
+	while (!r->ready)
+		;
+	while ((count = Read(buffer, PIPE_CHUNK, r->readId)) > 0) {
+		for (j = 0; j < count; j++) {
+			if (buffer[j] != (char) (total + j))
+				MSG("Failed: reading wrong result");
+		}
+		total += count;
+	}
+	if (count < 0) MSG("Failed on reading the pipe");
+	if (total != PIPE_BYTES) MSG("Failed: lost data in the pipe");
+	Close(r->readId);
+	ShmDetach(id);
+	Halt();
+}
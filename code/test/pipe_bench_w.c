@@ -0,0 +1,48 @@
+/* Pipe throughput benchmark, writer side.
+ * Makes a pipe, publishes its descriptors in a shared memory segment
+ * for pipe_bench_r, and writes PIPE_BYTES bytes into it in PIPE_CHUNK
+ * byte writes.  Built at several chunk sizes (see the Makefile), and
+ * run by pipe_bench.sh.
+ */
+
+#include "syscall.h"
+
+#ifndef PIPE_BYTES
+#define PIPE_BYTES 65536
+#endif
+#ifndef PIPE_CHUNK
+#define PIPE_CHUNK 128
+#endif
+
+#define SHM_KEY		9
+#define SHM_ADDR	0x10000
+
+struct rendezvous {
+	volatile int ready;
+	volatile OpenFileId readId;
+};
+
+char buffer[PIPE_CHUNK];
+
+int main(void)
+{
+	struct rendezvous *r = (struct rendezvous *) SHM_ADDR;
+	OpenFileId fds[2];
+	int id, i, j;
+
+	id = ShmCreate(SHM_KEY, 128);
+	if (id < 0 || ShmAttach(id, (char *) SHM_ADDR) != 1)
+		MSG("Failed on attaching the segment");
+	if (Pipe(fds) != 1) MSG("Failed on making the pipe");
+	r->readId = fds[0];
+	r->ready = 1;
+	for (i = 0; i < PIPE_BYTES; i += PIPE_CHUNK) {
+		for (j = 0; j < PIPE_CHUNK; j++)
+			buffer[j] = i + j;
+		if (Write(buffer, PIPE_CHUNK, fds[1]) != PIPE_CHUNK)
+			MSG("Failed on writing the pipe");
+	}
+	Close(fds[1]);
+	ShmDetach(id);
+	Exit(0);
+}
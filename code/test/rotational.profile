@@ -0,0 +1,6 @@
+# A faster rotational disk than the Nachos default (seek 500, rotate 500,
+# track buffer on).  Use with "nachos -dp rotational.profile ...".
+model = rotational
+seek_time = 100		# ticks to seek past one track
+rotation_time = 200	# ticks to rotate past one sector
+track_buffer = 0	# no read-ahead of the rest of the track
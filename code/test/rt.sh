@@ -0,0 +1,8 @@
+# Real-time threads.  rt_task does 20 periodic jobs while rt_hog keeps
+# the CPU busy; "Real-time:" in the statistics shows no deadline misses.
+../build.linux/nachos -f
+../build.linux/nachos -cp rt_task /rt_task
+../build.linux/nachos -cp rt_hog /rt_hog
+../build.linux/nachos -stats -e /rt_task -e /rt_hog
+# Each rt_task takes a quarter of the CPU, so the fifth one is refused.
+../build.linux/nachos -stats -e /rt_task -e /rt_task -e /rt_task -e /rt_task -e /rt_task
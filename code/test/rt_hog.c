@@ -0,0 +1,19 @@
+/* A best-effort program that computes without blocking, to compete
+ * with the real-time rt_task for the CPU (see rt.sh).
+ */
+
+#include "syscall.h"
+
+#define LOOPS	20000
+
+int sum;
+
+int
+main()
+{
+	int i;
+
+	for (i = 0; i < LOOPS; i++)
+		sum += i;
+	Exit(0);
+}
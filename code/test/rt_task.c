@@ -0,0 +1,31 @@
+/* A periodic real-time task: every PERIOD ticks it does a job of some
+ * WORK loop iterations, well within its BUDGET.  Run next to rt_hog,
+ * which computes without ever blocking, its jobs still meet their
+ * deadlines; "-stats" counts the jobs and misses (see rt.sh).
+ */
+
+#include "syscall.h"
+
+#define PERIOD	2000
+#define BUDGET	500
+#define JOBS	20
+#define WORK	40
+
+int sum;
+
+int
+main()
+{
+	int i, j;
+
+	if (RealTime(PERIOD, BUDGET, PERIOD) < 0) {
+		MSG("rt_task: not admitted");
+		Exit(1);
+	}
+	for (i = 0; i < JOBS; i++) {
+		for (j = 0; j < WORK; j++)
+			sum += j;
+		NextPeriod();
+	}
+	Exit(0);
+}
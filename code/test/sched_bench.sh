@@ -0,0 +1,41 @@
+# Run the same seeded workload of kernel threads (see threads/workload.h)
+# under each scheduling policy, and print how each served it, as CSV:
+# throughput in jobs per 1000 ticks, mean and p99 response time in
+# ticks, context switches, and Jain's fairness index.  Give a workload
+# to change the default one, and keep the output of a known good kernel
+# to compare a scheduler change against:
+#
+#	./sched_bench.sh > before.csv
+#	./sched_bench.sh seed=7,jobs=100,io=20 > heavy.csv
+
+NACHOS=../build.linux/nachos
+WORKLOAD=${1:-seed=1}
+
+# name, flags
+POLICIES="
+rr -
+fcfs -fcfs
+random -rs_1
+smp2 -smp_2
+smp4 -smp_4
+"
+
+echo "policy,jobs,ticks,throughput,mean_response,p99_response,switches,fairness"
+echo "$POLICIES" | while read name flags
+do
+    if [ -z "$name" ]
+    then
+        continue
+    fi
+    if [ "$flags" = "-" ]
+    then
+        flags=""
+    fi
+    $NACHOS $NACHOS_FLAGS $(echo $flags | tr _ ' ') -wl $WORKLOAD | \
+        awk -v name=$name '
+        /^Workload:/ {
+            gsub(",", "")
+            printf "%s,%d,%d,%s,%s,%d,%d,%s\n", name, $3, $5, $7, $10,
+                $12, $14, $16
+        }'
+done
@@ -0,0 +1,6 @@
+# The producer and the consumer run side by side, time sliced, and
+# share one segment of memory; the consumer reports the result.
+../build.linux/nachos -f
+../build.linux/nachos -cp shm_producer /shm_producer
+../build.linux/nachos -cp shm_consumer /shm_consumer
+../build.linux/nachos -e /shm_producer -e /shm_consumer
@@ -0,0 +1,36 @@
+#include "syscall.h"
+
+/* See shm_producer.c.  The consumer reads the producer's data in place,
+ * without a copy through the kernel, and maps the segment a second time
+ * by key to check that ShmCreate finds the existing segment.
+ */
+#define SHM_KEY		7
+#define SHM_ADDR	0x10000
+#define SHM_SIZE	1024
+
+struct shared {
+	volatile int ready;
+	volatile int done;
+	char data[SHM_SIZE - 8];
+};
+
+int main(void)
+{
+	struct shared *s = (struct shared *) SHM_ADDR;
+	int id, i;
+
+	id = ShmCreate(SHM_KEY, SHM_SIZE);
+	if (id < 0) MSG("Failed on finding the segment");
+	if (ShmAttach(id, (char *) SHM_ADDR) != 1) MSG("Failed on attaching the segment");
+	if (ShmAttach(id, (char *) SHM_ADDR) == 1) MSG("Failed: attached the segment twice");
+	while (!s->ready)
+		;
+	for (i = 0; i < sizeof(s->data); ++i) {
+		if (s->data[i] != 'a' + i % 26) MSG("Failed: reading wrong result");
+	}
+	s->done = 1;
+	if (ShmDetach(id) != 1) MSG("Failed on detaching the segment");
+	if (ShmDetach(id) == 1) MSG("Failed: detached the segment twice");
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,32 @@
+#include "syscall.h"
+
+/* Shared with shm_reclaim: both attach the small control segment
+ * CTL_KEY at CTL_ADDR.  When shm_reclaim has attached it too, the
+ * orphan creates segment ORPHAN_KEY, half of physical memory, never
+ * attaches it, and exits; Nachos must free it then, or shm_reclaim
+ * cannot get memory of its own.
+ */
+#define CTL_KEY		8
+#define CTL_ADDR	0x10000
+#define ORPHAN_KEY	9
+#define ORPHAN_SIZE	(64 * 128)
+
+struct control {
+	volatile int attached;
+	volatile int created;
+};
+
+int main(void)
+{
+	struct control *c = (struct control *) CTL_ADDR;
+	int id;
+
+	id = ShmCreate(CTL_KEY, 128);
+	if (id < 0) MSG("Failed on creating the control segment");
+	if (ShmAttach(id, (char *) CTL_ADDR) != 1) MSG("Failed on attaching the control segment");
+	while (!c->attached)
+		;
+	if (ShmCreate(ORPHAN_KEY, ORPHAN_SIZE) < 0) MSG("Failed on creating the segment");
+	c->created = 1;
+	Exit(0);
+}
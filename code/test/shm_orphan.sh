@@ -0,0 +1,7 @@
+# The orphan creates a segment, never attaches it, and exits while
+# shm_reclaim runs beside it; shm_reclaim reports whether the memory
+# came back.
+../build.linux/nachos -f
+../build.linux/nachos -cp shm_orphan /shm_orphan
+../build.linux/nachos -cp shm_reclaim /shm_reclaim
+../build.linux/nachos -e /shm_orphan -e /shm_reclaim
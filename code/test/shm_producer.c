@@ -0,0 +1,33 @@
+#include "syscall.h"
+
+/* Shared with shm_consumer: both attach segment SHM_KEY at SHM_ADDR,
+ * well above either program.  The producer fills the buffer, then
+ * raises "ready"; the consumer checks it and raises "done", so the
+ * producer stays attached until the consumer has seen the data.
+ */
+#define SHM_KEY		7
+#define SHM_ADDR	0x10000
+#define SHM_SIZE	1024
+
+struct shared {
+	volatile int ready;
+	volatile int done;
+	char data[SHM_SIZE - 8];
+};
+
+int main(void)
+{
+	struct shared *s = (struct shared *) SHM_ADDR;
+	int id, i;
+
+	id = ShmCreate(SHM_KEY, SHM_SIZE);
+	if (id < 0) MSG("Failed on creating the segment");
+	if (ShmAttach(id, (char *) SHM_ADDR) != 1) MSG("Failed on attaching the segment");
+	for (i = 0; i < sizeof(s->data); ++i)
+		s->data[i] = 'a' + i % 26;
+	s->ready = 1;
+	while (!s->done)
+		;
+	if (ShmDetach(id) != 1) MSG("Failed on detaching the segment");
+	Exit(0);
+}
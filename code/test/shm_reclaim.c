@@ -0,0 +1,37 @@
+#include "syscall.h"
+
+/* See shm_orphan.c.  Once the orphan has created its segment, keep
+ * asking for a new one of the same size; that only fits in memory
+ * after the orphan has exited and its unattached segment is freed.
+ */
+#define CTL_KEY		8
+#define CTL_ADDR	0x10000
+#define NEW_KEY		10
+#define NEW_SIZE	(64 * 128)
+#define TRIES		100000
+
+struct control {
+	volatile int attached;
+	volatile int created;
+};
+
+int main(void)
+{
+	struct control *c = (struct control *) CTL_ADDR;
+	int id, i;
+
+	id = ShmCreate(CTL_KEY, 128);
+	if (id < 0) MSG("Failed on finding the control segment");
+	if (ShmAttach(id, (char *) CTL_ADDR) != 1) MSG("Failed on attaching the control segment");
+	c->attached = 1;
+	while (!c->created)
+		;
+	for (i = 0; i < TRIES; ++i) {
+		if (ShmCreate(NEW_KEY, NEW_SIZE) >= 0)
+			break;
+	}
+	if (i == TRIES) MSG("Failed: the orphaned segment was never freed");
+	if (ShmDetach(id) != 1) MSG("Failed on detaching the control segment");
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,43 @@
+/* Grow the stack past the 8KB it used to be limited to, and move the
+ * break down and up again: the stack must get its pages as it grows,
+ * and the heap must come back zeroed.  Run with "-stats" (see
+ * malloc.sh) to see the page faults.
+ */
+
+#include "syscall.h"
+
+#define DEPTH		20
+#define FRAME_SIZE	512
+
+int Recurse(int depth)
+{
+	char frame[FRAME_SIZE];
+	int i, sum;
+
+	for (i = 0; i < FRAME_SIZE; i++)
+		frame[i] = depth;
+	sum = (depth > 0) ? Recurse(depth - 1) : 0;
+	for (i = 0; i < FRAME_SIZE; i++) {
+		if (frame[i] != (char) depth) MSG("Failed: stack frame overwritten");
+	}
+	return sum + depth;
+}
+
+int main(void)
+{
+	char *start;
+	int i;
+
+	if (Recurse(DEPTH) != DEPTH * (DEPTH + 1) / 2) MSG("Failed on the deep stack");
+
+	start = Sbrk(100);
+	for (i = 0; i < 100; i++)
+		start[i] = 1;
+	Sbrk(-60);
+	Sbrk(60);
+	for (i = 40; i < 100; i++) {
+		if (start[i] != 0) MSG("Failed: heap not zeroed after shrinking");
+	}
+	MSG("Passed! ^_^");
+	Halt();
+}
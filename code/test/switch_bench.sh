@@ -0,0 +1,6 @@
+# Context switch cost.  "regs" and "tables" are the user register sets
+# and page tables loaded per switch: a user program's state stays in
+# its CPU while only kernel threads run in between, and threads of one
+# address space share the page table.
+../build.linux/nachos -cs 20000
+../build.linux/nachos -smp 2 -cs 20000
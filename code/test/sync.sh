@@ -0,0 +1,8 @@
+# The producer and the consumer share a bounded buffer in a segment of
+# memory, and block on futexes when it is full or empty.  With "-stats",
+# the system call count shows that only the waits trapped: far fewer
+# calls than the 4 lock operations per item.
+../build.linux/nachos -f
+../build.linux/nachos -cp sync_producer /sync_producer
+../build.linux/nachos -cp sync_consumer /sync_consumer
+../build.linux/nachos -stats -e /sync_producer -e /sync_consumer
@@ -0,0 +1,31 @@
+/* sync_buffer.h
+ *	A bounded buffer in a shared memory segment, for sync_producer and
+ *	sync_consumer.  The segment starts out zero, which is an empty
+ *	buffer with its mutex free (see usync.h).
+ */
+
+#include "usync.h"
+
+#define SHM_KEY		11
+#define SHM_ADDR	0x10000
+#define SLOTS		8
+#define ITEMS		2000
+
+struct buffer {
+	Mutex lock;
+	Condition notEmpty;
+	Condition notFull;
+	Barrier done;
+	int head;
+	int count;
+	int slots[SLOTS];
+};
+
+static struct buffer *AttachBuffer(void)
+{
+	int id = ShmCreate(SHM_KEY, sizeof(struct buffer));
+
+	if (id < 0 || ShmAttach(id, (char *) SHM_ADDR) != 1)
+		MSG("Failed on attaching the segment");
+	return (struct buffer *) SHM_ADDR;
+}
@@ -0,0 +1,27 @@
+/* Takes ITEMS numbers out of the bounded buffer it shares with
+ * sync_producer, checking they come in order, then meets the
+ * producer at a barrier and reports.
+ */
+
+#include "sync_buffer.h"
+
+int main(void)
+{
+	struct buffer *b = AttachBuffer();
+	int i, item;
+
+	for (i = 1; i <= ITEMS; i++) {
+		MutexLock(&b->lock);
+		while (b->count == 0)
+			ConditionWait(&b->notEmpty, &b->lock);
+		item = b->slots[b->head];
+		b->head = (b->head + 1) % SLOTS;
+		b->count--;
+		ConditionSignal(&b->notFull);
+		MutexUnlock(&b->lock);
+		if (item != i) MSG("Failed: reading wrong result");
+	}
+	BarrierWait(&b->done, 2);
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,24 @@
+/* Puts ITEMS numbers into the bounded buffer it shares with
+ * sync_consumer, sleeping on a condition variable while the buffer is
+ * full, then meets the consumer at a barrier.
+ */
+
+#include "sync_buffer.h"
+
+int main(void)
+{
+	struct buffer *b = AttachBuffer();
+	int i;
+
+	for (i = 1; i <= ITEMS; i++) {
+		MutexLock(&b->lock);
+		while (b->count == SLOTS)
+			ConditionWait(&b->notFull, &b->lock);
+		b->slots[(b->head + b->count) % SLOTS] = i;
+		b->count++;
+		ConditionSignal(&b->notEmpty);
+		MutexUnlock(&b->lock);
+	}
+	BarrierWait(&b->done, 2);
+	Exit(0);
+}
@@ -0,0 +1,105 @@
+/* umalloc.c
+ *	Size-class memory allocator for Nachos programs.  See umalloc.h.
+ */
+
+#include "umalloc.h"
+
+#define NULL		((void *) 0)
+#define MIN_SHIFT	4		/* smallest class: 16 bytes */
+#define NUM_CLASSES	8		/* ... up to 2048 */
+#define RUN_SIZE	1024		/* heap taken at a time for small blocks */
+#define HEADER		8		/* keeps blocks 8-byte aligned */
+
+/* Every block starts with a header; the caller gets what follows it.
+ * "size" is the usable size, which tells which list the block goes
+ * back to; "next" links it into that list while it is free.
+ */
+typedef struct header {
+	int size;
+	struct header *next;
+} Header;
+
+static Header *freeLists[NUM_CLASSES];
+static char *runNext[NUM_CLASSES];	/* where the next new block goes */
+static int runLeft[NUM_CLASSES];	/* bytes left in the run */
+static Header *bigFree;			/* free blocks over 2048 bytes */
+
+static int ClassOf(int size)
+{
+	int class = 0;
+
+	while ((1 << (class + MIN_SHIFT)) < size)
+		class++;
+	return class;
+}
+
+/* Cut a new block of class "class" from its run of heap, taking a new
+ * run when it is used up.
+ */
+static Header *NewBlock(int class)
+{
+	int size = 1 << (class + MIN_SHIFT);
+	int run = (RUN_SIZE > size + HEADER) ? RUN_SIZE : size + HEADER;
+	Header *h;
+
+	if (runLeft[class] < size + HEADER) {
+		runNext[class] = (char *) Sbrk(run);
+		if (runNext[class] == (char *) -1) {
+			runLeft[class] = 0;
+			return NULL;
+		}
+		runLeft[class] = run;
+	}
+	h = (Header *) runNext[class];
+	h->size = size;
+	runNext[class] += size + HEADER;
+	runLeft[class] -= size + HEADER;
+	return h;
+}
+
+void *Malloc(int size)
+{
+	Header *h, **p;
+	int class;
+
+	if (size <= 0)
+		return NULL;
+	if (size <= (1 << (MIN_SHIFT + NUM_CLASSES - 1))) {
+		class = ClassOf(size);
+		if ((h = freeLists[class]) != NULL)
+			freeLists[class] = h->next;
+		else if ((h = NewBlock(class)) == NULL)
+			return NULL;
+		return (char *) h + HEADER;
+	}
+
+	size = (size + HEADER - 1) & ~(HEADER - 1);
+	for (p = &bigFree; *p != NULL; p = &(*p)->next) {
+		if ((*p)->size >= size) {
+			h = *p;
+			*p = h->next;
+			return (char *) h + HEADER;
+		}
+	}
+	h = (Header *) Sbrk(size + HEADER);
+	if (h == (Header *) -1)
+		return NULL;
+	h->size = size;
+	return (char *) h + HEADER;
+}
+
+void Free(void *block)
+{
+	Header *h;
+
+	if (block == NULL)
+		return;
+	h = (Header *) ((char *) block - HEADER);
+	if (h->size <= (1 << (MIN_SHIFT + NUM_CLASSES - 1))) {
+		h->next = freeLists[ClassOf(h->size)];
+		freeLists[ClassOf(h->size)] = h;
+	} else {
+		h->next = bigFree;
+		bigFree = h;
+	}
+}
@@ -0,0 +1,23 @@
+/* umalloc.h
+ *	A memory allocator for Nachos programs, on top of Sbrk.
+ *
+ *	Small requests are rounded up to a power of two, from 16 to 2048
+ *	bytes, and served from a free list per size; when a list is empty,
+ *	the next block is cut from a run of heap kept for that size, so
+ *	that only blocks in use are ever touched.  Larger requests get a
+ *	block of their own from the heap, and are reused, first fit, once
+ *	freed.  Memory is never given back to the kernel.
+ *
+ *	Heap pages read as zero until reused, but Malloc does not clear
+ *	what it returns.
+ */
+
+#ifndef UMALLOC_H
+#define UMALLOC_H
+
+#include "syscall.h"
+
+void *Malloc(int size);		/* NULL if the heap cannot grow */
+void Free(void *block);
+
+#endif /* UMALLOC_H */
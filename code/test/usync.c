@@ -0,0 +1,94 @@
+/* usync.c
+ *	User-level mutexes, condition variables and barriers, built on
+ *	atomic operations and futexes.  See usync.h.
+ */
+
+#include "usync.h"
+
+#define WAKE_ALL 0x7fffffff
+
+static int AtomicSwap(volatile int *addr, int new)
+{
+	int old;
+
+	do {
+		old = *addr;
+	} while (AtomicCompareSwap(addr, old, new) != old);
+	return old;
+}
+
+/* The state goes from 0 to 1 when a thread takes a free mutex, without
+ * a trap.  A thread that finds it taken sets it to 2, to tell the owner
+ * someone sleeps, and waits; so only an unlock from 2 has to call
+ * FutexWake.
+ */
+void MutexLock(Mutex *m)
+{
+	int c;
+
+	if ((c = AtomicCompareSwap(&m->state, 0, 1)) == 0)
+		return;
+	if (c != 2)
+		c = AtomicSwap(&m->state, 2);
+	while (c != 0) {
+		FutexWait((int *) &m->state, 2);
+		c = AtomicSwap(&m->state, 2);
+	}
+}
+
+void MutexUnlock(Mutex *m)
+{
+	if (AtomicAdd(&m->state, -1) != 1) {
+		m->state = 0;
+		FutexWake((int *) &m->state, 1);
+	}
+}
+
+/* A waiter sleeps only if no signal has come since it read the
+ * sequence number, so none is lost between unlocking and sleeping.
+ * The count of waiters, kept under the mutex, lets a signal with no
+ * one to wake skip the trap.
+ */
+void ConditionWait(Condition *c, Mutex *m)
+{
+	int sequence = c->sequence;
+
+	c->waiters++;
+	MutexUnlock(m);
+	FutexWait((int *) &c->sequence, sequence);
+	MutexLock(m);
+	c->waiters--;
+}
+
+void ConditionSignal(Condition *c)
+{
+	AtomicAdd(&c->sequence, 1);
+	if (c->waiters > 0)
+		FutexWake((int *) &c->sequence, 1);
+}
+
+void ConditionBroadcast(Condition *c)
+{
+	AtomicAdd(&c->sequence, 1);
+	if (c->waiters > 0)
+		FutexWake((int *) &c->sequence, WAKE_ALL);
+}
+
+int BarrierWait(Barrier *b, int parties)
+{
+	int round;
+
+	MutexLock(&b->lock);
+	round = b->round;
+	if (++b->arrived == parties) {
+		b->arrived = 0;
+		AtomicAdd(&b->round, 1);
+		MutexUnlock(&b->lock);
+		FutexWake((int *) &b->round, WAKE_ALL);
+		return 1;
+	}
+	MutexUnlock(&b->lock);
+	while (b->round == round)
+		FutexWait((int *) &b->round, round);
+	return 0;
+}
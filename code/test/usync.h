@@ -0,0 +1,56 @@
+/* usync.h
+ *	User-level synchronization for Nachos programs: mutexes,
+ *	condition variables and barriers.
+ *
+ *	They work between the threads of any programs that share the
+ *	memory they are in (see ShmAttach).  The fast paths are atomic
+ *	operations in user mode, so locking a free mutex, or signalling
+ *	a condition no one waits on, never traps; only a thread that has
+ *	to wait calls the kernel (FutexWait), and sleeps there instead
+ *	of spinning.
+ *
+ *	Memory that is all zero holds an unlocked mutex, a condition no
+ *	one waits on, and a barrier no one has reached, so the objects
+ *	need no initialization in a fresh shared memory segment.
+ */
+
+#ifndef USYNC_H
+#define USYNC_H
+
+#include "syscall.h"
+
+/* in start.S; both return the old value of *addr */
+int AtomicCompareSwap(volatile int *addr, int old, int new);
+int AtomicAdd(volatile int *addr, int n);
+
+typedef struct {
+	volatile int state;	/* 0 free, 1 locked, 2 locked with waiters */
+} Mutex;
+
+typedef struct {
+	volatile int sequence;	/* bumped by every signal */
+	volatile int waiters;	/* threads in ConditionWait */
+} Condition;
+
+typedef struct {
+	Mutex lock;
+	volatile int arrived;	/* threads waiting for this round */
+	volatile int round;	/* rounds completed */
+} Barrier;
+
+void MutexLock(Mutex *m);
+void MutexUnlock(Mutex *m);
+
+/* As with Nachos' own condition variables, signal and broadcast with
+ * the mutex held.
+ */
+void ConditionWait(Condition *c, Mutex *m);
+void ConditionSignal(Condition *c);
+void ConditionBroadcast(Condition *c);
+
+/* Wait until "parties" threads have reached the barrier; return 1 in
+ * the last one to arrive, 0 in the others.
+ */
+int BarrierWait(Barrier *b, int parties);
+
+#endif /* USYNC_H */
@@ -18,10 +18,14 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to
 //		occur at random, instead of fixed, intervals.
+//	"timeSlice" -- if false, let threads run until they block
+//		(first come, first served), except to enforce the
+//		budget of real-time threads
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool timeSlice)
 {
+    slicing = timeSlice;
     timer = new Timer(doRandom, this);
 }
 
@@ -41,6 +45,8 @@ Alarm::Alarm(bool doRandom)
 //
 //	For now, just provide time-slicing.  Only need to time slice
 //      if we're currently running something (in other words, not idle).
+//	The Yield also enforces the budget of a real-time thread: it
+//	keeps the CPU only while it has budget left (Scheduler::ShouldYield).
 //----------------------------------------------------------------------
 
 void
@@ -49,7 +55,8 @@ Alarm::CallBack()
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
 
-    if (status != IdleMode)
+    if ((status != IdleMode) &&
+            (slicing || (kernel->currentThread->realTime != NULL)))
         {
             interrupt->YieldOnReturn();
         }
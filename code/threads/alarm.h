@@ -26,7 +26,8 @@
 class Alarm : public CallBackObj
 {
 public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback
+    Alarm(bool doRandomYield, bool timeSlice);
+    // Initialize the timer, and callback
     // to "toCall" every time slice.
     ~Alarm()
     {
@@ -43,6 +44,7 @@ public:
 
 private:
     Timer *timer;		// the hardware timer device
+    bool slicing;		// preempt threads at each interrupt
 
     void CallBack();		// called when the hardware
     // timer generates an interrupt
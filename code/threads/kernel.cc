@@ -15,8 +15,16 @@
 #include "libtest.h"
 #include "string.h"
 #include "synchdisk.h"
+#include "buffercache.h"
 #include "post.h"
 #include "synchconsole.h"
+#include "hostnet.h"
+#include "disktrace.h"
+#include "frametable.h"
+#include "shm.h"
+#include "futex.h"
+#include "workqueue.h"
+#include <sys/time.h>
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -27,15 +35,31 @@
 Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE;
+    timeSlice = TRUE;
     debugUserProg = FALSE;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
+    numTmpfs = 0;               // everything on the disk
 #endif
     reliability = 1;            // network reliability, default is 1.0
     hostName = 0;               // machine id, also UNIX socket name
     // 0 is the default machine id
+    numCpus = 1;                // uniprocessor unless -smp is given
+    numDisks = 1;               // a single DISK_<hostName> by default
+    mirrorDisks = FALSE;
+    diskProfile = NULL;         // classic rotational disk
+    diskQueueDepth = 1;         // one request at a time
+    diskTraceFile = NULL;       // no disk trace
+    hostIO = FALSE;             // disk files accessed inline
+    groupPlacement = FALSE;     // first free sector
+    logStructured = FALSE;      // write sectors in place
+    cacheSectors = 0;           // no buffer cache
+    warmCache = FALSE;          // no DISK_<hostName>.warm
+    diskStats = FALSE;
+    printStats = FALSE;
+    mountTicks = 0;
 
     // MP4 mod tag
     execfileNum = 0; // dummy operation to keep valgrind happy
@@ -50,6 +74,10 @@ Kernel::Kernel(int argc, char **argv)
                     randomSlice = TRUE;
                     i++;
                 }
+            else if (strcmp(argv[i], "-fcfs") == 0)
+                {
+                    timeSlice = FALSE;
+                }
             else if (strcmp(argv[i], "-s") == 0)
                 {
                     debugUserProg = TRUE;
@@ -75,6 +103,13 @@ Kernel::Kernel(int argc, char **argv)
             else if (strcmp(argv[i], "-f") == 0)
                 {
                     formatFlag = TRUE;
+                }
+            else if (strcmp(argv[i], "-tmpfs") == 0)
+                {
+                    ASSERT(i + 1 < argc);
+                    ASSERT(numTmpfs < MaxMounts);
+                    tmpfsPaths[numTmpfs++] = argv[i + 1];
+                    i++;
 #endif
                 }
             else if (strcmp(argv[i], "-n") == 0)
@@ -89,17 +124,110 @@ Kernel::Kernel(int argc, char **argv)
                     hostName = atoi(argv[i + 1]);
                     i++;
                 }
+            else if (strcmp(argv[i], "-ps") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    PageSize = atoi(argv[i + 1]);
+                    ASSERT((PageSize >= 4) && ((PageSize & (PageSize - 1)) == 0));
+                    i++;
+                }
+            else if (strcmp(argv[i], "-pages") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    NumPhysPages = atoi(argv[i + 1]);
+                    ASSERT(NumPhysPages > 0);
+                    i++;
+                }
+            else if (strcmp(argv[i], "-disks") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    numDisks = atoi(argv[i + 1]);
+                    ASSERT((numDisks >= 1) && (numDisks <= MaxDisks));
+                    i++;
+                }
+            else if (strcmp(argv[i], "-mirror") == 0)
+                {
+                    mirrorDisks = TRUE;
+                }
+            else if (strcmp(argv[i], "-ncq") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    diskQueueDepth = atoi(argv[i + 1]);
+                    ASSERT((diskQueueDepth >= 1) && (diskQueueDepth <= MaxQueueDepth));
+                    i++;
+                }
+            else if (strcmp(argv[i], "-hio") == 0)
+                {
+                    hostIO = TRUE;
+                }
+            else if (strcmp(argv[i], "-lfs") == 0)
+                {
+                    logStructured = TRUE;
+                }
+            else if (strcmp(argv[i], "-ag") == 0)
+                {
+                    groupPlacement = TRUE;
+                }
+            else if (strcmp(argv[i], "-bc") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    cacheSectors = atoi(argv[i + 1]);
+                    ASSERT(cacheSectors >= 0);
+                    i++;
+                }
+            else if (strcmp(argv[i], "-warm") == 0)
+                {
+                    warmCache = TRUE;
+                }
+            else if (strcmp(argv[i], "-ds") == 0)
+                {
+                    diskStats = TRUE;
+                }
+            else if (strcmp(argv[i], "-stats") == 0)
+                {
+                    printStats = TRUE;
+                }
+            else if (strcmp(argv[i], "-dt") == 0)
+                {
+                    ASSERT(i + 1 < argc);
+                    diskTraceFile = argv[i + 1];
+                    i++;
+                }
+            else if (strcmp(argv[i], "-dp") == 0)
+                {
+                    ASSERT(i + 1 < argc);
+                    diskProfile = argv[i + 1];
+                    i++;
+                }
+            else if (strcmp(argv[i], "-smp") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    numCpus = atoi(argv[i + 1]);
+                    ASSERT((numCpus >= 1) && (numCpus <= MaxCpus));
+                    i++;
+                }
             else if (strcmp(argv[i], "-u") == 0)
                 {
-                    cout << "Partial usage: nachos [-rs randomSeed]\n";
+                    cout << "Partial usage: nachos [-rs randomSeed] [-fcfs]\n";
                     cout << "Partial usage: nachos [-s]\n";
                     cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
-                    cout << "Partial usage: nachos [-nf]\n";
+                    cout << "Partial usage: nachos [-nf] [-ag] [-lfs]\n";
+                    cout << "Partial usage: nachos [-tmpfs path]\n";
 #endif
                     cout << "Partial usage: nachos [-n #] [-m #]\n";
+                    cout << "Partial usage: nachos [-smp #]\n";
+                    cout << "Partial usage: nachos [-ps pageSize] [-pages #]\n";
+                    cout << "Partial usage: nachos [-disks #] [-mirror] [-dp diskProfile]\n";
+                    cout << "Partial usage: nachos [-ncq queueDepth] [-dt traceFile] [-hio]\n";
+                    cout << "Partial usage: nachos [-bc cacheSectors] [-warm] [-ds]\n";
+                    cout << "Partial usage: nachos [-stats]\n";
                 }
         }
+    if (warmCache && cacheSectors == 0)	// warming up needs a cache
+        {
+            cacheSectors = DefaultCacheSectors;
+        }
 }
 
 //----------------------------------------------------------------------
@@ -119,26 +247,58 @@ Kernel::Initialize()
 
     currentThread = new Thread("main", threadNum++);
     currentThread->setStatus(RUNNING);
+    currentThread->setCpu(0);
 
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
-    scheduler = new Scheduler();	// initialize the ready queue
-    alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
+    scheduler = new Scheduler(numCpus);	// initialize the ready queues
+    alarm = new Alarm(randomSlice, timeSlice); // start up time slicing
+    workQueue = new WorkQueue();	// start the interrupt bottom halves
+    machine = new Machine(debugUserProg, numCpus);
+    frameTable = new FrameTable(NumPhysPages);
+    sharedMemory = new SharedMemory();
+    futexTable = new FutexTable();
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
-    synchDisk = new SynchDisk();    //
+    diskTrace = NULL;
+    if (diskTraceFile != NULL)
+        {
+            diskTrace = new DiskTrace(diskTraceFile, numDisks);
+        }
+    synchDisk = new SynchDisk(numDisks, mirrorDisks, diskQueueDepth,
+                              cacheSectors);
+    mountTicks = stats->totalTicks;
+#ifndef FILESYS_STUB
+    // A disk formatted with -lfs is found again without it; formatting
+    // without -lfs lays the file system directly on the disk.
+    if (!formatFlag || logStructured)
+        {
+            synchDisk->MountLog(formatFlag);
+        }
+    if (!formatFlag && warmCache)
+        {
+            synchDisk->Warmup();
+        }
+#endif // FILESYS_STUB
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
     fileSystem = new FileSystem(formatFlag);
+    for (int i = 0; i < numTmpfs; i++)
+        fileSystem->Mount(tmpfsPaths[i]);
 #endif // FILESYS_STUB
+    mountTicks = stats->totalTicks - mountTicks;
 
     // MP4 mod tag
-    /*
-    postOfficeIn = new PostOfficeInput(10);
-    postOfficeOut = new PostOfficeOutput(reliability);
-    */
+    // The socket network is off; the in-process one of "-hosts N"
+    // needs no sockets, so it is still available.
+    postOfficeIn = NULL;
+    postOfficeOut = NULL;
+    if (hostNet != NULL)  	// the in-process network needs no sockets
+        {
+            postOfficeIn = new PostOfficeInput(10);
+            postOfficeOut = new PostOfficeOutput(reliability);
+        }
 
     interrupt->Enable();
 }
@@ -164,22 +324,55 @@ Kernel::PrepareToEnd()
 
 Kernel::~Kernel()
 {
+    if (numCpus > 1)
+        {
+            scheduler->PrintCpuStats();
+        }
+    if (numCpus > 1 || numDisks > 1 || diskQueueDepth > 1 || logStructured
+            || diskStats)
+        {
+            synchDisk->PrintStats();
+            workQueue->PrintStats();
+        }
+    if (diskStats)
+        {
+            cout << "Mount: " << mountTicks << " ticks\n";
+        }
+    if (printStats)
+        {
+            stats->Print();
+        }
+#ifndef FILESYS_STUB
+    if (warmCache && !formatFlag)	// a fresh disk has nothing to keep
+        {
+            synchDisk->SaveWarmup();
+        }
+#endif // FILESYS_STUB
+
     delete stats;
     delete interrupt;
     delete scheduler;
     delete alarm;
+    delete futexTable;
+    delete sharedMemory;
+    delete frameTable;
     delete machine;
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
+    delete diskTrace;
     delete fileSystem;
 
     // Mp4 mod tag
-    /*
     delete postOfficeIn;
     delete postOfficeOut;
-    */
+    delete workQueue;
 
+    if (hostNet != NULL)  	// the other machines carry on
+        {
+            hostNet->Finish(hostName);
+            ExitHostThread();
+        }
     Exit(0);
 }
 
@@ -298,6 +491,95 @@ Kernel::NetworkTest()
     // Then we're done!
 }
 
+//----------------------------------------------------------------------
+// SwitchBenchThread
+// 	One of the two threads of a context switch benchmark: yield to
+//	the other one "rounds" times.
+//----------------------------------------------------------------------
+
+class SwitchBench
+{
+public:
+    int rounds;				// yields each thread makes
+    Semaphore *done;			// V'ed as each thread finishes
+};
+
+static void
+SwitchBenchThread(void *data)
+{
+    SwitchBench *bench = (SwitchBench *) data;
+
+    for (int i = 0; i < bench->rounds; i++)
+        kernel->currentThread->Yield();
+    kernel->currentThread->space = NULL;	// it may be shared; the
+    // benchmark deletes it
+    bench->done->V();
+}
+
+//----------------------------------------------------------------------
+// Kernel::SwitchBenchmark
+//      Time about "numSwitches" switches between two threads that do
+//	nothing but yield to each other, for each kind of thread pair:
+//	two kernel threads, two threads of one address space, threads of
+//	different address spaces, and a user program with a kernel
+//	thread.  The user programs never run user code; they only have
+//	user state for Scheduler::Run to switch.  Print the host time
+//	and simulated ticks per switch, and how many register sets and
+//	page tables were loaded per switch.
+//----------------------------------------------------------------------
+
+void
+Kernel::SwitchBenchmark(int numSwitches)
+{
+    static char *names[] = { "kernel", "same space", "other space",
+                             "user/kernel"
+                           };
+    SwitchBench bench;
+    AddrSpace *one = new AddrSpace();
+    AddrSpace *other = new AddrSpace();
+    AddrSpace *spaces[4][2] = { { NULL, NULL }, { one, one },
+                                { one, other }, { one, NULL } };
+    struct timeval start, end;
+    int ticks, switches, userLoads, tableLoads;
+    double nanos;
+
+    bench.rounds = numSwitches / 2;
+    bench.done = new Semaphore("switch bench", 0);
+    printf("Context switches: %d per case\n", numSwitches);
+    printf("%-12s %10s %8s %8s %8s\n", "case", "ns/switch", "ticks",
+           "regs", "tables");
+    for (int i = 0; i < 4; i++)
+        {
+            Thread *first = new Thread("switch bench", -1);
+            Thread *second = new Thread("switch bench", -1);
+
+            first->space = spaces[i][0];
+            second->space = spaces[i][1];
+            ticks = stats->totalTicks;
+            switches = stats->numContextSwitches;
+            userLoads = stats->numUserLoads;
+            tableLoads = stats->numPageTableLoads;
+            gettimeofday(&start, NULL);
+            first->Fork(SwitchBenchThread, (void *) &bench);
+            second->Fork(SwitchBenchThread, (void *) &bench);
+            bench.done->P();
+            bench.done->P();
+            gettimeofday(&end, NULL);
+
+            switches = max(1, stats->numContextSwitches - switches);
+            nanos = (end.tv_sec - start.tv_sec) * 1e9 +
+                    (end.tv_usec - start.tv_usec) * 1e3;
+            printf("%-12s %10.1f %8.1f %8.2f %8.2f\n", names[i],
+                   nanos / switches,
+                   (double) (stats->totalTicks - ticks) / switches,
+                   (double) (stats->numUserLoads - userLoads) / switches,
+                   (double) (stats->numPageTableLoads - tableLoads) / switches);
+        }
+    delete bench.done;
+    delete one;
+    delete other;
+}
+
 void ForkExecute(Thread *t)
 {
     if ( !t->space->Load(t->getName()) )
@@ -382,5 +664,25 @@ int Kernel::KClose(OpenFileId id)
     return fileSystem->Close(id);
 }
 
+int Kernel::KClone(char *from, char *to)
+{
+    return fileSystem->Clone(from, to);
+}
+
+int Kernel::KRemove(char *filename)
+{
+    return fileSystem->Remove(filename, FALSE);
+}
+
+int Kernel::KSeek(int position, OpenFileId id)
+{
+    return fileSystem->Seek(position, id);
+}
+
+int Kernel::KPipe(OpenFileId *readId, OpenFileId *writeId)
+{
+    return fileSystem->OpenPipe(readId, writeId);
+}
+
 #endif
 
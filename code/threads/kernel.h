@@ -24,6 +24,11 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class DiskTrace;
+class FrameTable;
+class SharedMemory;
+class FutexTable;
+class WorkQueue;
 
 
 
@@ -47,6 +52,8 @@ public:
 
     void ConsoleTest();         // interactive console self test
     void NetworkTest();         // interactive 2-machine network test
+    void SwitchBenchmark(int numSwitches);
+    // time context switches
     Thread* getThread(int threadID)
     {
         return t[threadID];
@@ -58,6 +65,10 @@ public:
     int KRead(char *buf, int size, OpenFileId id);
     int KWrite(char *buf, int size, OpenFileId id);
     int KClose(OpenFileId id);
+    int KClone(char *from, char *to);
+    int KRemove(char *filename);
+    int KSeek(int position, OpenFileId id);
+    int KPipe(OpenFileId *readId, OpenFileId *writeId);
 #endif
 
 // These are public for notational convenience; really,
@@ -68,15 +79,37 @@ public:
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock
+    WorkQueue *workQueue;	// deferred work of interrupt handlers
     Machine *machine;           // the simulated CPU
+    FrameTable *frameTable;	// free frames of physical memory
+    SharedMemory *sharedMemory;	// shared memory segments
+    FutexTable *futexTable;	// threads waiting on words of user memory
     SynchConsoleInput *synchConsoleIn;
     SynchConsoleOutput *synchConsoleOut;
     SynchDisk *synchDisk;
+    DiskTrace *diskTrace;	// disk requests are logged here (-dt),
+    // if not NULL
     FileSystem *fileSystem;
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
 
     int hostName;               // machine identifier
+    int numCpus;                // number of simulated CPUs (-smp)
+    int numDisks;               // disks in the volume (-disks)
+    bool mirrorDisks;           // keep two copies of each sector (-mirror)
+    char *diskProfile;          // disk latency model profile (-dp)
+    int diskQueueDepth;         // requests queued in each disk (-ncq)
+    char *diskTraceFile;        // where to record disk requests (-dt)
+    bool hostIO;                // disk file accesses on a host worker
+    // thread (-hio)
+    bool groupPlacement;        // place files by allocation group (-ag)
+    bool logStructured;         // format the disk as a log (-lfs)
+    int cacheSectors;           // sectors in the buffer cache (-bc)
+    bool warmCache;             // fill the cache at mount with the
+    // sectors the last run used (-warm)
+    bool diskStats;             // print disk statistics at halt (-ds)
+    bool printStats;            // print the statistics at halt (-stats)
+    int mountTicks;             // how long mounting the disk took
 
 private:
 
@@ -85,12 +118,15 @@ private:
     int execfileNum;
     int threadNum;
     bool randomSlice;		// enable pseudo-random time slicing
+    bool timeSlice;		// time slicing at all, unless -fcfs
     bool debugUserProg;         // single step user program
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
+    char *tmpfsPaths[MaxMounts]; // where to mount a tmpfs (-tmpfs)
+    int numTmpfs;
 #endif
 };
 
@@ -5,12 +5,19 @@
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
+//              -clone <nachos file> <nachos file> -defrag
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -smp <number of CPUs> -hosts <number of machines>
+//              -ps <page size> -pages <number of physical pages>
+//              -disks <number of disks> -mirror -dp <disk profile>
+//              -ncq <disk queue depth> -dt <disk trace file> -ag -lfs
+//              -z -K -C -N -cs <number of switches> -wl <workload>
+//              -fcfs -hio
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -fcfs turns time slicing off: threads run until they block
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
@@ -18,17 +25,50 @@
 //    -co specify file for console output (stdout is the default)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
+//    -smp simulates that many CPUs, each with its own ready list,
+//       registers and TLB; per-CPU statistics, with the time each CPU
+//       spent spinning, and the disk lock's are printed at halt
+//    -ps sets the page size in bytes (a power of two, default 128)
+//    -pages sets the number of pages of physical memory (default 128)
+//    -disks builds the disk volume from that many disks, DISK_<id>_<i>,
+//       striped sector groups across them; format with -f after changing it
+//    -mirror pairs the disks up, each pair holding two copies of its data
+//    -dp reads the disk latency model, rotational or flash, and its
+//       parameters from a profile file (see machine/diskmodel.h)
+//    -ncq lets each disk hold that many requests and serve them in
+//       shortest-positioning-time order (native command queueing)
+//    -dt records every physical disk request in a trace file, to be
+//       replayed with the tracereplay tool (see machine/disktrace.h)
+//    -hio reads and writes the disk files on a host worker thread, so
+//       that host I/O overlaps the simulation; simulated times and
+//       results are unchanged (see machine/hostio.h)
+//    -hosts runs that many machines (ids 0 .. N-1) in this one process,
+//       each on its own host thread, connected by an in-memory network
+//       instead of UNIX sockets; the run is deterministic.  The
+//       machines share the rest of the command line, console included.
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -cs time that many context switches between each kind of thread
+//       pair (see Kernel::SwitchBenchmark)
+//    -wl runs a synthetic workload of kernel threads and prints how the
+//       scheduler served it; e.g. -wl seed=3,jobs=50 (see workload.h)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
 //    -cp copies a file from UNIX to Nachos
+//    -clone makes a copy of a Nachos file that shares its data sectors
+//       until one of the two is written
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
+//    -defrag makes every file contiguous and packs the files together,
+//       printing how fragmented they are before and after
+//    -ag keeps new files and directories near their directory (allocation
+//       groups), instead of putting them in the first free sectors
+//    -lfs with -f lays the disk out as a log of segments, cleaned in the
+//       background (see filesys/lfs.h); later runs find the log by themselves
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -45,10 +85,16 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "hostnet.h"
+#include "workload.h"
 
-// global variables
-Kernel *kernel;
-Debug *debug;
+// global variables, one set per host thread
+__thread Kernel *kernel;
+__thread Debug *debug;
+
+static __thread int hostIndex;	// machine id, when running "-hosts N"
+static int hostArgc;		// command line, shared by the host threads
+static char **hostArgv;
 
 
 //----------------------------------------------------------------------
@@ -60,6 +106,10 @@ static void
 Cleanup(int x)
 {
     cerr << "\nCleaning up after signal " << x << "\n";
+    if (hostNet != NULL)  	// several machines, not one to clean up
+        {
+            Exit(0);
+        }
     delete kernel;
 }
 
@@ -167,7 +217,7 @@ CreateDirectory(char *name)
 }
 
 //----------------------------------------------------------------------
-// main
+// NachosMain
 // 	Bootstrap the operating system kernel.
 //
 //	Initialize kernel data structures
@@ -180,8 +230,8 @@ CreateDirectory(char *name)
 //		ex: "nachos -d +" -> argv = {"nachos", "-d", "+"}
 //----------------------------------------------------------------------
 
-int
-main(int argc, char **argv)
+static int
+NachosMain(int argc, char **argv)
 {
     int i;
     char *debugArg = "";
@@ -189,13 +239,18 @@ main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    int switchBenchCount = 0;
+    char *workloadSpec = NULL;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
+    char *cloneFromName = NULL;       // Nachos file to be cloned
+    char *cloneToName = NULL;         // name of the clone
     char *printFileName = NULL;
     char *removeFileName = NULL;
     bool dirListFlag = false;
     bool dumpFlag = false;
+    bool defragFlag = false;
     // MP4 mod tag
     char *createDirectoryName = NULL;
     char *listDirectoryName = NULL;
@@ -237,6 +292,18 @@ main(int argc, char **argv)
                 {
                     networkTestFlag = TRUE;
                 }
+            else if (strcmp(argv[i], "-cs") == 0)
+                {
+                    ASSERT(i + 1 < argc);
+                    switchBenchCount = atoi(argv[i + 1]);
+                    i++;
+                }
+            else if (strcmp(argv[i], "-wl") == 0)
+                {
+                    ASSERT(i + 1 < argc);
+                    workloadSpec = argv[i + 1];
+                    i++;
+                }
 #ifndef FILESYS_STUB
             else if (strcmp(argv[i], "-cp") == 0)
                 {
@@ -245,6 +312,13 @@ main(int argc, char **argv)
                     copyNachosFileName = argv[i + 2];
                     i += 2;
                 }
+            else if (strcmp(argv[i], "-clone") == 0)
+                {
+                    ASSERT(i + 2 < argc);
+                    cloneFromName = argv[i + 1];
+                    cloneToName = argv[i + 2];
+                    i += 2;
+                }
             else if (strcmp(argv[i], "-p") == 0)
                 {
                     ASSERT(i + 1 < argc);
@@ -295,16 +369,23 @@ main(int argc, char **argv)
                 {
                     dumpFlag = true;
                 }
+            else if (strcmp(argv[i], "-defrag") == 0)
+                {
+                    defragFlag = true;
+                }
 #endif //FILESYS_STUB
             else if (strcmp(argv[i], "-u") == 0)
                 {
                     cout << "Partial usage: nachos [-z -d debugFlags]\n";
                     cout << "Partial usage: nachos [-x programName]\n";
-                    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+                    cout << "Partial usage: nachos [-K] [-C] [-N] [-cs #]\n";
+                    cout << "Partial usage: nachos [-wl key=value,...]\n";
+                    cout << "Partial usage: nachos [-hosts #]\n";
 #ifndef FILESYS_STUB
                     cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
+                    cout << "Partial usage: nachos [-clone NachosFile NachosFile]\n";
                     cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
-                    cout << "Partial usage: nachos [-l] [-D]\n";
+                    cout << "Partial usage: nachos [-l] [-D] [-defrag]\n";
 #endif //FILESYS_STUB
                 }
 
@@ -314,6 +395,10 @@ main(int argc, char **argv)
     DEBUG(dbgThread, "Entering main");
 
     kernel = new Kernel(argc, argv);
+    if (hostNet != NULL)
+        {
+            kernel->hostName = hostIndex;	// overrides -m
+        }
 
     kernel->Initialize();
 
@@ -333,6 +418,17 @@ main(int argc, char **argv)
         {
             kernel->NetworkTest();   // two-machine test of the network
         }
+    if (switchBenchCount > 0)
+        {
+            kernel->SwitchBenchmark(switchBenchCount);  // time context switches
+        }
+    if (workloadSpec != NULL)
+        {
+            Workload *workload = new Workload(workloadSpec);
+
+            workload->Run();		// how the scheduler serves it
+            delete workload;
+        }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL)
@@ -343,6 +439,18 @@ main(int argc, char **argv)
         {
             Copy(copyUnixFileName,copyNachosFileName);
         }
+    if (cloneFromName != NULL && cloneToName != NULL)
+        {
+            if (!kernel->fileSystem->Clone(cloneFromName, cloneToName))
+                {
+                    printf("Clone: couldn't clone %s to %s\n", cloneFromName,
+                           cloneToName);
+                }
+        }
+    if (defragFlag)
+        {
+            kernel->fileSystem->Defragment();
+        }
     if (dumpFlag)
         {
             kernel->fileSystem->Print();
@@ -372,5 +480,61 @@ main(int argc, char **argv)
 //    kernel->interrupt->Halt();
 
     ASSERTNOTREACHED();
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// HostMain
+// 	Run one of the machines of "-hosts N" on its own host thread.
+//	The machine never returns from NachosMain: its kernel ends the
+//	host thread when it halts.
+//
+//	"arg" is the machine id
+//----------------------------------------------------------------------
+
+static void *
+HostMain(void *arg)
+{
+    hostIndex = (int) (long) arg;
+    (void) NachosMain(hostArgc, hostArgv);
+    return NULL;
 }
 
+//----------------------------------------------------------------------
+// main
+// 	Run a single machine, or with "-hosts N", start N machines on
+//	their own host threads and wait for all of them to halt.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    int numHosts = 0;
+    unsigned long threads[MaxHosts];
+
+    for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-hosts") == 0)
+                {
+                    ASSERT(i + 1 < argc);   // next argument is int
+                    numHosts = atoi(argv[i + 1]);
+                    ASSERT((numHosts >= 1) && (numHosts <= MaxHosts));
+                    i++;
+                }
+        }
+    if (numHosts == 0)
+        {
+            return NachosMain(argc, argv);
+        }
+
+    hostArgc = argc;
+    hostArgv = argv;
+    hostNet = new HostNet(numHosts);
+    RandomPerHostThread();
+    for (int i = 0; i < numHosts; i++)
+        threads[i] = StartHostThread(HostMain, (void *) (long) i);
+    for (int i = 0; i < numHosts; i++)
+        JoinHostThread(threads[i]);
+    delete hostNet;
+    return 0;
+}
@@ -12,8 +12,10 @@
 #include "debug.h"
 #include "kernel.h"
 
-extern Kernel *kernel;
-extern Debug *debug;
+// There is one kernel per simulated machine; when several machines run
+// in one process ("-hosts N"), each host thread has its own.
+extern __thread Kernel *kernel;
+extern __thread Debug *debug;
 
 #endif // MAIN_H
 
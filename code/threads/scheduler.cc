@@ -14,6 +14,16 @@
 // 	Very simple implementation -- no priorities, straight FIFO.
 //	Might need to be improved in later assignments.
 //
+//	In SMP mode ("-smp N") each CPU has its own FIFO.  CPUs take turns
+//	in round-robin order, one dispatch per turn; a CPU whose queue is
+//	empty steals the front thread of the longest other queue, if that
+//	queue has more work than its own CPU can run right away.
+//
+//	Real-time threads come first, earliest deadline first (see
+//	scheduler.h).  Their jobs are released by interrupts scheduled
+//	every period, and their budget is enforced at the timer interrupt,
+//	whose Yield takes the CPU away from a thread that has used it up.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -23,16 +33,73 @@
 #include "scheduler.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// EarlierDeadline
+// 	Compare two real-time threads by the deadline of their current
+//	jobs, for the sorted list of ready real-time threads.
+//----------------------------------------------------------------------
+
+static int
+EarlierDeadline(Thread *x, Thread *y)
+{
+    return x->realTime->AbsDeadline() - y->realTime->AbsDeadline();
+}
+
+//----------------------------------------------------------------------
+// RealTimeTask::RealTimeTask
+// 	Initialize the real-time state of "thread", with its first job
+//	released now.
+//----------------------------------------------------------------------
+
+RealTimeTask::RealTimeTask(Thread *thread, int period, int budget,
+                           int deadline)
+{
+    this->thread = thread;
+    this->period = period;
+    this->budget = budget;
+    this->deadline = deadline;
+    release = runStart = kernel->stats->totalTicks;
+    runIdle = kernel->stats->idleTicks;
+    used = 0;
+    done = parked = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RealTimeTask::CallBack
+// 	Interrupt handler for the end of each period.
+//----------------------------------------------------------------------
+
+void
+RealTimeTask::CallBack()
+{
+    kernel->scheduler->Release(this);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
 //	Initially, no ready threads.
+//
+//	"numCpus" -- number of simulated CPUs, one ready list each
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(int numCpus)
 {
-    readyList = new List<Thread *>;
+    ASSERT((numCpus >= 1) && (numCpus <= MaxCpus));
+    this->numCpus = numCpus;
+    for (int i = 0; i < numCpus; i++)
+        {
+            readyList[i] = new List<Thread *>;
+            busyTicks[i] = dispatches[i] = steals[i] = spinTicks[i] = 0;
+            liveUser[i] = NULL;
+        }
     toBeDestroyed = NULL;
+    realTimeList = new SortedList<Thread *>(EarlierDeadline);
+    density = 0;
+    lastCpu = numCpus - 1;	// so that CPU 0 gets the first turn
+    nextHomeCpu = 0;
+    runningCpu = 0;
+    lastDispatch = lastIdle = 0;
 }
 
 //----------------------------------------------------------------------
@@ -42,7 +109,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 {
-    delete readyList;
+    for (int i = 0; i < numCpus; i++)
+        delete readyList[i];
+    delete realTimeList;
 }
 
 //----------------------------------------------------------------------
@@ -60,13 +129,40 @@ Scheduler::ReadyToRun (Thread *thread)
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
     //cout << "Putting thread on ready list: " << thread->getName() << endl ;
     thread->setStatus(READY);
-    readyList->Append(thread);
+    if (thread->getCpu() < 0)  	// new thread, spread them over the CPUs
+        {
+            thread->setCpu(nextHomeCpu);
+            nextHomeCpu = (nextHomeCpu + 1) % numCpus;
+        }
+    if (thread->realTime != NULL)
+        {
+            RealTimeTask *task = thread->realTime;
+
+            if (task->done || (Used(task) >= task->budget))
+                {
+                    DEBUG(dbgThread, "Out of budget until next release: " << thread->getName());
+                    thread->setStatus(BLOCKED);
+                    task->parked = TRUE;
+                    return;
+                }
+            realTimeList->Insert(thread);
+            return;
+        }
+    readyList[thread->getCpu()]->Append(thread);
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
 //	If there are no ready threads, return NULL.
+//
+//	The CPUs get their turn in round-robin order.  A CPU with an
+//	empty ready list steals from the longest list, but only if that
+//	list holds more than the one thread its own CPU would run next;
+//	otherwise the turn passes to the next CPU.
+//
+//	A ready real-time thread, though, is run ahead of all of these,
+//	on whichever CPU has the turn.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -74,16 +170,56 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
+    int cpu, victim;
+    Thread *thread;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    if (readyList->IsEmpty())
+    if (!realTimeList->IsEmpty())
         {
-            return NULL;
+            lastCpu = (lastCpu + 1) % numCpus;
+            thread = realTimeList->RemoveFront();
+            thread->setCpu(lastCpu);
+            return thread;
         }
-    else
+    for (int turn = 1; turn <= numCpus; turn++)
         {
-            return readyList->RemoveFront();
+            cpu = (lastCpu + turn) % numCpus;
+            if (!readyList[cpu]->IsEmpty())
+                {
+                    lastCpu = cpu;
+                    return readyList[cpu]->RemoveFront();
+                }
+            victim = LongestQueue();
+            if (victim >= 0 && readyList[victim]->NumInList() > 1)
+                {
+                    thread = readyList[victim]->RemoveFront();
+                    DEBUG(dbgThread, "CPU " << cpu << " steals " << thread->getName() << " from CPU " << victim);
+                    thread->setCpu(cpu);
+                    steals[cpu]++;
+                    lastCpu = cpu;
+                    return thread;
+                }
         }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::LongestQueue
+// 	Return the CPU with the most ready threads, or -1 if every
+//	ready list is empty.
+//----------------------------------------------------------------------
+
+int
+Scheduler::LongestQueue()
+{
+    int longest = -1;
+
+    for (int i = 0; i < numCpus; i++)
+        if (!readyList[i]->IsEmpty() && (longest < 0 ||
+                readyList[i]->NumInList() > readyList[longest]->NumInList()))
+            longest = i;
+    return longest;
 }
 
 //----------------------------------------------------------------------
@@ -92,6 +228,12 @@ Scheduler::FindNextToRun ()
 //	and load the state of the new thread, by calling the machine
 //	dependent context switch routine, SWITCH.
 //
+//	The user registers of a user program are left in its CPU's
+//	register file, and its page table in the machine, when it stops
+//	running; they are saved only when another user program needs the
+//	CPU (LoadUserState).  So a switch to a kernel thread and back, or
+//	between threads of one address space, copies less.
+//
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
 // Side effect:
@@ -116,14 +258,27 @@ Scheduler::Run (Thread *nextThread, bool finishing)
             toBeDestroyed = oldThread;
         }
 
-    if (oldThread->space != NULL)  	// if this thread is a user program,
+    oldThread->CheckOverflow();		    // check if the old thread
+    // had an undetected stack overflow
+
+    if (oldThread->realTime != NULL)  	// charge its job for the CPU
+        {
+            oldThread->realTime->used = Used(oldThread->realTime);
+        }
+    if (nextThread->realTime != NULL)
         {
-            oldThread->SaveUserState(); 	// save the user's CPU registers
-            oldThread->space->SaveState();
+            nextThread->realTime->runStart = kernel->stats->totalTicks;
+            nextThread->realTime->runIdle = kernel->stats->idleTicks;
         }
 
-    oldThread->CheckOverflow();		    // check if the old thread
-    // had an undetected stack overflow
+    ChargeCpu();			// the CPU we are leaving
+    runningCpu = nextThread->getCpu();
+    dispatches[runningCpu]++;
+    kernel->stats->numContextSwitches++;
+    if (kernel->machine != NULL)
+        {
+            kernel->machine->SetCpu(runningCpu);	// its register file and TLB
+        }
 
     kernel->currentThread = nextThread;  // switch to the next thread
     nextThread->setStatus(RUNNING);      // nextThread is now running
@@ -150,11 +305,60 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 
     if (oldThread->space != NULL)  	    // if there is an address space
         {
-            oldThread->RestoreUserState();     // to restore, do it.
-            oldThread->space->RestoreState();
+            LoadUserState(oldThread);	    // to restore, do it.
         }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::LoadUserState
+// 	Make the user registers of "thread" the ones in the register file
+//	of the running CPU, and its page table the machine's, unless they
+//	still are from the last time it ran here.  Whoever's registers
+//	are in the way are saved first, as are the registers "thread" left
+//	on another CPU.  Interrupts must be off.
+//
+//	"thread" is the user program about to run
+//----------------------------------------------------------------------
+
+void
+Scheduler::LoadUserState(Thread *thread)
+{
+    int cpu = kernel->machine->CurrentCpu();
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (liveUser[cpu] != thread)
+        {
+            for (int i = 0; i < numCpus; i++)
+                {
+                    if ((liveUser[i] != NULL) &&
+                            ((i == cpu) || (liveUser[i] == thread)))
+                        SaveUserState(i);
+                }
+            thread->RestoreUserState();
+            liveUser[cpu] = thread;
+            kernel->stats->numUserLoads++;
+        }
+    thread->space->RestoreState();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SaveUserState
+// 	Copy the register file of CPU "cpu" back into the thread whose
+//	user registers it holds, so that another thread can use it.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SaveUserState(int cpu)
+{
+    Machine *machine = kernel->machine;
+    int running = machine->CurrentCpu();
+
+    machine->SetCpu(cpu);
+    liveUser[cpu]->SaveUserState();
+    machine->SetCpu(running);
+    liveUser[cpu] = NULL;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
 // 	If the old thread gave up the processor because it was finishing,
@@ -168,6 +372,11 @@ Scheduler::CheckToBeDestroyed()
 {
     if (toBeDestroyed != NULL)
         {
+            for (int i = 0; i < numCpus; i++)
+                {
+                    if (liveUser[i] == toBeDestroyed)
+                        liveUser[i] = NULL;	// its registers are dead
+                }
             delete toBeDestroyed;
             toBeDestroyed = NULL;
         }
@@ -182,5 +391,241 @@ void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    for (int i = 0; i < numCpus; i++)
+        {
+            if (numCpus > 1)
+                {
+                    cout << "CPU " << i << ": ";
+                }
+            readyList[i]->Apply(ThreadPrint);
+        }
+    if (!realTimeList->IsEmpty())
+        {
+            cout << "Real-time: ";
+            realTimeList->Apply(ThreadPrint);
+        }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetRealTime
+// 	Make "thread" a periodic real-time thread, with its first job
+//	released now, if it can be admitted: the deadline may not be
+//	later than the end of the period, and the budgets of all the
+//	real-time threads, each over its deadline, may not add up to more
+//	than one CPU.  EDF then meets every deadline.  Return FALSE if
+//	the thread is refused.
+//
+//	"thread" -- the running thread, or one not yet forked
+//	"period" -- ticks between releases of its jobs
+//	"budget" -- ticks of CPU each job may use
+//	"deadline" -- ticks from release by which each job is to be done
+//----------------------------------------------------------------------
+
+bool
+Scheduler::SetRealTime(Thread *thread, int period, int budget, int deadline)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    double load = (double) budget / deadline;
+
+    ASSERT((thread == kernel->currentThread) ||
+           (thread->getStatus() == JUST_CREATED));
+    if ((budget <= 0) || (budget > deadline) || (deadline > period) ||
+            (thread->realTime != NULL) || (density + load > 1.0))
+        {
+            DEBUG(dbgThread, "Real-time thread refused: " << thread->getName());
+            kernel->stats->numRealTimeRejects++;
+            (void) kernel->interrupt->SetLevel(oldLevel);
+            return FALSE;
+        }
+    density += load;
+    thread->realTime = new RealTimeTask(thread, period, budget, deadline);
+    kernel->interrupt->Schedule(thread->realTime, period, TimerInt);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndRealTime
+// 	"thread" is being deleted; give back its share of the CPU.  Its
+//	task is left for the pending release interrupt to delete.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndRealTime(Thread *thread)
+{
+    RealTimeTask *task = thread->realTime;
+
+    density -= (double) task->budget / task->deadline;
+    task->thread = NULL;
+    thread->realTime = NULL;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextPeriod
+// 	The current thread, a real-time one, has finished its job.  Count
+//	a miss if it is late, and sleep until the next release.
+//----------------------------------------------------------------------
+
+void
+Scheduler::NextPeriod()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Thread *thread = kernel->currentThread;
+    RealTimeTask *task = thread->realTime;
+
+    ASSERT(task != NULL);
+    kernel->stats->numRealTimeJobs++;
+    if (kernel->stats->totalTicks > task->AbsDeadline())
+        {
+            DEBUG(dbgThread, "Deadline missed: " << thread->getName());
+            kernel->stats->numDeadlineMisses++;
+        }
+    task->done = TRUE;
+    task->parked = TRUE;
+    thread->Sleep(FALSE);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Release
+// 	A new period of "task" begins: if its last job is not done, it
+//	missed its deadline (and carries on as the new job).  Give the
+//	job a fresh budget, put the thread back on the ready list if it
+//	was held off it, and preempt the running thread if the job is
+//	due sooner.  Called from the interrupt handler.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Release(RealTimeTask *task)
+{
+    Thread *thread = task->thread;
+    Thread *current = kernel->currentThread;
+
+    if (thread == NULL)  		// thread is gone
+        {
+            delete task;
+            return;
+        }
+    if (!task->done)
+        {
+            DEBUG(dbgThread, "Deadline missed: " << thread->getName());
+            kernel->stats->numDeadlineMisses++;
+        }
+    task->release = task->runStart = kernel->stats->totalTicks;
+    task->runIdle = kernel->stats->idleTicks;
+    task->used = 0;
+    task->done = FALSE;
+    kernel->interrupt->Schedule(task, task->period, TimerInt);
+    if (task->parked)
+        {
+            task->parked = FALSE;
+            ReadyToRun(thread);
+            if ((kernel->interrupt->getStatus() != IdleMode) &&
+                    ((current->realTime == NULL) ||
+                     (current->realTime->AbsDeadline() > task->AbsDeadline())))
+                {
+                    kernel->interrupt->YieldOnReturn();
+                }
+        }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldYield
+// 	Return FALSE if the current thread is a real-time thread that has
+//	budget left, and no ready real-time thread is due sooner, so it
+//	keeps the CPU when asked to yield (by the timer, say).
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldYield()
+{
+    RealTimeTask *task = kernel->currentThread->realTime;
+
+    if ((task == NULL) || task->done || (Used(task) >= task->budget))
+        {
+            return TRUE;
+        }
+    return !realTimeList->IsEmpty() &&
+           (realTimeList->Front()->realTime->AbsDeadline() < task->AbsDeadline());
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Used
+// 	Return the ticks the current job of "task" has run, counting the
+//	time since it got the CPU, less any time idle, if it is running
+//	now.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Used(RealTimeTask *task)
+{
+    Statistics *stats = kernel->stats;
+
+    if (task->thread == kernel->currentThread)
+        {
+            return task->used + (stats->totalTicks - task->runStart)
+                   - (stats->idleTicks - task->runIdle);
+        }
+    return task->used;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ChargeCpu
+// 	Charge the time since the last dispatch, less any time spent
+//	idle, to the CPU of the running thread.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ChargeCpu()
+{
+    busyTicks[runningCpu] += (kernel->stats->totalTicks - lastDispatch)
+                             - (kernel->stats->idleTicks - lastIdle);
+    lastDispatch = kernel->stats->totalTicks;
+    lastIdle = kernel->stats->idleTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ChargeSpin
+// 	Charge time spent spinning on a SpinLock to the CPU that waited.
+//	While it spun, the simulated CPUs took turns, so the time is not
+//	in its busy ticks; a real CPU would have spent it spinning.
+//
+//	"cpu" -- the waiting CPU
+//	"ticks" -- how long it waited
+//----------------------------------------------------------------------
+
+void
+Scheduler::ChargeSpin(int cpu, int ticks)
+{
+    ASSERT((cpu >= 0) && (cpu < numCpus));
+    spinTicks[cpu] += ticks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintCpuStats
+// 	Print how the work was spread over the simulated CPUs.  The CPUs
+//	share one simulated clock, so the busiest CPU's ticks, counting
+//	its spinning, approximate how long the same work would take with
+//	the CPUs in parallel.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintCpuStats()
+{
+    int busiest = 0, total = 0, spinning = 0;
+
+    ChargeCpu();
+    for (int i = 0; i < numCpus; i++)
+        {
+            cout << "CPU " << i << ": busy " << busyTicks[i];
+            cout << ", spin " << spinTicks[i];
+            cout << ", dispatches " << dispatches[i];
+            cout << ", steals " << steals[i] << "\n";
+            total += busyTicks[i];
+            spinning += spinTicks[i];
+            if (busyTicks[i] + spinTicks[i] > busiest)
+                busiest = busyTicks[i] + spinTicks[i];
+        }
+    cout << "SMP: total busy " << total << ", spin " << spinning;
+    cout << ", busiest CPU " << busiest << "\n";
 }
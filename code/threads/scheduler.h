@@ -12,15 +12,58 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "callback.h"
 
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
 // thread is running, and which threads are ready but not running.
+//
+// In SMP mode there is one ready list per simulated CPU.  The CPUs
+// take turns, one dispatch at a time, so the interleaving is
+// deterministic; a CPU with nothing to run steals from the longest
+// ready list of another CPU.
+//
+// Real-time threads form a class of their own, ahead of the others:
+// a periodic thread is released every "period" ticks to do a job of
+// at most "budget" ticks, due "deadline" ticks after its release.
+// Ready real-time threads are kept in one list for all the CPUs,
+// earliest deadline first (EDF), and a CPU runs them before anything
+// on its own ready list.  A thread is admitted only if the threads
+// already admitted leave room for its budget, so that EDF can meet
+// every deadline; one that uses up its budget is held off the CPU
+// until its next release.
+
+// The real-time parameters and state of a periodic thread.  Its
+// CallBack is the release of each job.
+class RealTimeTask : public CallBackObj
+{
+public:
+    RealTimeTask(Thread *thread, int period, int budget, int deadline);
+
+    void CallBack();		// Release the next job
+
+    int AbsDeadline()
+    {
+        return release + deadline;
+    }
+    // when the current job is due
+
+    Thread *thread;		// NULL once the thread is gone
+    int period;			// ticks between releases
+    int budget;			// ticks each job may run
+    int deadline;		// ticks from release to deadline
+    int release;		// when the current job was released
+    int used;			// ticks the current job has run
+    int runStart;		// when the thread last got the CPU
+    int runIdle;		// idleTicks then
+    bool done;			// job done, waiting for the next release
+    bool parked;		// held off the ready list until then
+};
 
 class Scheduler
 {
 public:
-    Scheduler();		// Initialize list of ready threads
+    Scheduler(int numCpus);	// Initialize list of ready threads
     ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);
@@ -31,15 +74,55 @@ public:
     // Cause nextThread to start running
     void CheckToBeDestroyed();// Check if thread that had been
     // running needs to be deleted
+    void LoadUserState(Thread *thread);
+    // Make the user registers and page
+    // table of "thread" the live ones
     void Print();		// Print contents of ready list
 
+    bool SetRealTime(Thread *thread, int period, int budget, int deadline);
+    // Make "thread" a periodic real-time
+    // thread, if there is room for it
+    void EndRealTime(Thread *thread);	// It is going away
+    void NextPeriod();		// The current real-time thread is done
+    // with its job; wait for the next
+    bool ShouldYield();		// FALSE if the current thread is a
+    // real-time thread that is to keep
+    // the CPU
+    void Release(RealTimeTask *task);	// Start the next job of "task"
+    void ChargeSpin(int cpu, int ticks);	// CPU "cpu" spent "ticks"
+    // spinning on a lock
+    void PrintCpuStats();	// Print per-CPU statistics (SMP mode)
+
     // SelfTest for scheduler is implemented in class Thread
 
 private:
-    List<Thread *> *readyList;  // queue of threads that are ready to run,
-    // but not running
+    int numCpus;		// number of simulated CPUs
+    List<Thread *> *readyList[MaxCpus];  // per-CPU queue of threads that
+    // are ready to run, but not running
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     // by the next thread that runs
+    SortedList<Thread *> *realTimeList; // ready real-time threads, by
+    // deadline
+    double density;		// sum of budget/deadline of the
+    // admitted real-time threads
+
+    int lastCpu;		// CPU that had the most recent turn
+    int nextHomeCpu;		// CPU to place the next new thread on
+    int runningCpu;		// CPU of the running thread
+    int lastDispatch;		// totalTicks at the most recent dispatch
+    int lastIdle;		// idleTicks at the most recent dispatch
+    int busyTicks[MaxCpus];	// non-idle time charged to each CPU
+    int dispatches[MaxCpus];	// threads dispatched on each CPU
+    int steals[MaxCpus];	// threads each CPU stole from another
+    int spinTicks[MaxCpus];	// time each CPU spent spinning
+    Thread *liveUser[MaxCpus];	// thread whose user registers are in
+    // each CPU's register file, or NULL
+
+    int LongestQueue();		// CPU with the most ready threads
+    void ChargeCpu();		// update busyTicks of the running CPU
+    int Used(RealTimeTask *task);	// ticks its current job has run
+    void SaveUserState(int cpu);	// write the registers of CPU "cpu"
+    // back to the thread they belong to
 };
 
 #endif // SCHEDULER_H
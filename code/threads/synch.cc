@@ -164,6 +164,7 @@ Lock::Lock(char* debugName)
     name = debugName;
     semaphore = new Semaphore("lock", 1);  // initially, unlocked
     lockHolder = NULL;
+    numAcquires = numContended = waitTicks = 0;
 }
 
 //----------------------------------------------------------------------
@@ -184,8 +185,16 @@ Lock::~Lock()
 
 void Lock::Acquire()
 {
+    int start = kernel->stats->totalTicks;
+
+    if (lockHolder != NULL)
+        {
+            numContended++;
+        }
     semaphore->P();
     lockHolder = kernel->currentThread;
+    numAcquires++;
+    waitTicks += kernel->stats->totalTicks - start;
 }
 
 //----------------------------------------------------------------------
@@ -206,6 +215,112 @@ void Lock::Release()
     semaphore->V();
 }
 
+//----------------------------------------------------------------------
+// Lock::PrintStats
+//	Print how often the lock was acquired, how often it was found
+//	busy, and how long threads waited for it.
+//----------------------------------------------------------------------
+
+void Lock::PrintStats()
+{
+    cout << "Lock " << name << ": acquires " << numAcquires;
+    cout << ", contended " << numContended;
+    cout << ", wait ticks " << waitTicks << "\n";
+}
+
+//----------------------------------------------------------------------
+// SpinLock::SpinLock
+// 	Initialize a spin lock.  Initially, unlocked.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SpinLock::SpinLock(char* debugName)
+{
+    name = debugName;
+    lockHolder = NULL;
+    numAcquires = numContended = numSpins = spinTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// SpinLock::~SpinLock
+// 	Deallocate a spin lock
+//----------------------------------------------------------------------
+
+SpinLock::~SpinLock()
+{
+    ASSERT(lockHolder == NULL);
+}
+
+//----------------------------------------------------------------------
+// SpinLock::Acquire
+//	Try to take the lock; while it is busy, give up the turn and try
+//	again.  The test and the set happen with interrupts disabled, so
+//	together they act like an atomic test-and-set.  The time spent
+//	spinning is charged to the CPU we were waiting on.
+//
+//	With interrupts already disabled (while the kernel boots, say),
+//	nobody else can run to release the lock, so it must be free.
+//----------------------------------------------------------------------
+
+void SpinLock::Acquire()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    int start = kernel->stats->totalTicks;
+    int cpu = kernel->currentThread->getCpu();
+    IntStatus oldLevel;
+
+    ASSERT(!IsHeldByCurrentThread());
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (lockHolder != NULL)
+        {
+            numContended++;
+        }
+    while (lockHolder != NULL)  		// busy, spin
+        {
+            ASSERT(oldLevel == IntOn);
+            numSpins++;
+            (void) interrupt->SetLevel(IntOn);	// time passes while spinning
+            kernel->currentThread->Yield();
+            (void) interrupt->SetLevel(IntOff);
+        }
+    lockHolder = kernel->currentThread;
+    numAcquires++;
+    if (kernel->stats->totalTicks > start)
+        {
+            spinTicks += kernel->stats->totalTicks - start;
+            kernel->scheduler->ChargeSpin(cpu, kernel->stats->totalTicks - start);
+        }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SpinLock::Release
+//	Set the lock to be free.  Spinning threads notice on their
+//	next try; nobody needs to be woken up.
+//----------------------------------------------------------------------
+
+void SpinLock::Release()
+{
+    ASSERT(IsHeldByCurrentThread());
+    lockHolder = NULL;
+}
+
+//----------------------------------------------------------------------
+// SpinLock::PrintStats
+//	Print how often the lock was acquired, how often it was found
+//	busy, and how much time was spent spinning on it.
+//----------------------------------------------------------------------
+
+void SpinLock::PrintStats()
+{
+    cout << "SpinLock " << name << ": acquires " << numAcquires;
+    cout << ", contended " << numContended;
+    cout << ", spins " << numSpins;
+    cout << ", spin ticks " << spinTicks << "\n";
+}
+
 //----------------------------------------------------------------------
 // Condition::Condition
 // 	Initialize a condition variable, so that it can be
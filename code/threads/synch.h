@@ -90,12 +90,59 @@ public:
     // return true if the current thread
     // holds this lock.
 
+    void PrintStats();		// print contention statistics
+
     // Note: SelfTest routine provided by SynchList
 
 private:
     char *name;			// debugging assist
     Thread *lockHolder;		// thread currently holding lock
     Semaphore *semaphore;	// we use a semaphore to implement lock
+
+    int numAcquires;		// times the lock was acquired
+    int numContended;		// ... of which found it busy
+    int waitTicks;		// total time spent waiting for it
+};
+
+// The following class defines a "spin lock".  It has the same
+// interface as a lock, but a thread that finds it busy does not sleep:
+// it keeps trying, as a CPU spinning on a test-and-set would.  Since
+// the simulated CPUs take turns, each failed try yields the turn so
+// that the holder can make progress; the time until the lock is ours
+// is what the waiting CPU would have wasted spinning, and is charged
+// to it (see Scheduler::ChargeSpin).
+//
+// Spin locks are meant for short critical sections that never sleep,
+// such as queueing disk requests (see SynchDisk).
+
+class SpinLock
+{
+public:
+    SpinLock(char* debugName);	// initialize spin lock to be FREE
+    ~SpinLock();			// deallocate spin lock
+    char* getName()
+    {
+        return name;    // debugging assist
+    }
+
+    void Acquire(); 		// spin until FREE, then set to BUSY
+    void Release(); 		// set to FREE
+
+    bool IsHeldByCurrentThread()
+    {
+        return lockHolder == kernel->currentThread;
+    }
+
+    void PrintStats();		// print contention statistics
+
+private:
+    char *name;			// debugging assist
+    Thread *lockHolder;		// thread currently holding lock
+
+    int numAcquires;		// times the lock was acquired
+    int numContended;		// ... of which found it busy
+    int numSpins;		// failed attempts while spinning
+    int spinTicks;		// total time spent spinning
 };
 
 // The following class defines a "condition variable".  A condition
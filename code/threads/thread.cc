@@ -21,6 +21,7 @@
 #include "switch.h"
 #include "synch.h"
 #include "sysdep.h"
+#include "disktrace.h"
 
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
@@ -37,6 +38,8 @@ Thread::Thread(char* threadName, int threadID)
 {
     ID = threadID;
     name = threadName;
+    cpu = -1;
+    ioContext = IOData;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
@@ -47,6 +50,7 @@ Thread::Thread(char* threadName, int threadID)
             // of machine registers
         }
     space = NULL;
+    realTime = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -67,6 +71,9 @@ Thread::~Thread()
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
         DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    delete space;			// frees its frames for other programs
+    if (realTime != NULL)
+        kernel->scheduler->EndRealTime(this);
 }
 
 //----------------------------------------------------------------------
@@ -209,6 +216,11 @@ Thread::Yield ()
 
     DEBUG(dbgThread, "Yielding thread: " << name);
 
+    if (!kernel->scheduler->ShouldYield())  	// real-time, keep the CPU
+        {
+            (void) kernel->interrupt->SetLevel(oldLevel);
+            return;
+        }
     nextThread = kernel->scheduler->FindNextToRun();
     if (nextThread != NULL)
         {
@@ -413,6 +425,28 @@ Thread::RestoreUserState()
 }
 
 
+//----------------------------------------------------------------------
+// IOContextScope::IOContextScope
+// 	Tag the disk requests of the current thread with "context" until
+//	this object goes out of scope.
+//----------------------------------------------------------------------
+
+IOContextScope::IOContextScope(int context)
+{
+    oldContext = kernel->currentThread->getIOContext();
+    kernel->currentThread->setIOContext(context);
+}
+
+//----------------------------------------------------------------------
+// IOContextScope::~IOContextScope
+// 	Restore the context the current thread had before.
+//----------------------------------------------------------------------
+
+IOContextScope::~IOContextScope()
+{
+    kernel->currentThread->setIOContext(oldContext);
+}
+
 //----------------------------------------------------------------------
 // SimpleThread
 // 	Loop 5 times, yielding the CPU to another ready thread
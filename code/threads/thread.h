@@ -43,6 +43,8 @@
 #include "machine.h"
 #include "addrspace.h"
 
+class RealTimeTask;
+
 // CPU register state to be saved on context switch.
 // The x86 needs to save only a few registers,
 // SPARC and MIPS needs to save 10 registers,
@@ -117,6 +119,22 @@ public:
     {
         return (ID);
     }
+    int getCpu()
+    {
+        return (cpu);
+    }
+    void setCpu(int which)
+    {
+        cpu = which;
+    }
+    int getIOContext()
+    {
+        return (ioContext);
+    }
+    void setIOContext(int context)
+    {
+        ioContext = context;
+    }
     void Print()
     {
         cout << name;
@@ -132,6 +150,10 @@ private:
     ThreadStatus status;	// ready, running or blocked
     char* name;
     int   ID;
+    int   cpu;		// CPU whose run queue this thread belongs to,
+    // -1 if not yet placed (SMP mode)
+    int   ioContext;	// what the file system is doing for this
+    // thread (an IOContext, see disktrace.h)
     void StackAllocate(VoidFunctionPtr func, void *arg);
     // Allocate a stack for thread.
     // Used internally by Fork()
@@ -147,6 +169,22 @@ public:
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    RealTimeTask *realTime;		// Period, budget and deadline, if
+    // this is a real-time thread
+};
+
+// The following class sets what the file system is doing for the
+// current thread (an IOContext, see disktrace.h) for as long as it
+// exists, and then puts back what the thread was doing before.
+
+class IOContextScope
+{
+public:
+    IOContextScope(int context);	// current thread is now doing "context"
+    ~IOContextScope();			// back to what it did before
+
+private:
+    int oldContext;
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
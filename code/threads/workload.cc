@@ -0,0 +1,234 @@
+// workload.cc
+//	Routines to generate a synthetic workload of kernel threads, run
+//	it, and measure how the scheduler did.  See workload.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workload.h"
+#include "main.h"
+#include "synch.h"
+#include "synchdisk.h"
+
+//----------------------------------------------------------------------
+// Workload::Random
+// 	Return the next number, in [0, range), from the linear
+//	congruential generator whose state is at "state".
+//----------------------------------------------------------------------
+
+int
+Workload::Random(int *state, int range)
+{
+    *state = (int) (((unsigned int) *state * 1103515245u + 12345u) & 0x7fffffff);
+    return (range > 0) ? (*state >> 8) % range : 0;
+}
+
+//----------------------------------------------------------------------
+// Workload::Workload
+// 	Parse the description of the workload, and draw its jobs: how
+//	many bursts each runs, and so how much CPU it asks for.  The
+//	choices a job makes as it runs are drawn again, in the same
+//	order, from the same seed (JobBody).
+//
+//	"spec" -- "key=value" pairs separated by commas, for any of
+//		seed, jobs, bursts, cpu, io, lock, locks and arrival
+//		(see workload.h); the others keep their defaults
+//----------------------------------------------------------------------
+
+Workload::Workload(char *spec)
+{
+    char key[16];
+    int value, length, state;
+
+    seed = 1;
+    numJobs = 20;
+    bursts = 4;
+    cpu = 200;
+    ioPercent = 50;
+    lockPercent = 25;
+    numLocks = 2;
+    arrival = 300;
+    while (sscanf(spec, "%15[^=]=%d%n", key, &value, &length) == 2)
+        {
+            if (strcmp(key, "seed") == 0)
+                seed = value;
+            else if (strcmp(key, "jobs") == 0)
+                numJobs = value;
+            else if (strcmp(key, "bursts") == 0)
+                bursts = value;
+            else if (strcmp(key, "cpu") == 0)
+                cpu = value;
+            else if (strcmp(key, "io") == 0)
+                ioPercent = value;
+            else if (strcmp(key, "lock") == 0)
+                lockPercent = value;
+            else if (strcmp(key, "locks") == 0)
+                numLocks = value;
+            else if (strcmp(key, "arrival") == 0)
+                arrival = value;
+            else
+                cerr << "Workload: unknown parameter " << key << "\n";
+            spec += length;
+            if (*spec != ',')
+                break;
+            spec++;
+        }
+    ASSERT((numJobs >= 1) && (bursts >= 1) && (cpu >= 1) && (arrival >= 0));
+    ASSERT((numLocks >= 1) && (numLocks <= MaxWorkloadLocks));
+
+    for (int i = 0; i < numLocks; i++)
+        locks[i] = new Lock("workload");
+    done = new Semaphore("workload", 0);
+
+    state = seed;
+    jobs = new WorkloadJob[numJobs];
+    for (int i = 0; i < numJobs; i++)
+        {
+            WorkloadJob *job = &jobs[i];
+            int jobState;
+
+            job->workload = this;
+            job->thread = NULL;
+            job->seed = jobState = Random(&state, 0x7fffffff);
+            job->numBursts = 1 + Random(&jobState, 2 * bursts - 1);
+            job->demand = 0;
+            for (int b = 0; b < job->numBursts; b++)
+                {
+                    job->demand += 1 + Random(&jobState, 2 * cpu);
+                    (void) Random(&jobState, 100);	// lock?
+                    (void) Random(&jobState, numLocks);	// which
+                    (void) Random(&jobState, 100);	// disk read?
+                    (void) Random(&jobState, 0x7fffffff); // which sector
+                }
+            job->arrival = job->finish = 0;
+        }
+}
+
+//----------------------------------------------------------------------
+// Workload::~Workload
+// 	The job threads have all finished, and been deleted.
+//----------------------------------------------------------------------
+
+Workload::~Workload()
+{
+    for (int i = 0; i < numLocks; i++)
+        delete locks[i];
+    delete done;
+    delete [] jobs;
+}
+
+//----------------------------------------------------------------------
+// WorkloadJob::CallBack
+// 	Interrupt handler for the arrival of a job: start its thread.
+//----------------------------------------------------------------------
+
+void
+WorkloadJob::CallBack()
+{
+    arrival = kernel->stats->totalTicks;
+    thread = new Thread("workload job", -1);
+    thread->Fork(Workload::JobBody, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// Workload::JobBody
+// 	Run the bursts of a job, making the same choices the constructor
+//	drew for it.  A burst keeps the CPU busy for its ticks, yielding
+//	only if the scheduler takes the CPU away (each time interrupts
+//	are enabled, time advances by SystemTick).
+//
+//	"data" -- the job
+//----------------------------------------------------------------------
+
+void
+Workload::JobBody(void *data)
+{
+    WorkloadJob *job = (WorkloadJob *) data;
+    Workload *workload = job->workload;
+    Interrupt *interrupt = kernel->interrupt;
+    SynchDisk *disk = kernel->synchDisk;
+    char buffer[SectorSize];
+    int state = job->seed;
+    int ticks, sector;
+    Lock *lock;
+
+    (void) Random(&state, 2 * workload->bursts - 1);	// numBursts
+    for (int b = 0; b < job->numBursts; b++)
+        {
+            ticks = 1 + Random(&state, 2 * workload->cpu);
+            lock = (Random(&state, 100) < workload->lockPercent) ?
+                   workload->locks[Random(&state, workload->numLocks)] : NULL;
+            if (lock == NULL)
+                (void) Random(&state, workload->numLocks);
+            if (lock != NULL)
+                lock->Acquire();
+            for (int t = 0; t < ticks; t += SystemTick)
+                {
+                    (void) interrupt->SetLevel(IntOff);
+                    (void) interrupt->SetLevel(IntOn);
+                }
+            if (lock != NULL)
+                lock->Release();
+
+            if (Random(&state, 100) < workload->ioPercent)
+                {
+                    sector = Random(&state, disk->NumPhysicalSectors());
+                    disk->ReadPhysical(1, &sector, buffer);
+                }
+            else
+                (void) Random(&state, 0x7fffffff);
+        }
+    job->finish = kernel->stats->totalTicks;
+    workload->done->V();
+}
+
+//----------------------------------------------------------------------
+// Workload::Run
+// 	Schedule the arrival of every job, wait for them all to finish,
+//	and print how it went.
+//----------------------------------------------------------------------
+
+void
+Workload::Run()
+{
+    int state = seed + 1;
+    int when = 0, first, last;
+    int switches = kernel->stats->numContextSwitches;
+    int *response = new int[numJobs];
+    double sum = 0, rate, rateSum = 0, rateSquares = 0;
+
+    for (int i = 0; i < numJobs; i++)
+        {
+            kernel->interrupt->Schedule(&jobs[i], 1 + when, TimerInt);
+            when += Random(&state, 2 * arrival + 1);
+        }
+    for (int i = 0; i < numJobs; i++)
+        done->P();
+    switches = kernel->stats->numContextSwitches - switches;
+
+    first = jobs[0].arrival;
+    last = 0;
+    for (int i = 0; i < numJobs; i++)
+        {
+            int j;
+
+            last = max(last, jobs[i].finish);
+            for (j = i; (j > 0) && (response[j - 1] > jobs[i].finish - jobs[i].arrival); j--)
+                response[j] = response[j - 1];	// insertion sort
+            response[j] = jobs[i].finish - jobs[i].arrival;
+            sum += response[j];
+            rate = (double) jobs[i].demand / max(1, response[j]);
+            rateSum += rate;
+            rateSquares += rate * rate;
+        }
+
+    printf("Workload: jobs %d, ticks %d, throughput %.3f, response mean %.1f",
+           numJobs, last - first, numJobs * 1000.0 / max(1, last - first),
+           sum / numJobs);
+    printf(" p99 %d, switches %d, fairness %.3f\n",
+           response[(numJobs * 99 + 99) / 100 - 1], switches,
+           rateSum * rateSum / (numJobs * rateSquares));
+    delete [] response;
+}
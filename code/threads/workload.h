@@ -0,0 +1,81 @@
+// workload.h
+//	Data structures for a synthetic workload of kernel threads, to
+//	compare how the scheduler handles it under different policies.
+//
+//	The workload is a number of jobs arriving over time.  Each job is
+//	a kernel thread that runs a number of CPU bursts; some bursts are
+//	run holding one of a few shared locks, and some are followed by a
+//	read from the disk.  Everything is drawn from a seeded random
+//	number generator of its own, so the same seed gives the same jobs
+//	whatever the scheduler does with them -- run it with "-smp", "-rs"
+//	or "-fcfs" to compare (see test/sched_bench.sh).
+//
+//	When every job is done, one line sums up how it went: throughput,
+//	mean and 99th percentile response time (arrival to finish),
+//	context switches, and Jain's fairness index of the rate at which
+//	the jobs were served (CPU demand over response time).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "copyright.h"
+#include "callback.h"
+
+class Thread;
+class Lock;
+class Semaphore;
+class Workload;
+
+const int MaxWorkloadLocks = 16;
+
+// One job of the workload.  Its CallBack is its arrival.
+class WorkloadJob : public CallBackObj
+{
+public:
+    Workload *workload;
+    Thread *thread;
+    int seed;				// for the job's own choices
+    int numBursts;
+    int demand;				// ticks of CPU it asks for
+    int arrival;			// when it arrived
+    int finish;				// when it was done
+
+    void CallBack();			// Arrive: fork the thread
+};
+
+class Workload
+{
+public:
+    Workload(char *spec);		// Generate the jobs described by
+    // "spec", "key=value,..."
+    ~Workload();
+
+    void Run();				// Run the jobs and print the results
+
+private:
+    int seed;				// seed=: random number seed
+    int numJobs;			// jobs=: how many jobs
+    int bursts;				// bursts=: mean CPU bursts per job
+    int cpu;				// cpu=: mean ticks per burst
+    int ioPercent;			// io=: bursts followed by a disk read
+    int lockPercent;			// lock=: bursts run holding a lock
+    int numLocks;			// locks=: how many locks
+    int arrival;			// arrival=: mean ticks between arrivals
+
+    WorkloadJob *jobs;
+    Lock *locks[MaxWorkloadLocks];
+    Semaphore *done;			// V'ed as each job finishes
+
+    static int Random(int *state, int range);
+    // Next number in [0, range) from the
+    // generator at "state"
+    static void JobBody(void *data);	// What each job's thread does
+
+    friend class WorkloadJob;
+};
+
+#endif // WORKLOAD_H
@@ -0,0 +1,136 @@
+// workqueue.cc
+//	Routines to run the deferred work of interrupt handlers in a
+//	kernel thread.  See workqueue.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workqueue.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// WorkQueue::WorkQueue
+// 	Initialize an empty queue, and fork the thread that will run the
+//	items put on it.
+//----------------------------------------------------------------------
+
+WorkQueue::WorkQueue()
+{
+    pending = new List<WorkItem *>;
+    workerIdle = FALSE;
+    numEnqueued = numBatched = numRuns = 0;
+
+    worker = new Thread("work queue", -1);
+    worker->Fork((VoidFunctionPtr) WorkQueue::Worker, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::~WorkQueue
+// 	Nachos is halting.  The worker is asleep waiting for work, and
+//	is left that way.
+//----------------------------------------------------------------------
+
+WorkQueue::~WorkQueue()
+{
+    while (!pending->IsEmpty())
+        delete pending->RemoveFront();
+    delete pending;
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::Enqueue
+// 	Have the worker call "func" on "arg", unless it already has that
+//	call queued, in which case that one call does the work of both.
+//	Wake the worker up if it is waiting for work.
+//
+//	Interrupt handlers call this with interrupts off; others may
+//	call it either way.
+//
+//	"func" -- the procedure to call
+//	"arg" -- what to call it on
+//----------------------------------------------------------------------
+
+void
+WorkQueue::Enqueue(VoidFunctionPtr func, void *arg)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    ListIterator<WorkItem *> iter(pending);
+    WorkItem *item;
+
+    numEnqueued++;
+    for (; !iter.IsDone(); iter.Next())
+        {
+            if ((iter.Item()->func == func) && (iter.Item()->arg == arg))
+                {
+                    numBatched++;
+                    (void) kernel->interrupt->SetLevel(oldLevel);
+                    return;
+                }
+        }
+    item = new WorkItem;
+    item->func = func;
+    item->arg = arg;
+    pending->Append(item);
+    if (workerIdle)
+        {
+            workerIdle = FALSE;
+            kernel->scheduler->ReadyToRun(worker);
+        }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::Worker
+// 	Body of the worker thread.  Take every item queued so far off the
+//	queue at once, then run them with interrupts on; items queued
+//	while they run are left for the next time around.  Sleep when
+//	there is nothing to do.
+//
+//	"data" -- the work queue
+//----------------------------------------------------------------------
+
+void
+WorkQueue::Worker(void *data)
+{
+    WorkQueue *queue = (WorkQueue *) data;
+    Interrupt *interrupt = kernel->interrupt;
+    List<WorkItem *> *batch = new List<WorkItem *>;
+    WorkItem *item;
+
+    for (;;)
+        {
+            IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+            while (queue->pending->IsEmpty())
+                {
+                    queue->workerIdle = TRUE;
+                    kernel->currentThread->Sleep(FALSE);
+                }
+            while (!queue->pending->IsEmpty())
+                batch->Append(queue->pending->RemoveFront());
+            queue->numRuns++;
+            (void) interrupt->SetLevel(oldLevel);
+
+            DEBUG(dbgThread, "Work queue running " << batch->NumInList() << " items");
+            while (!batch->IsEmpty())
+                {
+                    item = batch->RemoveFront();
+                    (*item->func)(item->arg);
+                    delete item;
+                }
+        }
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::PrintStats
+//----------------------------------------------------------------------
+
+void
+WorkQueue::PrintStats()
+{
+    cout << "Work queue: items " << numEnqueued;
+    cout << ", batched " << numBatched;
+    cout << ", runs " << numRuns << "\n";
+}
@@ -0,0 +1,63 @@
+// workqueue.h
+//	Data structures for deferring the work of interrupt handlers.
+//
+//	Device interrupt handlers run with interrupts off, in the middle
+//	of whatever thread was running.  They should do only what must be
+//	done at once -- take the data off the device, give it its next
+//	request -- and leave the rest (waking up waiters, delivering
+//	packets to mailboxes) to a work item.  A kernel worker thread runs
+//	the queued items with interrupts on.
+//
+//	An item is a function and its argument.  Queuing an item that is
+//	already waiting to run does nothing, so the function must handle
+//	everything that has come in for its argument by the time it runs:
+//	a disk that finishes several requests, or a network that brings in
+//	several packets, before the worker gets the CPU has them all
+//	handled in one go.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "list.h"
+
+class Thread;
+
+// A function to call, and what to call it on.
+class WorkItem
+{
+public:
+    VoidFunctionPtr func;
+    void *arg;
+};
+
+class WorkQueue
+{
+public:
+    WorkQueue();			// Start the worker thread
+    ~WorkQueue();
+
+    void Enqueue(VoidFunctionPtr func, void *arg);
+    // Have the worker call func(arg);
+    // may be called by interrupt handlers
+
+    void PrintStats();			// Print how much work was batched
+
+private:
+    List<WorkItem *> *pending;		// Items not yet run
+    Thread *worker;			// The thread that runs them
+    bool workerIdle;			// Worker is asleep, waiting for work
+
+    int numEnqueued;			// items queued
+    int numBatched;			// ... of which were already pending
+    int numRuns;			// times the worker woke up to work
+
+    static void Worker(void *data);	// The worker thread's body
+};
+
+#endif // WORKQUEUE_H
@@ -6,7 +6,9 @@
 //	1. link with the -n -T 0 option
 //	2. run coff2noff to convert the object file to Nachos format
 //		(Nachos object code format is essentially just a simpler
-//		version of the UNIX executable object code format)
+//		version of the UNIX executable object code format); its
+//		aligned layout (NOFFALIGNED) lets pages be read as whole
+//		sectors
 //	3. load the NOFF file into the Nachos file system
 //		(if you are using the "stub" file system, you
 //		don't need to do this last step)
@@ -20,6 +22,7 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
+#include "frametable.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -59,40 +62,73 @@ SwapHeader (NoffHeader *noffH)
 
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
-// 	Create an address space to run a user program.
-//	Set up the translation from program memory to physical
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+// 	Create an address space to run a user program.  Every page is
+//	unmapped until Load sets up the translation from program memory
+//	to the frames of physical memory it allocates.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace()
 {
-    pageTable = new TranslationEntry[NumPhysPages];
-    for (int i = 0; i < NumPhysPages; i++)
+    tableSize = MaxVirtPages;
+    pageTable = new TranslationEntry[tableSize];
+    for (unsigned int i = 0; i < tableSize; i++)
         {
-            pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
-            pageTable[i].physicalPage = i;
-            pageTable[i].valid = TRUE;
+            pageTable[i].virtualPage = i;
+            pageTable[i].physicalPage = -1;
+            pageTable[i].valid = FALSE;
             pageTable[i].use = FALSE;
             pageTable[i].dirty = FALSE;
             pageTable[i].readOnly = FALSE;
         }
-
-    // zero out the entire address space
-    bzero(kernel->machine->mainMemory, MemorySize);
+    heapStart = brk = 0;
+    stackBottom = tableSize;		// no stack yet
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            shmPages[i] = -1;
+            shmCount[i] = 0;
+        }
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space: detach its shared memory, free the
+//	segments it created that nobody else maps, and free the frames
+//	of its own pages.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-    delete pageTable;
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            if (shmPages[i] >= 0)
+                kernel->sharedMemory->Detach(i, this);
+        }
+    kernel->sharedMemory->Exited(this);
+    for (unsigned int i = 0; i < tableSize; i++)
+        {
+            if (pageTable[i].valid)
+                kernel->frameTable->Free(pageTable[i].physicalPage);
+        }
+    if (kernel->machine->pageTable == pageTable)
+        kernel->machine->pageTable = NULL;	// don't leave it loaded
+    delete [] pageTable;
 }
 
 
+//----------------------------------------------------------------------
+// IsAligned
+// 	Return TRUE if a segment of an executable with the aligned
+//	layout starts at the same offset within a NOFFALIGNMENT block
+//	in the file as in memory.
+//----------------------------------------------------------------------
+
+static bool
+IsAligned(Segment *segment)
+{
+    return (segment->size == 0) ||
+           ((segment->inFileAddr - segment->virtualAddr) % NOFFALIGNMENT == 0);
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
@@ -109,6 +145,7 @@ AddrSpace::Load(char *fileName)
     OpenFile *executable = kernel->fileSystem->Open(fileName);
     NoffHeader noffH;
     unsigned int size;
+    bool aligned;
 
     if (executable == NULL)
         {
@@ -117,67 +154,120 @@ AddrSpace::Load(char *fileName)
         }
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) &&
-            (WordToHost(noffH.noffMagic) == NOFFMAGIC))
+    if (((noffH.noffMagic & ~NOFFALIGNED) != NOFFMAGIC) &&
+            ((WordToHost(noffH.noffMagic) & ~NOFFALIGNED) == NOFFMAGIC))
         SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    ASSERT((noffH.noffMagic & ~NOFFALIGNED) == NOFFMAGIC);
 
+// with the aligned layout, each whole page of a segment is whole
+// sectors of the file, so LoadSegment reads it straight into its frame
+    aligned = (noffH.noffMagic & NOFFALIGNED) != 0;
+    ASSERT(!aligned || (IsAligned(&noffH.code) && IsAligned(&noffH.initData)));
 #ifdef RDATA
-// how big is address space?
+    ASSERT(!aligned || IsAligned(&noffH.readonlyData));
+#endif
+    DEBUG(dbgAddr, "Executable layout: " << (aligned ? "aligned" : "packed"));
+
+#ifdef RDATA
+// how big is the program?
     size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size +
-           noffH.uninitData.size + UserStackSize;
-    // we need to increase the size
-    // to leave room for the stack
+           noffH.uninitData.size;
 #else
-// how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
-           + UserStackSize;	// we need to increase the size
-    // to leave room for the stack
+// how big is the program?
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
 #endif
-    numPages = divRoundUp(size, PageSize);
-    size = numPages * PageSize;
+    // the heap starts on the page after it, empty; the stack is
+    // above, at the top of the address space
+    heapStart = brk = divRoundUp(size, PageSize) * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-    // to run anything too big --
-    // at least until we have
-    // virtual memory
+    if (heapStart / PageSize + 2 > tableSize)	// a guard and a stack page
+        {
+            cerr << "Not enough memory for " << fileName << "\n";
+            delete executable;
+            return FALSE;
+        }
 
-    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
+    DEBUG(dbgAddr, "Initializing address space: " << heapStart / PageSize << ", " << size);
 
-// then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
-    if (noffH.code.size > 0)
+// then, copy in the code and data segments into memory; their pages
+// get frames as they are copied, and the uninitialized data gets them
+// when it is touched
+    if ((noffH.code.size > 0)
+            && !LoadSegment(executable, noffH.code.virtualAddr,
+                            noffH.code.size, noffH.code.inFileAddr))
         {
-            DEBUG(dbgAddr, "Initializing code segment.");
-            DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-            executable->ReadAt(
-                &(kernel->machine->mainMemory[noffH.code.virtualAddr]),
-                noffH.code.size, noffH.code.inFileAddr);
+            cerr << "Not enough memory for " << fileName << "\n";
+            delete executable;
+            return FALSE;
         }
-    if (noffH.initData.size > 0)
+    DEBUG(dbgAddr, "Loaded code segment: " << noffH.code.virtualAddr << ", " << noffH.code.size);
+    if ((noffH.initData.size > 0)
+            && !LoadSegment(executable, noffH.initData.virtualAddr,
+                            noffH.initData.size, noffH.initData.inFileAddr))
         {
-            DEBUG(dbgAddr, "Initializing data segment.");
-            DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-            executable->ReadAt(
-                &(kernel->machine->mainMemory[noffH.initData.virtualAddr]),
-                noffH.initData.size, noffH.initData.inFileAddr);
+            cerr << "Not enough memory for " << fileName << "\n";
+            delete executable;
+            return FALSE;
         }
+    DEBUG(dbgAddr, "Loaded data segment: " << noffH.initData.virtualAddr << ", " << noffH.initData.size);
 
 #ifdef RDATA
-    if (noffH.readonlyData.size > 0)
+    if ((noffH.readonlyData.size > 0)
+            && !LoadSegment(executable, noffH.readonlyData.virtualAddr,
+                            noffH.readonlyData.size, noffH.readonlyData.inFileAddr))
         {
-            DEBUG(dbgAddr, "Initializing read only data segment.");
-            DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-            executable->ReadAt(
-                &(kernel->machine->mainMemory[noffH.readonlyData.virtualAddr]),
-                noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
+            cerr << "Not enough memory for " << fileName << "\n";
+            delete executable;
+            return FALSE;
         }
+    DEBUG(dbgAddr, "Loaded read only data segment: " << noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
 #endif
 
     delete executable;			// close file
     return TRUE;			// success
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Read a segment of the program from the executable into its
+//	pages, a page at a time, since consecutive pages need not be in
+//	consecutive frames.  Return FALSE if it does not fit the address
+//	space.
+//
+//	If the executable has the aligned layout, a whole page is whole
+//	sectors of the file, and OpenFile::ReadAt transfers them into the
+//	frame without a bounce buffer; otherwise each read straddles
+//	sector boundaries.
+//
+//	"executable" -- the program file
+//	"virtAddr" -- where the segment goes
+//	"size" -- its length
+//	"inFileAddr" -- where it is in the file
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::LoadSegment(OpenFile *executable, int virtAddr, int size,
+                       int inFileAddr)
+{
+    unsigned int physAddr;
+    int chunk;
+
+    while (size > 0)
+        {
+            chunk = min(size, PageSize - virtAddr % PageSize);
+            if (Touch(virtAddr, &physAddr, 1) != NoException)
+                {
+                    return FALSE;
+                }
+            executable->ReadAt(&(kernel->machine->mainMemory[physAddr]),
+                               chunk, inFileAddr);
+            virtAddr += chunk;
+            inFileAddr += chunk;
+            size -= chunk;
+        }
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::Execute
 // 	Run a user program using the current thread
@@ -191,10 +281,15 @@ void
 AddrSpace::Execute(char* fileName)
 {
 
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
     kernel->currentThread->space = this;
+    kernel->scheduler->LoadUserState(kernel->currentThread);
+    // take over this CPU's registers
+    // and load page table register
+    (void) kernel->interrupt->SetLevel(oldLevel);
 
     this->InitRegisters();		// set the initial register values
-    this->RestoreState();		// load page table register
 
     kernel->machine->Run();		// jump to the user progam
 
@@ -233,11 +328,11 @@ AddrSpace::InitRegisters()
     // after start will be at virtual address four.
     machine->WriteRegister(NextPCReg, 4);
 
-    // Set the stack register to the end of the address space, where we
-    // allocated the stack; but subtract off a bit, to make sure we don't
+    // Set the stack register to the end of the address space, where
+    // the stack grows from; but subtract off a bit, to make sure we don't
     // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG(dbgAddr, "Initializing stack pointer: " << numPages * PageSize - 16);
+    machine->WriteRegister(StackReg, tableSize * PageSize - 16);
+    DEBUG(dbgAddr, "Initializing stack pointer: " << tableSize * PageSize - 16);
 }
 
 //----------------------------------------------------------------------
@@ -256,13 +351,18 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, if it
+//	is not already using it.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState()
 {
-    kernel->machine->pageTable = pageTable;
-    kernel->machine->pageTableSize = numPages;
+    if (kernel->machine->pageTable != pageTable)
+        {
+            kernel->machine->pageTable = pageTable;
+            kernel->machine->pageTableSize = tableSize;
+            kernel->stats->numPageTableLoads++;
+        }
 }
 
 
@@ -282,13 +382,18 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     unsigned int      vpn    = vaddr / PageSize;
     unsigned int      offset = vaddr % PageSize;
 
-    if(vpn >= numPages)
+    if(vpn >= tableSize)
         {
             return AddressErrorException;
         }
 
     pte = &pageTable[vpn];
 
+    if(!pte->valid)
+        {
+            return PageFaultException;
+        }
+
     if(isReadWrite && pte->readOnly)
         {
             return ReadOnlyException;
@@ -311,7 +416,7 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     *paddr = pfn*PageSize + offset;
 
-    ASSERT((*paddr < MemorySize));
+    ASSERT((*paddr < (unsigned int) MemorySize));
 
     //cerr << " -- AddrSpace::Translate(): vaddr: " << vaddr <<
     //  ", paddr: " << *paddr << "\n";
@@ -322,3 +427,292 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
 
 
+
+//----------------------------------------------------------------------
+// AddrSpace::Touch
+// 	Translate "vaddr" as Translate does, but if its page is one that
+//	gets a frame on first use, give it one first.  The kernel uses
+//	this for the user memory it reads and writes itself, which the
+//	machine never faults on.
+//----------------------------------------------------------------------
+
+ExceptionType
+AddrSpace::Touch(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
+{
+    ExceptionType exception = Translate(vaddr, paddr, isReadWrite);
+
+    if ((exception == PageFaultException) && PageFault(vaddr))
+        {
+            exception = Translate(vaddr, paddr, isReadWrite);
+        }
+    return exception;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::GuardPage
+// 	Return the page just above the heap and the shared memory
+//	segments.  It is never mapped; the stack may grow down to the
+//	page above it.
+//----------------------------------------------------------------------
+
+unsigned int
+AddrSpace::GuardPage()
+{
+    unsigned int guard = divRoundUp(brk, PageSize);
+
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            if ((shmPages[i] >= 0)
+                    && ((unsigned int) (shmPages[i] + shmCount[i]) > guard))
+                guard = shmPages[i] + shmCount[i];
+        }
+    return guard;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Give the page holding "virtAddr" a zeroed frame, if it is part
+//	of the uninitialized data or the heap (below the break), or of
+//	the stack, which grows on demand down to just above the guard
+//	page.  Return FALSE if it is none of these, or if memory is full.
+//
+//	"virtAddr" -- the address that faulted
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::PageFault(int virtAddr)
+{
+    unsigned int vpn = (unsigned int) virtAddr / PageSize;
+    int frame;
+
+    if ((vpn >= tableSize) || pageTable[vpn].valid
+            || (((unsigned int) virtAddr >= brk) && (vpn <= GuardPage())))
+        {
+            return FALSE;
+        }
+    frame = kernel->frameTable->Allocate();
+    if (frame < 0)
+        {
+            return FALSE;
+        }
+    if (vpn < stackBottom && (unsigned int) virtAddr >= brk)
+        {
+            stackBottom = vpn;		// the stack grew
+        }
+    pageTable[vpn].physicalPage = frame;
+    pageTable[vpn].valid = TRUE;
+    pageTable[vpn].use = FALSE;
+    pageTable[vpn].dirty = FALSE;
+    kernel->stats->numPageFaults++;
+    DEBUG(dbgAddr, "Page fault at " << virtAddr << ": page " << vpn << " in frame " << frame);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Sbrk
+// 	Move the end of the heap by "increment" bytes, as in UNIX.  The
+//	pages it grows by get frames when they are first touched; those
+//	it shrinks by give theirs back, and the rest of the last page
+//	kept is cleared, so that growing again finds zeroes.  Return the
+//	old end of the heap, or -1 if the new end would be below the
+//	start of the heap, or in a shared memory segment, or would leave
+//	no guard page below the stack.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Sbrk(int increment)
+{
+    unsigned int old = brk;
+    int newBrk = (int) brk + increment;
+    unsigned int firstFree = divRoundUp(brk, PageSize);
+    unsigned int lastUsed;
+
+    if ((newBrk < (int) heapStart) || ((unsigned int) divRoundUp(newBrk, PageSize) >= stackBottom))
+        {
+            return -1;
+        }
+    lastUsed = divRoundUp(newBrk, PageSize);
+    for (unsigned int i = firstFree; i < lastUsed; i++)
+        {
+            if (pageTable[i].valid)		// shared memory
+                return -1;
+        }
+    for (unsigned int i = lastUsed; i < firstFree; i++)
+        {
+            if (pageTable[i].valid)
+                {
+                    kernel->frameTable->Free(pageTable[i].physicalPage);
+                    pageTable[i].valid = FALSE;
+                }
+        }
+    if (((unsigned int) newBrk < brk) && (newBrk % PageSize != 0)
+            && pageTable[newBrk / PageSize].valid)
+        {
+            bzero(&(kernel->machine->mainMemory[pageTable[newBrk / PageSize].physicalPage
+                                                  * PageSize + newBrk % PageSize]),
+                  min((int) brk, (newBrk / PageSize + 1) * PageSize) - newBrk);
+        }
+    brk = newBrk;
+    DEBUG(dbgAddr, "Break moved from " << old << " to " << brk);
+    return old;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn
+// 	Copy "size" bytes at "virtAddr" in user memory into the kernel
+//	buffer "into", page by page.  Return FALSE if part of the range
+//	is not mapped.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyIn(int virtAddr, char *into, int size)
+{
+    unsigned int physAddr;
+    int chunk;
+
+    while (size > 0)
+        {
+            chunk = min(size, PageSize - virtAddr % PageSize);
+            if ((virtAddr < 0) || (Touch(virtAddr, &physAddr, 0) != NoException))
+                {
+                    return FALSE;
+                }
+            bcopy(&(kernel->machine->mainMemory[physAddr]), into, chunk);
+            virtAddr += chunk;
+            into += chunk;
+            size -= chunk;
+        }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOut
+// 	Copy "size" bytes from the kernel buffer "from" to "virtAddr"
+//	in user memory.  Return FALSE if part of the range is not mapped
+//	or is read-only.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOut(int virtAddr, char *from, int size)
+{
+    unsigned int physAddr;
+    int chunk;
+
+    while (size > 0)
+        {
+            chunk = min(size, PageSize - virtAddr % PageSize);
+            if ((virtAddr < 0) || (Touch(virtAddr, &physAddr, 1) != NoException))
+                {
+                    return FALSE;
+                }
+            bcopy(from, &(kernel->machine->mainMemory[physAddr]), chunk);
+            virtAddr += chunk;
+            from += chunk;
+            size -= chunk;
+        }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+// 	Copy the null-terminated string at "virtAddr" in user memory
+//	into a new kernel buffer, and return it.  Return NULL if the
+//	string runs into an unmapped page.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::CopyInString(int virtAddr)
+{
+    unsigned int physAddr;
+    int length = 0, size = 64;
+    char *string = new char[size], *bigger;
+
+    for (;;)
+        {
+            if ((virtAddr < 0)
+                    || (Touch(virtAddr + length, &physAddr, 0) != NoException))
+                {
+                    delete [] string;
+                    return NULL;
+                }
+            if (length == size)
+                {
+                    bigger = new char[2 * size];
+                    bcopy(string, bigger, size);
+                    delete [] string;
+                    string = bigger;
+                    size *= 2;
+                }
+            string[length] = kernel->machine->mainMemory[physAddr];
+            if (string[length] == '\0')
+                return string;
+            length++;
+        }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapShared
+// 	Map the frames of shared memory segment "id" onto the pages
+//	starting at "virtAddr".  The pages must lie between the heap and
+//	the stack, leaving a guard page below the stack, and not be
+//	mapped yet.  Return FALSE if the segment is
+//	mapped here already, "virtAddr" is not page aligned, or the pages
+//	are taken.
+//
+//	"id" -- the segment
+//	"virtAddr" -- where to map it
+//	"numPages" -- pages in the segment
+//	"frames" -- the frame behind each of them
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::MapShared(int id, int virtAddr, int numPages, int *frames)
+{
+    int first = virtAddr / PageSize;
+
+    if ((shmPages[id] >= 0) || (virtAddr % PageSize != 0)
+            || (first < (int) divRoundUp(brk, PageSize))
+            || (first + numPages >= (int) stackBottom))
+        {
+            return FALSE;
+        }
+    for (int i = first; i < first + numPages; i++)
+        {
+            if (pageTable[i].valid)
+                return FALSE;
+        }
+
+    for (int i = 0; i < numPages; i++)
+        {
+            pageTable[first + i].physicalPage = frames[i];
+            pageTable[first + i].valid = TRUE;
+            pageTable[first + i].use = FALSE;
+            pageTable[first + i].dirty = FALSE;
+            pageTable[first + i].readOnly = FALSE;
+        }
+    shmPages[id] = first;
+    shmCount[id] = numPages;
+    DEBUG(dbgAddr, "Mapped shared memory segment " << id << " at page " << first);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::UnmapShared
+// 	Unmap shared memory segment "id".  Return FALSE if it is not
+//	mapped here.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::UnmapShared(int id)
+{
+    int first = shmPages[id];
+
+    if (first < 0)
+        {
+            return FALSE;
+        }
+    for (int i = first; i < first + shmCount[id]; i++)
+        pageTable[i].valid = FALSE;
+    shmPages[id] = -1;
+    return TRUE;
+}
@@ -2,7 +2,19 @@
 //	Data structures to keep track of executing user programs
 //	(address spaces).
 //
-//	For now, we don't keep any information about address spaces.
+//	Each address space has its own page table, and its pages are
+//	backed by frames taken from the kernel's frame table, so that
+//	several programs can be in memory at once.
+//
+//	The program's code and data are at the bottom, followed by its
+//	uninitialized data and its heap, which Sbrk grows; the stack is
+//	at the top, and grows down as far as it is touched, until it
+//	comes to the guard page just above the heap and any shared
+//	memory segments (shm.h), which are mapped between the two.  Pages
+//	of the uninitialized data, the heap and the stack get a zeroed
+//	frame only when first touched (PageFault), so a program pays only
+//	for the memory it uses.
+//
 //	The user level CPU state is saved and restored in the thread
 //	executing the user program (see thread.h).
 //
@@ -15,8 +27,9 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "shm.h"
 
-#define UserStackSize		1024 	// increase this as necessary!
+#define MaxVirtPages		1024	// largest address space, in pages
 
 class AddrSpace
 {
@@ -39,15 +52,47 @@ public:
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
+    ExceptionType Touch(unsigned int vaddr, unsigned int *paddr, int mode);
+    // Translate, giving the page a frame
+    // first if it has none yet
+
+    bool PageFault(int virtAddr);	// Give the page at "virtAddr" a zeroed
+    // frame, if it is in the data, heap or
+    // stack; FALSE if it is not
+    int Sbrk(int increment);		// Move the end of the heap; return the
+    // old end, or -1
+
+    bool CopyIn(int virtAddr, char *into, int size);
+    bool CopyOut(int virtAddr, char *from, int size);
+    // Copy between user memory and the
+    // kernel, for system calls; FALSE if
+    // an address is not mapped
+    char *CopyInString(int virtAddr);	// Copy in a string, or return NULL;
+    // the caller deletes it
+
+    bool MapShared(int id, int virtAddr, int numPages, int *frames);
+    // Map shared memory segment "id" onto
+    // free pages at "virtAddr"
+    bool UnmapShared(int id);		// Unmap it; FALSE if it was not mapped
 
 private:
-    TranslationEntry *pageTable;	// Assume linear page table translation
-    // for now!
-    unsigned int numPages;		// Number of pages in the virtual
-    // address space
+    TranslationEntry *pageTable;	// Linear page table, one entry per
+    // virtual page; unmapped pages are
+    // not valid
+    unsigned int tableSize;		// Entries in pageTable
+    unsigned int heapStart;		// First address after the program
+    unsigned int brk;			// and after its heap
+    unsigned int stackBottom;		// Lowest page the stack has grown to
+    int shmPages[MaxSegments];		// First page of each segment mapped
+    // here, or -1
+    int shmCount[MaxSegments];		// and how many pages it has
 
+    unsigned int GuardPage();		// Page the stack may not grow into
     void InitRegisters();		// Initialize user-level CPU registers,
     // before jumping to user code
+    bool LoadSegment(OpenFile *executable, int virtAddr, int size,
+                     int inFileAddr);	// read part of the program into
+    // its pages
 
 };
 
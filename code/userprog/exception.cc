@@ -58,6 +58,7 @@ ExceptionHandler(ExceptionType which)
     switch (which)
         {
         case SyscallException:
+            kernel->stats->numSyscalls++;
             switch(type)
                 {
                 case SC_Halt:
@@ -70,8 +71,10 @@ ExceptionHandler(ExceptionType which)
                     DEBUG(dbgSys, "Message received.\n");
                     val = kernel->machine->ReadRegister(4);
                     {
-                        char *msg = &(kernel->machine->mainMemory[val]);
-                        cout << msg << endl;
+                        char *msg = kernel->currentThread->space->CopyInString(val);
+                        if (msg != NULL)
+                            cout << msg << endl;
+                        delete [] msg;
                     }
                     SysHalt();
                     ASSERTNOTREACHED();
@@ -81,11 +84,12 @@ ExceptionHandler(ExceptionType which)
                     val = kernel->machine->ReadRegister(4);
                     val2 = kernel->machine->ReadRegister(5);
                     {
-                        char *filename = &(kernel->machine->mainMemory[val]);
+                        char *filename = kernel->currentThread->space->CopyInString(val);
                         int size = val2;
                         //cout << filename << endl;
-                        status = SysCreate(filename, size);
+                        status = (filename == NULL) ? -1 : SysCreate(filename, size);
                         kernel->machine->WriteRegister(2, (int) status);
+                        delete [] filename;
                     }
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                     kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -96,10 +100,11 @@ ExceptionHandler(ExceptionType which)
                 case SC_Open:
                     val = kernel->machine->ReadRegister(4);
                     {
-                        char *filename = &(kernel->machine->mainMemory[val]);
+                        char *filename = kernel->currentThread->space->CopyInString(val);
                         //cout << filename << endl;
-                        status = SysOpen(filename);
+                        status = (filename == NULL) ? -1 : SysOpen(filename);
                         kernel->machine->WriteRegister(2, (int) status);
+                        delete [] filename;
                     }
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                     kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -112,12 +117,16 @@ ExceptionHandler(ExceptionType which)
                     val2 = kernel->machine->ReadRegister(5); // size
                     val3 = kernel->machine->ReadRegister(6); // id
                     {
-                        char *buf = &(kernel->machine->mainMemory[val]);
                         int size = val2;
                         int id = val3;
+                        char *buf = new char[max(size, 1)];
                         //cout << filename << endl;
-                        status = SysRead(buf, size, id);
+                        status = (size < 0) ? -1 : SysRead(buf, size, id);
+                        if ((status > 0)
+                                && !kernel->currentThread->space->CopyOut(val, buf, status))
+                            status = -1;
                         kernel->machine->WriteRegister(2, (int) status);
+                        delete [] buf;
                     }
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                     kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -130,12 +139,17 @@ ExceptionHandler(ExceptionType which)
                     val2 = kernel->machine->ReadRegister(5); // size
                     val3 = kernel->machine->ReadRegister(6); // id
                     {
-                        char *buf = &(kernel->machine->mainMemory[val]);
                         int size = val2;
                         int id = val3;
+                        char *buf = new char[max(size, 1)];
                         //cout << filename << endl;
-                        status = SysWrite(buf, size, id);
+                        if ((size < 0)
+                                || !kernel->currentThread->space->CopyIn(val, buf, size))
+                            status = -1;
+                        else
+                            status = SysWrite(buf, size, id);
                         kernel->machine->WriteRegister(2, (int) status);
+                        delete [] buf;
                     }
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
                     kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
@@ -156,7 +170,156 @@ ExceptionHandler(ExceptionType which)
                     return;
                     ASSERTNOTREACHED();
                     break;
+                case SC_Clone:
+                    val = kernel->machine->ReadRegister(4);
+                    val2 = kernel->machine->ReadRegister(5);
+                    {
+                        char *from = kernel->currentThread->space->CopyInString(val);
+                        char *to = kernel->currentThread->space->CopyInString(val2);
+                        status = (from == NULL || to == NULL) ? -1 : SysClone(from, to);
+                        kernel->machine->WriteRegister(2, (int) status);
+                        delete [] from;
+                        delete [] to;
+                    }
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_Remove:
+                    val = kernel->machine->ReadRegister(4);
+                    {
+                        char *filename = kernel->currentThread->space->CopyInString(val);
+                        status = (filename == NULL) ? -1 : SysRemove(filename);
+                        kernel->machine->WriteRegister(2, (int) status);
+                        delete [] filename;
+                    }
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_Seek:
+                    val = kernel->machine->ReadRegister(4); // position
+                    val2 = kernel->machine->ReadRegister(5); // id
+                    status = SysSeek(val, val2);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_Pipe:
+                    val = kernel->machine->ReadRegister(4); // fds
+                    {
+                        OpenFileId fds[2];
+                        status = SysPipe(&fds[0], &fds[1]);
+                        if (status == 1)
+                            {
+                                fds[0] = WordToMachine(fds[0]);
+                                fds[1] = WordToMachine(fds[1]);
+                                if (!kernel->currentThread->space->CopyOut(val, (char *) fds, sizeof(fds)))
+                                    {
+                                        SysClose(WordToHost(fds[0]));
+                                        SysClose(WordToHost(fds[1]));
+                                        status = -1;
+                                    }
+                            }
+                        kernel->machine->WriteRegister(2, (int) status);
+                    }
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
 #endif
+                case SC_ShmCreate:
+                    val = kernel->machine->ReadRegister(4); // key
+                    val2 = kernel->machine->ReadRegister(5); // size
+                    status = SysShmCreate(val, val2);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_ShmAttach:
+                    val = kernel->machine->ReadRegister(4); // id
+                    val2 = kernel->machine->ReadRegister(5); // addr
+                    status = SysShmAttach(val, val2);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_ShmDetach:
+                    val = kernel->machine->ReadRegister(4); // id
+                    status = SysShmDetach(val);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_FutexWait:
+                    val = kernel->machine->ReadRegister(4); // addr
+                    val2 = kernel->machine->ReadRegister(5); // expected
+                    status = SysFutexWait(val, val2);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_FutexWake:
+                    val = kernel->machine->ReadRegister(4); // addr
+                    val2 = kernel->machine->ReadRegister(5); // count
+                    status = SysFutexWake(val, val2);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_Sbrk:
+                    val = kernel->machine->ReadRegister(4); // increment
+                    status = SysSbrk(val);
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_RealTime:
+                    status = SysRealTime((int) kernel->machine->ReadRegister(4),
+                                         (int) kernel->machine->ReadRegister(5),
+                                         (int) kernel->machine->ReadRegister(6));
+                    kernel->machine->WriteRegister(2, (int) status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_NextPeriod:
+                    SysNextPeriod();
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
                 case SC_Add:
                     DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
                     /* Process SysAdd Systemcall*/
@@ -192,6 +355,16 @@ ExceptionHandler(ExceptionType which)
                     break;
                 }
             break;
+        case PageFaultException:
+            // the uninitialized data, the heap and the stack get their
+            // pages when first touched; the instruction then runs again
+            val = kernel->machine->ReadRegister(BadVAddrReg);
+            if (!kernel->currentThread->space->PageFault(val))
+                {
+                    cerr << "Bad address " << val << ", or out of memory\n";
+                    kernel->currentThread->Finish();
+                }
+            return;
         default:
             cerr << "Unexpected user mode exception " << (int)which << "\n";
             break;
@@ -0,0 +1,58 @@
+// frametable.cc
+//	Routines to allocate the frames of physical memory.  See
+//	frametable.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table, with every frame free.
+//
+//	"numFrames" -- the frames of physical memory
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable(int numFrames)
+{
+    used = new Bitmap(numFrames);
+}
+
+FrameTable::~FrameTable()
+{
+    delete used;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Allocate
+// 	Take a free frame and zero it.  Return -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+FrameTable::Allocate()
+{
+    int frame = used->FindAndSet();
+
+    if (frame >= 0)
+        {
+            bzero(&kernel->machine->mainMemory[frame * PageSize], PageSize);
+        }
+    DEBUG(dbgAddr, "Allocated frame " << frame);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	Return "frame" to the free pool.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Free(int frame)
+{
+    ASSERT(used->Test(frame));
+    used->Clear(frame);
+}
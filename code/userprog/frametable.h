@@ -0,0 +1,40 @@
+// frametable.h
+//	Data structures to keep track of the frames (pages) of physical
+//	memory.
+//
+//	Each address space asks for the frames it needs, one per page,
+//	so that several programs can be in memory at once; shared
+//	memory segments (shm.h) get theirs the same way.  A frame is
+//	handed out zeroed, so that one program never sees what another
+//	left behind.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+class FrameTable
+{
+public:
+    FrameTable(int numFrames);		// All "numFrames" frames are free
+    ~FrameTable();
+
+    int Allocate();			// Return a free frame, zeroed, or
+    // -1 if memory is full
+    void Free(int frame);		// Return a frame to the free pool
+
+    int NumFree()
+    {
+        return used->NumClear();
+    }
+
+private:
+    Bitmap *used;			// frames in use
+};
+
+#endif // FRAMETABLE_H
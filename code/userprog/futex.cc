@@ -0,0 +1,126 @@
+// futex.cc
+//	Routines to wait on words of user memory.  See futex.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "futex.h"
+#include "main.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize the table of futex waiters, with no one waiting.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+        buckets[i] = new List<FutexWaiter *>;
+}
+
+FutexTable::~FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+        delete buckets[i];
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Lookup
+// 	Find the physical address of the word at "virtAddr" in "space".
+//	Return FALSE if it is not word aligned, or not mapped.
+//----------------------------------------------------------------------
+
+bool
+FutexTable::Lookup(AddrSpace *space, int virtAddr, unsigned int *physAddr)
+{
+    if ((virtAddr < 0) || (virtAddr & 0x3))
+        {
+            return FALSE;
+        }
+    return space->Touch(virtAddr, physAddr, 0) == NoException;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep until a FutexWake on the word
+//	at "virtAddr", if the word holds "expected".  Interrupts are off
+//	from the check to the sleep, so no wakeup can slip in between.
+//	Return 1 once woken, 0 if the word did not hold "expected", and
+//	-1 if "virtAddr" is not a word of "space".
+//
+//	"space" -- the address space of the caller
+//	"virtAddr" -- the futex
+//	"expected" -- what the caller last saw in it
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(AddrSpace *space, int virtAddr, int expected)
+{
+    FutexWaiter waiter;
+    IntStatus oldLevel;
+    int value;
+
+    if (!Lookup(space, virtAddr, &waiter.physAddr))
+        {
+            return -1;
+        }
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    value = WordToHost(*(unsigned int *) &kernel->machine->mainMemory[waiter.physAddr]);
+    if (value != expected)
+        {
+            (void) kernel->interrupt->SetLevel(oldLevel);
+            return 0;
+        }
+    waiter.thread = kernel->currentThread;
+    Bucket(waiter.physAddr)->Append(&waiter);
+    DEBUG(dbgSys, "Futex wait at " << waiter.physAddr);
+    kernel->currentThread->Sleep(FALSE);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return 1;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" threads sleeping on the word at "virtAddr",
+//	in the order they went to sleep.  Return how many were woken, or
+//	-1 if "virtAddr" is not a word of "space".
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(AddrSpace *space, int virtAddr, int count)
+{
+    List<FutexWaiter *> *bucket;
+    FutexWaiter *waiter;
+    unsigned int physAddr;
+    IntStatus oldLevel;
+    int woken = 0, n;
+
+    if (!Lookup(space, virtAddr, &physAddr))
+        {
+            return -1;
+        }
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    bucket = Bucket(physAddr);
+
+    // go once around the bucket, keeping the others in order
+    n = bucket->NumInList();
+    for (int i = 0; i < n; i++)
+        {
+            waiter = bucket->RemoveFront();
+            if ((waiter->physAddr == physAddr) && (woken < count))
+                {
+                    kernel->scheduler->ReadyToRun(waiter->thread);
+                    woken++;
+                }
+            else
+                {
+                    bucket->Append(waiter);
+                }
+        }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    DEBUG(dbgSys, "Futex wake at " << physAddr << ": " << woken);
+    return woken;
+}
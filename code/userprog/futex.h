@@ -0,0 +1,63 @@
+// futex.h
+//	Data structures for futexes: waiting in the kernel on a word of
+//	user memory.
+//
+//	User programs build locks, condition variables and barriers out
+//	of atomic operations on words they share (LL/SC, see test/usync.h),
+//	and call the kernel only to sleep when there is contention:
+//	FutexWait(addr, expected) sleeps if the word at "addr" still holds
+//	"expected", and FutexWake(addr, n) wakes up to "n" threads sleeping
+//	on it.  The check and the sleep are atomic with respect to
+//	FutexWake, so a wakeup between them cannot be lost.
+//
+//	Waiters are kept in a hash table keyed by the physical address of
+//	the word, so programs that share it through a shared memory
+//	segment (shm.h) find each other's waiters wherever they map it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "list.h"
+
+class Thread;
+class AddrSpace;
+
+const int FutexBuckets = 64;		// size of the hash table
+
+// A thread sleeping on a futex.
+class FutexWaiter
+{
+public:
+    Thread *thread;
+    unsigned int physAddr;		// the word it waits on
+};
+
+class FutexTable
+{
+public:
+    FutexTable();			// No one waiting
+    ~FutexTable();
+
+    int Wait(AddrSpace *space, int virtAddr, int expected);
+    // Sleep if the word at "virtAddr"
+    // holds "expected"
+    int Wake(AddrSpace *space, int virtAddr, int count);
+    // Wake up to "count" sleepers on it
+
+private:
+    List<FutexWaiter *> *buckets[FutexBuckets];
+
+    bool Lookup(AddrSpace *space, int virtAddr, unsigned int *physAddr);
+    // Translate the address of a futex
+    List<FutexWaiter *> *Bucket(unsigned int physAddr)
+    {
+        return buckets[(physAddr >> 2) % FutexBuckets];
+    }
+};
+
+#endif // FUTEX_H
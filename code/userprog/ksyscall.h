@@ -15,6 +15,7 @@
 
 #include "synchconsole.h"
 #include "syscall.h"
+#include "futex.h"
 
 void SysHalt()
 {
@@ -60,6 +61,96 @@ int SysClose(OpenFileId id)
     return kernel->interrupt->IntCloseFile(id);
 }
 
+int SysClone(char *from, char *to)
+{
+    // 1: success
+    // 0: failed
+    return kernel->interrupt->IntCloneFile(from, to);
+}
+
+int SysRemove(char *filename)
+{
+    // 1: success
+    // 0: failed
+    return kernel->interrupt->IntRemoveFile(filename);
+}
+
+int SysSeek(int position, OpenFileId id)
+{
+    // 1: success
+    // -1: failed
+    return kernel->interrupt->IntSeekFile(position, id);
+}
+
+int SysPipe(OpenFileId *readId, OpenFileId *writeId)
+{
+    // 1: success
+    // -1: failed
+    return kernel->interrupt->IntPipe(readId, writeId);
+}
+
 #endif
 
+int SysShmCreate(int key, int size)
+{
+    // >= 0: the segment id
+    // -1: failed
+    return kernel->sharedMemory->Create(key, size, kernel->currentThread->space);
+}
+
+int SysShmAttach(int id, int addr)
+{
+    // 1: success
+    // -1: failed
+    if (!kernel->sharedMemory->Attach(id, kernel->currentThread->space, addr))
+        return -1;
+    return 1;
+}
+
+int SysShmDetach(int id)
+{
+    // 1: success
+    // -1: failed
+    if (!kernel->sharedMemory->Detach(id, kernel->currentThread->space))
+        return -1;
+    return 1;
+}
+
+int SysFutexWait(int addr, int expected)
+{
+    // 1: woken
+    // 0: the word did not hold "expected"
+    // -1: failed
+    return kernel->futexTable->Wait(kernel->currentThread->space, addr, expected);
+}
+
+int SysFutexWake(int addr, int count)
+{
+    // >= 0: threads woken
+    // -1: failed
+    return kernel->futexTable->Wake(kernel->currentThread->space, addr, count);
+}
+
+int SysSbrk(int increment)
+{
+    // the old end of the heap
+    // -1: failed
+    return kernel->currentThread->space->Sbrk(increment);
+}
+
+int SysRealTime(int period, int budget, int deadline)
+{
+    // 0: admitted
+    // -1: refused
+    if (!kernel->scheduler->SetRealTime(kernel->currentThread, period,
+                                        budget, deadline))
+        return -1;
+    return 0;
+}
+
+void SysNextPeriod()
+{
+    kernel->scheduler->NextPeriod();
+}
+
 #endif /* ! __USERPROG_KSYSCALL_H__ */
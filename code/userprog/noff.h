@@ -8,6 +8,15 @@
 #define NOFFMAGIC	0xbadfad 	/* magic number denoting Nachos 
 					 * object code file 
 					 */
+#define NOFFALIGNED	0x40000000	/* or'ed into the magic number when
+					 * every segment starts at a file
+					 * offset equal to its virtual address
+					 * modulo NOFFALIGNMENT, so whole pages
+					 * are whole sectors of the file
+					 */
+#define NOFFALIGNMENT	4096		/* a multiple of the sector size,
+					 * and of any page size up to it
+					 */
 
 typedef struct segment
 {
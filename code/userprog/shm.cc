@@ -0,0 +1,174 @@
+// shm.cc
+//	Routines to create shared memory segments and map them into
+//	address spaces.  See shm.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "shm.h"
+#include "main.h"
+#include "addrspace.h"
+#include "frametable.h"
+
+//----------------------------------------------------------------------
+// SharedMemory::SharedMemory
+//----------------------------------------------------------------------
+
+SharedMemory::SharedMemory()
+{
+    for (int i = 0; i < MaxSegments; i++)
+        segments[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::~SharedMemory
+// 	Free the segments that are left.
+//----------------------------------------------------------------------
+
+SharedMemory::~SharedMemory()
+{
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            if (segments[i] != NULL)
+                Destroy(i);
+        }
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Create
+// 	Return the id of the segment called "key".  If there is none,
+//	make one of "size" bytes, rounded up to whole pages, zeroed.
+//
+//	Return -1 if a new segment is needed and there is no room for
+//	it, in the table or in memory.
+//
+//	"key" -- the name programs agree on
+//	"size" -- bytes in the segment, if it is new
+//	"space" -- the address space asking for it
+//----------------------------------------------------------------------
+
+int
+SharedMemory::Create(int key, int size, AddrSpace *space)
+{
+    ShmSegment *segment;
+    int id = -1;
+
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            if ((segments[i] != NULL) && (segments[i]->key == key))
+                return i;
+            if ((segments[i] == NULL) && (id < 0))
+                id = i;
+        }
+    if ((id < 0) || (size <= 0)
+            || (divRoundUp(size, PageSize) > kernel->frameTable->NumFree()))
+        {
+            return -1;
+        }
+
+    segment = new ShmSegment;
+    segment->key = key;
+    segment->numPages = divRoundUp(size, PageSize);
+    segment->frames = new int[segment->numPages];
+    for (int i = 0; i < segment->numPages; i++)
+        segment->frames[i] = kernel->frameTable->Allocate();
+    segment->numAttached = 0;
+    segment->creator = space;
+    segments[id] = segment;
+    DEBUG(dbgAddr, "Shared memory segment " << id << ", key " << key
+          << ": " << segment->numPages << " pages");
+    return id;
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Attach
+// 	Map segment "id" into "space", starting at "virtAddr".  Return
+//	FALSE if there is no such segment, it is already mapped there,
+//	or the pages at "virtAddr" are not free (see AddrSpace::MapShared).
+//
+//	"id" -- the segment
+//	"space" -- the address space to map it into
+//	"virtAddr" -- where, page aligned
+//----------------------------------------------------------------------
+
+bool
+SharedMemory::Attach(int id, AddrSpace *space, int virtAddr)
+{
+    ShmSegment *segment;
+
+    if ((id < 0) || (id >= MaxSegments) || (segments[id] == NULL))
+        {
+            return FALSE;
+        }
+    segment = segments[id];
+    if (!space->MapShared(id, virtAddr, segment->numPages, segment->frames))
+        {
+            return FALSE;
+        }
+    segment->numAttached++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Detach
+// 	Unmap segment "id" from "space".  The segment goes away when no
+//	address space maps it any more, unless its creator is still
+//	running and may attach it again.  Return FALSE if it was not
+//	mapped there.
+//----------------------------------------------------------------------
+
+bool
+SharedMemory::Detach(int id, AddrSpace *space)
+{
+    if ((id < 0) || (id >= MaxSegments) || (segments[id] == NULL)
+            || !space->UnmapShared(id))
+        {
+            return FALSE;
+        }
+    if ((--segments[id]->numAttached == 0)
+            && (segments[id]->creator == NULL))
+        {
+            Destroy(id);
+        }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Exited
+// 	Called when "space" is deleted, after it has detached everything.
+//	Free the segments it created that nobody maps; the others go
+//	when their last address space detaches them.
+//----------------------------------------------------------------------
+
+void
+SharedMemory::Exited(AddrSpace *space)
+{
+    for (int i = 0; i < MaxSegments; i++)
+        {
+            if ((segments[i] == NULL) || (segments[i]->creator != space))
+                continue;
+            segments[i]->creator = NULL;
+            if (segments[i]->numAttached == 0)
+                Destroy(i);
+        }
+}
+
+//----------------------------------------------------------------------
+// SharedMemory::Destroy
+// 	Free segment "id" and its frames.
+//----------------------------------------------------------------------
+
+void
+SharedMemory::Destroy(int id)
+{
+    ShmSegment *segment = segments[id];
+
+    DEBUG(dbgAddr, "Freeing shared memory segment " << id);
+    for (int i = 0; i < segment->numPages; i++)
+        kernel->frameTable->Free(segment->frames[i]);
+    delete [] segment->frames;
+    delete segment;
+    segments[id] = NULL;
+}
@@ -0,0 +1,66 @@
+// shm.h
+//	Data structures for shared memory segments.
+//
+//	A segment is a set of frames of physical memory that several
+//	address spaces map at once, each at a virtual address of its
+//	choosing, so that user programs can exchange data without
+//	copying it through the kernel or the disk.  Programs agree on a
+//	segment by a "key": ShmCreate makes the segment with that key,
+//	or finds the one that exists, and returns its id for ShmAttach
+//	and ShmDetach.
+//
+//	A segment counts the address spaces it is mapped into, and
+//	remembers the one that created it.  Once the creator has exited
+//	and the last address space detaches it, or exits, the frames are
+//	freed; a segment that is not attached when its creator exits is
+//	freed then.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SHM_H
+#define SHM_H
+
+#include "copyright.h"
+
+class AddrSpace;
+
+const int MaxSegments = 16;		// segments that may exist at once
+
+// One shared memory segment.
+class ShmSegment
+{
+public:
+    int key;				// what programs call it
+    int numPages;
+    int *frames;			// the frame backing each page
+    int numAttached;			// address spaces mapping it
+    AddrSpace *creator;			// who made it; NULL once it exits
+};
+
+class SharedMemory
+{
+public:
+    SharedMemory();			// No segments yet
+    ~SharedMemory();
+
+    int Create(int key, int size, AddrSpace *space);
+    // Return the id of segment "key",
+    // making one of "size" bytes for
+    // "space" if there is none; -1 if
+    // that fails
+    bool Attach(int id, AddrSpace *space, int virtAddr);
+    // Map segment "id" at "virtAddr"
+    bool Detach(int id, AddrSpace *space);
+    // Unmap it again
+    void Exited(AddrSpace *space);	// "space" is going away; free the
+    // unattached segments it created
+
+private:
+    ShmSegment *segments[MaxSegments];	// by id; NULL if unused
+
+    void Destroy(int id);		// free a segment and its frames
+};
+
+#endif // SHM_H
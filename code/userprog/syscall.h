@@ -34,6 +34,16 @@
 #define SC_ExecV	13
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
+#define SC_Clone	16
+#define SC_ShmCreate	17
+#define SC_ShmAttach	18
+#define SC_ShmDetach	19
+#define SC_Pipe		20
+#define SC_FutexWait	21
+#define SC_FutexWake	22
+#define SC_Sbrk		23
+#define SC_RealTime	24
+#define SC_NextPeriod	25
 #define SC_Add		42
 #define SC_MSG		100
 
@@ -119,6 +129,12 @@ int Create(char *name, int size);
 /* Remove a Nachos file, with name "name" */
 int Remove(char *name);
 
+/* Create the Nachos file "to" as a copy of the file "from".  The two
+ * share their data on disk until either of them is written.
+ * Return 1 on success, 0 on failure.
+ */
+int Clone(char *from, char *to);
+
 /* Open the Nachos file "name", and return an "OpenFileId" that can
  * be used to read and write to the file.
  */
@@ -143,12 +159,65 @@ int Read(char *buffer, int size, OpenFileId id);
  */
 int Seek(int position, OpenFileId id);
 
+/* Make a pipe: a byte stream in the kernel.  Put a descriptor for its
+ * read end in fds[0], and one for its write end in fds[1]; Read, Write
+ * and Close work on them as on files.  Reading an empty pipe waits
+ * for data, and returns 0 once the write end is closed.
+ * Return 1 on success, negative error code on failure.
+ */
+int Pipe(OpenFileId fds[2]);
+
 /* Close the file, we're done reading and writing to it.
  * Return 1 on success, negative error code on failure
  */
 int Close(OpenFileId id);
 
 
+/* Shared memory segments, mapped into several address spaces at once.
+ * ShmCreate returns the id of the segment called "key", creating one
+ * of "size" bytes if there is none; a negative error code on failure.
+ */
+int ShmCreate(int key, int size);
+
+/* Map segment "id" at "addr", which must be page aligned and above the
+ * program and its stack.  Return 1 on success, negative error code on
+ * failure.
+ */
+int ShmAttach(int id, char *addr);
+
+/* Unmap segment "id".  It goes away once no program maps it and the
+ * program that created it has exited.  Return 1 on success, negative
+ * error code on failure.
+ */
+int ShmDetach(int id);
+
+
+/* Move the end of the heap, just above the program's data, by
+ * "increment" bytes, and return the old end; (void *) -1 on failure.
+ * The new pages read as zero, and take memory only once touched.
+ */
+void *Sbrk(int increment);
+
+/* Futexes: sleep in the kernel on a word of user memory, for building
+ * locks without spinning (see test/usync.h).  FutexWait sleeps only if
+ * the word at "addr" still holds "expected"; it returns 1 once woken by
+ * FutexWake, and 0 at once if the word had changed.  FutexWake wakes up
+ * to "count" threads sleeping on "addr", and returns how many it woke.
+ * Both return a negative error code if "addr" is not a mapped word.
+ */
+int FutexWait(int *addr, int expected);
+int FutexWake(int *addr, int count);
+
+/* Real-time threads: RealTime makes the caller periodic, released
+ * every "period" ticks to do a job of at most "budget" ticks, due
+ * "deadline" ticks after its release; it returns 0, or -1 if the
+ * kernel cannot guarantee that along with its other real-time threads.
+ * NextPeriod ends the current job and waits for the next release.
+ */
+int RealTime(int period, int budget, int deadline);
+void NextPeriod();
+
+
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program.
  *
@@ -10,6 +10,11 @@
  * 	ld with  -N -T 0
  * to make sure the object file has no shared text.
  *
+ * With -a, each segment is written at a file offset equal to its
+ * virtual address modulo NOFFALIGNMENT (the gaps are left as holes),
+ * and NOFFALIGNED is set in the magic number, so that Nachos can read
+ * whole pages of the program as whole sectors of the file.
+ *
  * Also assumes that the COFF file has at most 3 segments:
  *	.text	-- read-only executable instructions 
  *	.data	-- initialized data
@@ -127,6 +132,7 @@ SwapHeader (NoffHeader *noffH)
 #define ReadStruct(f,s) 	Read(f,(char *)&s,sizeof(s))
 
 char *noffFileName = NULL;
+int aligned = 0;		/* -a: write the aligned layout */
 
 /* read and check for error */
 void Read(int fd, char *buf, int nBytes)
@@ -148,6 +154,19 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* with the aligned layout, move the output on to the first offset
+ * from "inNoffFile" that is "virtualAddr" modulo NOFFALIGNMENT;
+ * return where the segment goes */
+int AlignSegment(int fd, int inNoffFile, int virtualAddr)
+{
+    if (aligned) {
+	inNoffFile += ((virtualAddr - inNoffFile) % NOFFALIGNMENT
+			+ NOFFALIGNMENT) % NOFFALIGNMENT;
+	lseek(fd, inNoffFile, 0);
+    }
+    return inNoffFile;
+}
+
 int main(int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -157,8 +176,14 @@ int main(int argc, char **argv)
     char *buffer;
     NoffHeader noffH;
 
-    if (argc < 2) {
-	fprintf(stderr, "Usage: %s <coffFileName> <noffFileName>\n", argv[0]);
+    if (argc > 1 && !strcmp(argv[1], "-a")) {
+	aligned = 1;
+	argc--;
+	argv++;
+    }
+    if (argc < 3) {
+	fprintf(stderr, "Usage: %s [-a] <coffFileName> <noffFileName>\n",
+		argv[0]);
 	exit(1);
     }
     
@@ -211,7 +236,7 @@ int main(int argc, char **argv)
  /* initialize the NOFF header, in case not all the segments are defined
   * in the COFF file
   */
-    noffH.noffMagic = NOFFMAGIC;
+    noffH.noffMagic = aligned ? (NOFFMAGIC | NOFFALIGNED) : NOFFMAGIC;
     noffH.code.size = 0;
     noffH.initData.size = 0;
     noffH.uninitData.size = 0;
@@ -232,6 +257,7 @@ int main(int argc, char **argv)
 		/* do nothing! */	
 	} else if (!strcmp(sections[i].s_name, ".text")) {
 	    noffH.code.virtualAddr = sections[i].s_paddr;
+	    inNoffFile = AlignSegment(fdOut, inNoffFile, sections[i].s_paddr);
 	    noffH.code.inFileAddr = inNoffFile;
 	    noffH.code.size = sections[i].s_size;
     	    lseek(fdIn, sections[i].s_scnptr, 0);
@@ -243,6 +269,7 @@ int main(int argc, char **argv)
  	} else if (!strcmp(sections[i].s_name, ".data")){
 
 	    noffH.initData.virtualAddr = sections[i].s_paddr;
+	    inNoffFile = AlignSegment(fdOut, inNoffFile, sections[i].s_paddr);
 	    noffH.initData.inFileAddr = inNoffFile;
 	    noffH.initData.size = sections[i].s_size;
 	    lseek(fdIn, sections[i].s_scnptr, 0);
@@ -255,6 +282,7 @@ int main(int argc, char **argv)
 	} else if (!strcmp(sections[i].s_name, ".rdata")){
 
 	    noffH.readonlyData.virtualAddr = sections[i].s_paddr;
+	    inNoffFile = AlignSegment(fdOut, inNoffFile, sections[i].s_paddr);
 	    noffH.readonlyData.inFileAddr = inNoffFile;
 	    noffH.readonlyData.size = sections[i].s_size;
 	    lseek(fdIn, sections[i].s_scnptr, 0);